@@ -159,8 +159,8 @@ else
 			fullcommand=${fullcommand/INST/$instance}
 			cmd="timeout $to time -o $timefile -f %e $fullcommand"
 
-			# run racer
-			racerpath=$(which RacerPro)
+			# run racer, or the command in RACER (e.g. testsuite/RacerMock.py)
+			racerpath=${RACER:-$(which RacerPro)}
 			if [[ $racerpath == "" ]]; then
 				echo "RacerPro could not be found"
 				exit 1
@@ -187,12 +187,12 @@ else
 			else
 				echo "Output builder for command \"$fullcommand\" failed" >&2
 				# kill racer and exit
-				pkill $rpid
+				kill $rpid
 				exit 1
 			fi
 
 			# kill racer
-			pkill -9 $rpid
+			kill -9 $rpid
 
 			let i=i+1
 		done
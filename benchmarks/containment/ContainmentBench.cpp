@@ -0,0 +1,289 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   ContainmentBench.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 16:20:47 2026
+ *
+ * @brief  Microbenchmark for the interpretation comparisons of the dl-cache.
+ *
+ * Compares cache lookups of a query interpretation against N cached
+ * interpretations of a dl-query
+ *
+ *  - by the old linear scan over sets of atom strings (std::includes
+ *    and two set differences, like Cache did on ComfortInterpretation),
+ *  - and by SetTrie lookups of the elements of AtomBitsets, like Cache
+ *    does now.
+ */
+
+
+#include "AtomBitset.h"
+#include "SetTrie.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace dlvhex::dl;
+
+
+namespace {
+
+  typedef std::set<std::string> StringSet;
+
+  /// @return the CPU time in milliseconds
+  double
+  ms()
+  {
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+  }
+
+  /// the atom string of @a id
+  std::string
+  atom(unsigned id)
+  {
+    std::ostringstream oss;
+    oss << "pc(\"http://www.example.org/shop#Part\",\"http://www.example.org/shop#i" << id << "\")";
+    return oss.str();
+  }
+
+  /// a random interpretation of @a n out of @a atoms IDs
+  std::vector<unsigned>
+  random(unsigned n, unsigned atoms)
+  {
+    std::set<unsigned> s;
+
+    while (s.size() < n)
+      {
+	s.insert(std::rand() % atoms);
+      }
+
+    return std::vector<unsigned>(s.begin(), s.end());
+  }
+
+  void
+  report(const char* what, double t, unsigned hits, unsigned queries)
+  {
+    std::printf("%-28s %10.3f us/lookup %8u hits\n", what, t * 1000.0 / queries, hits);
+  }
+
+} // anonymous namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  unsigned entries = argc > 1 ? std::atoi(argv[1]) : 2000; // cached interpretations
+  unsigned atoms   = argc > 2 ? std::atoi(argv[2]) : 512;  // atoms of the projection
+  unsigned size    = argc > 3 ? std::atoi(argv[3]) : 24;   // atoms per interpretation
+  unsigned queries = argc > 4 ? std::atoi(argv[4]) : 2000;
+
+  std::srand(42);
+
+  std::vector<StringSet> strings;
+  std::vector<std::vector<unsigned> > keys;
+  SetTrie<unsigned> trie;
+
+  for (unsigned i = 0; i < entries; ++i)
+    {
+      std::vector<unsigned> ids = random(size / 2 + std::rand() % size, atoms);
+
+      StringSet s;
+      AtomBitset b;
+
+      for (std::vector<unsigned>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+	{
+	  s.insert(atom(*it));
+	  b.set(*it);
+	}
+
+      b.elements(ids);
+      strings.push_back(s);
+      keys.push_back(ids);
+      trie.insert(ids, i);
+    }
+
+  // a quarter of the queries each is random, extends, shrinks, or
+  // equals a cached interpretation
+  std::vector<StringSet> qstrings;
+  std::vector<std::vector<unsigned> > qkeys;
+
+  for (unsigned i = 0; i < queries; ++i)
+    {
+      std::vector<unsigned> ids = random(size, atoms);
+
+      if (i % 4)
+	{
+	  ids = keys[std::rand() % entries];
+	}
+
+      if (i % 4 == 1)
+	{
+	  ids.push_back(atoms + i); // a fresh atom
+	}
+      else if (i % 4 == 2)
+	{
+	  ids.pop_back();
+	}
+
+      StringSet s;
+      AtomBitset b;
+
+      for (std::vector<unsigned>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+	{
+	  s.insert(atom(*it));
+	  b.set(*it);
+	}
+
+      qstrings.push_back(s);
+      b.elements(ids);
+      qkeys.push_back(ids);
+    }
+
+  std::printf("%u cached interpretations of %u atoms, %u atoms per query\n\n", entries, atoms, size);
+
+  //
+  // subset lookups, i.e., positive boolean queries
+  //
+
+  unsigned hits = 0;
+  double t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      for (unsigned e = 0; e < entries; ++e)
+	{
+	  if (std::includes(qstrings[q].begin(), qstrings[q].end(),
+			    strings[e].begin(), strings[e].end()))
+	    {
+	      ++hits;
+	      break;
+	    }
+	}
+    }
+
+  report("subset: strings", ms() - t, hits, queries);
+
+  hits = 0;
+  t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      if (trie.findSubset(qkeys[q]))
+	{
+	  ++hits;
+	}
+    }
+
+  report("subset: set-trie", ms() - t, hits, queries);
+
+  //
+  // superset lookups, i.e., negative boolean queries
+  //
+
+  hits = 0;
+  t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      for (unsigned e = 0; e < entries; ++e)
+	{
+	  if (std::includes(strings[e].begin(), strings[e].end(),
+			    qstrings[q].begin(), qstrings[q].end()))
+	    {
+	      ++hits;
+	      break;
+	    }
+	}
+    }
+
+  report("superset: strings", ms() - t, hits, queries);
+
+  hits = 0;
+  t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      if (trie.findSuperset(qkeys[q]))
+	{
+	  ++hits;
+	}
+    }
+
+  report("superset: set-trie", ms() - t, hits, queries);
+
+  //
+  // equality lookups, i.e., retrieval queries
+  //
+
+  hits = 0;
+  t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      for (unsigned e = 0; e < entries; ++e)
+	{
+	  StringSet d1, d2;
+	  std::set_difference(qstrings[q].begin(), qstrings[q].end(),
+			      strings[e].begin(), strings[e].end(),
+			      std::inserter(d1, d1.begin()));
+	  std::set_difference(strings[e].begin(), strings[e].end(),
+			      qstrings[q].begin(), qstrings[q].end(),
+			      std::inserter(d2, d2.begin()));
+
+	  if (d1.empty() && d2.empty())
+	    {
+	      ++hits;
+	      break;
+	    }
+	}
+    }
+
+  report("equal: string differences", ms() - t, hits, queries);
+
+  hits = 0;
+  t = ms();
+
+  for (unsigned q = 0; q < queries; ++q)
+    {
+      if (trie.find(qkeys[q]))
+	{
+	  ++hits;
+	}
+    }
+
+  report("equal: set-trie", ms() - t, hits, queries);
+
+  return 0;
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
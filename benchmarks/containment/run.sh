@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Microbenchmark of the interpretation comparisons of the dl-cache.
+#
+# Usage: run.sh [ENTRIES [ATOMS [SIZE [QUERIES]]]]
+#
+# Builds ContainmentBench and runs it. Set CXX and CXXFLAGS to change
+# the compiler; the benchmark needs dlvhex2 (pkg-config dlvhex2).
+
+mydir=$(cd $(dirname $0) && pwd)
+top=$mydir/../..
+cxx=${CXX:-g++}
+flags="${CXXFLAGS:--O2} -I$top/include $(pkg-config --cflags dlvhex2 2>/dev/null)"
+libs="$(pkg-config --libs dlvhex2 2>/dev/null)"
+
+bin=$(mktemp)
+if $cxx $flags -o $bin $mydir/ContainmentBench.cpp $top/src/AtomBitset.cpp $libs; then
+	$bin "$@"
+else
+	echo "cannot build ContainmentBench with $cxx" >&2
+	rm -f $bin
+	exit 1
+fi
+rm -f $bin
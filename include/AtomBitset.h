@@ -0,0 +1,156 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   AtomBitset.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 14:02:11 2026
+ *
+ * @brief  Interpretations as bitsets of interned atoms.
+ *
+ *
+ */
+
+
+#ifndef _ATOMBITSET_H
+#define _ATOMBITSET_H
+
+#include "SymbolTable.h"
+
+#include <map>
+#include <vector>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief A set of atom IDs stored as bitset.
+   *
+   * The IDs are handed out densely by AtomTable, so an interpretation
+   * takes one bit per atom seen so far. The cache indexes the
+   * elements() of a set in a SetTrie.
+   */
+  class AtomBitset
+  {
+  private:
+    typedef unsigned long word_type;
+
+    /// number of bits in a word
+    static const unsigned bits = sizeof(word_type) * 8;
+
+    /// the bitset, never ends with a zero word
+    std::vector<word_type> words;
+
+  public:
+    /// Ctor, creates the empty set.
+    AtomBitset()
+      : words()
+    { }
+
+    /// add @a id to this set
+    void
+    set(unsigned id);
+
+    /// @return true if @a id is in this set
+    bool
+    test(unsigned id) const;
+
+    /// @return the number of IDs in this set
+    std::size_t
+    count() const;
+
+    /**
+     * @param ids gets the IDs of this set in ascending order
+     */
+    void
+    elements(std::vector<unsigned>& ids) const;
+  };
+
+
+  /**
+   * @brief Interns atoms into dense IDs.
+   *
+   * An atom is keyed by its SymbolTable::AtomKey, which Query computes
+   * once for its projected interpretation, so the table compares
+   * integers and never touches the SymbolTable.
+   */
+  class AtomTable
+  {
+  private:
+    typedef SymbolTable::AtomKey AtomKey;
+
+    typedef std::map<AtomKey, unsigned> IdMap;
+
+    /// maps atoms to their IDs
+    IdMap ids;
+
+  public:
+    /// Ctor
+    AtomTable()
+      : ids()
+    { }
+
+    /**
+     * @param k
+     *
+     * @return the ID of the atom keyed by @a k, a fresh one if we haven't seen it yet
+     */
+    unsigned
+    intern(const AtomKey& k);
+
+    /**
+     * Interns all atoms of an interpretation.
+     *
+     * @param keys the keys of the atoms, see SymbolTable::intern()
+     * @param b gets the IDs of the atoms
+     */
+    void
+    intern(const std::vector<AtomKey>& keys, AtomBitset& b);
+
+    /**
+     * Looks up the atoms of an interpretation without interning new ones.
+     *
+     * @param keys the keys of the atoms, see SymbolTable::intern()
+     * @param b gets the IDs of the known atoms
+     *
+     * @return false if some atoms were never interned
+     */
+    bool
+    lookup(const std::vector<AtomKey>& keys, AtomBitset& b) const;
+
+    /// @return the number of interned atoms
+    std::size_t
+    size() const
+    {
+      return ids.size();
+    }
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _ATOMBITSET_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
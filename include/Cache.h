@@ -35,13 +35,19 @@
 #define _CACHE_H
 
 #include "QueryCtx.h"
+#include "AtomBitset.h"
+#include "CacheStore.h"
+#include "SetTrie.h"
 
 #include <dlvhex2/ComfortPluginInterface.h>
 
+#include <map>
 #include <set>
+#include <vector>
 #include <iosfwd>
 
 #include <boost/ptr_container/indirect_fun.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace dlvhex {
 namespace dl {
@@ -55,11 +61,13 @@ namespace dl {
     unsigned m_miss;
     unsigned m_dlqno;
     unsigned m_qctxno;
+    unsigned m_evict;
+    unsigned long m_bytes;
 
   public:
     /// default ctor
     CacheStats()
-      : m_hits(0), m_miss(0), m_dlqno(0), m_qctxno(0)
+      : m_hits(0), m_miss(0), m_dlqno(0), m_qctxno(0), m_evict(0), m_bytes(0)
     { }
 
     unsigned
@@ -94,6 +102,22 @@ namespace dl {
     qctxno(int n)
     { this->m_qctxno += n; }
 
+    unsigned
+    evict() const
+    { return this->m_evict; }
+
+    void
+    evict(int n)
+    { this->m_evict += n; }
+
+    unsigned long
+    bytes() const
+    { return this->m_bytes; }
+
+    void
+    bytes(long n)
+    { this->m_bytes += n; }
+
   };
 
   /** 
@@ -110,12 +134,60 @@ namespace dl {
     return os << "Cache hits: " << cs.hits() << std::endl
 	      << "Cache miss: " << cs.miss() << std::endl
 	      << "Number of cached dl-queries: " << cs.dlqno() << std::endl
-	      << "Total number of cache queries: " << cs.qctxno() << std::endl;
+	      << "Total number of cache queries: " << cs.qctxno() << std::endl
+	      << "Evicted cache queries: " << cs.evict() << std::endl
+	      << "Estimated cache size in bytes: " << cs.bytes() << std::endl;
   }
 
 
+  /**
+   * @brief Estimates how often a key was seen recently.
+   *
+   * A count-min sketch with small saturating counters, which are
+   * halved after a while so that old popularity fades.
+   *
+   * @see Gil Einziger, Roy Friedman, and Ben Manes. TinyLFU: A Highly
+   * Efficient Cache Admission Policy. ACM Transactions on Storage,
+   * 13(4), 2017.
+   */
+  class FrequencySketch
+  {
+  private:
+    /// number of hash functions
+    static const unsigned depth = 4;
+    /// number of counters per hash function
+    static const unsigned width = 4096;
+
+    /// depth rows of width counters
+    std::vector<unsigned char> counters;
+    /// number of additions since the last halving
+    unsigned long additions;
+
+    /// @return the index of @a key in row @a row
+    static std::size_t
+    index(unsigned row, std::size_t key);
+
+  public:
+    /// Ctor
+    FrequencySketch()
+      : counters(depth * width, 0), additions(0)
+    { }
+
+    /// count @a key once more
+    void
+    add(std::size_t key);
+
+    /// @return how often @a key was added, maybe more
+    unsigned
+    estimate(std::size_t key) const;
+  };
+
+
   /**
    * @brief Base class for caching classes.
+   *
+   * The dl-atoms share one cache and may be evaluated concurrently,
+   * hence all member functions must be thread-safe.
    */
   class BaseCache
   {
@@ -145,13 +217,119 @@ namespace dl {
     virtual QueryCtx::shared_pointer
     cacheHit(const QueryCtx::shared_pointer& query) const = 0;
 
+    /**
+     * checks if there is a cached entry for @a query without
+     * counting a cache hit or miss. Unlike cacheHit(), it leaves the
+     * Answer of @a query alone.
+     *
+     * @param query
+     *
+     * @return true if cacheHit() would find an entry, false otherwise.
+     */
+    virtual bool
+    contains(const QueryCtx::shared_pointer& /* query */) const
+    {
+      return false;
+    }
+
+    /**
+     * Bounds the answer of the retrieval query @a query by the
+     * cached answers for other interpretations. A dl-atom is
+     * monotonic in its input, hence an answer for a subset of the
+     * interpretation of @a query is a lower bound, and an answer for
+     * a superset is an upper bound.
+     *
+     * @param query
+     * @param lower gets the tuples which are answers of @a query
+     * @param upper gets the tuples which may be answers of @a query
+     *
+     * @return true if there is an upper bound, false otherwise.
+     */
+    virtual bool
+    bounds(const QueryCtx::shared_pointer& /* query */,
+	   std::set<ComfortTuple>& /* lower */,
+	   std::set<ComfortTuple>& /* upper */) const
+    {
+      return false;
+    }
+
+    /**
+     * Checks whether the ABox of the ontology of @a query, extended
+     * by the interpretation of @a query, is known to be consistent.
+     * Removing assertions keeps an ABox consistent, adding assertions
+     * keeps it inconsistent.
+     *
+     * @param query
+     * @param consistent gets the consistency of @a query
+     *
+     * @return true if the consistency of @a query is known
+     */
+    virtual bool
+    consistency(const QueryCtx::shared_pointer& /* query */, bool& /* consistent */) const
+    {
+      return false;
+    }
+
+    /**
+     * Counts the boolean or mixed query @a query, which was not
+     * answered from the cache, towards a burst of queries which differ
+     * only in their individuals.
+     *
+     * @param query
+     *
+     * @return the retrieval dl-query which answers the whole burst if
+     * it is cheaper to ask it now than to keep on asking single
+     * queries, an empty DLQuery::shared_pointer otherwise.
+     */
+    virtual DLQuery::shared_pointer
+    promote(const QueryCtx::shared_pointer& /* query */)
+    {
+      return DLQuery::shared_pointer();
+    }
+
+    /**
+     * Records the consistency of the ABox of @a query.
+     *
+     * @param query
+     * @param consistent
+     */
+    virtual void
+    insertConsistency(const QueryCtx::shared_pointer& /* query */, bool /* consistent */)
+    { }
+
     /** 
      * insert @a query into the cache.
      * 
      * @param query 
+     * @param cost microseconds it took to answer @a query, 0 if unknown
+     */
+    virtual void
+    insert(const QueryCtx::shared_pointer& query, unsigned long cost = 0) = 0;
+
+    /**
+     * Limits the memory of the cached queries.
+     *
+     * @param bytes the budget, 0 for no limit
+     */
+    virtual void
+    setBudget(std::size_t /* bytes */)
+    { }
+
+    /**
+     * @param admit if true, queries which are less popular than the
+     * ones they would evict are not cached
+     */
+    virtual void
+    setAdmission(bool /* admit */)
+    { }
+
+    /**
+     * @param store keeps the cached answers across runs, 0 for
+     * none. The cache does not take ownership of @a store.
      */
     virtual void
-    insert(const QueryCtx::shared_pointer& query) = 0;
+    setStore(CacheStore* /* store */)
+    { }
   };
 
 
@@ -168,52 +346,325 @@ namespace dl {
   class Cache : public BaseCache
   {
   protected:
-    /// @brief we order the QueryCtx'en in the CacheSet accourding to
-    /// their interpretations
-    struct IntCmp
+    /// indexes QueryCtx::shared_pointer by their interned interpretations
+    typedef SetTrie<QueryCtx::shared_pointer> CacheSet;
+
+    /// @brief the QueryCtx'en of a dl-query
+    struct CacheEntry
     {
+      /// boolean queries with positive answer, only minimal interpretations
+      CacheSet positive;
+      /// boolean queries with negative answer, only maximal interpretations
+      CacheSet negative;
+      /// retrieval queries
+      CacheSet retrieval;
+      /// the boolean dl-queries which ask for a single tuple of this
+      /// retrieval dl-query, by the tuple in the form of RACER answers
+      std::map<ComfortTuple, DLQuery::shared_pointer> instances;
+
+      /// @return true if the entry holds nothing
       bool
-      operator() (const QueryCtx::shared_pointer& q1,
-		  const QueryCtx::shared_pointer& q2) const
+      empty() const
       {
-	const ComfortInterpretation& a1 = q1->getQuery().getProjectedInterpretation();
-	const ComfortInterpretation& a2 = q2->getQuery().getProjectedInterpretation();
-
-	// we don't have to consider the Query component, since all
-	// members in a CacheSet have the same DLQuery
-	return a1 < a2;
+	return positive.size() == 0 && negative.size() == 0
+	  && retrieval.size() == 0 && instances.empty();
       }
     };
 
-    /// caches QueryCtx::shared_pointer with help of a std::set
-    typedef std::set<QueryCtx::shared_pointer,IntCmp> CacheSet;
-
-    /// maps dl-queries to sets of QueryCtxen
-    typedef std::map<DLQuery::shared_pointer, CacheSet,
+    /// maps dl-queries to their QueryCtxen
+    typedef std::map<DLQuery::shared_pointer, CacheEntry*,
 		     boost::indirect_fun<std::less<DLQuery> > > QueryAnswerMap;
 
+    /// indexes interned interpretations
+    typedef SetTrie<bool> ConsistencySet;
+
+    /// @brief the known consistency of the ABox of an ontology
+    struct ConsistencyEntry
+    {
+      /// consistent interpretations, only maximal ones
+      ConsistencySet consistent;
+      /// inconsistent interpretations, only minimal ones
+      ConsistencySet inconsistent;
+    };
+
+    /// maps the real URIs of ontologies to their ConsistencyEntry
+    typedef std::map<std::string, ConsistencyEntry*> ConsistencyMap;
+
+    /// @brief the boolean queries of a retrieval dl-query asked so far
+    struct Burst
+    {
+      /// number of uncached queries by their interned interpretation
+      std::map<CacheSet::Key, unsigned> count;
+      /// average microseconds of a boolean query, 0 if unknown
+      double booleanCost;
+      /// average microseconds of the retrieval query, 0 if unknown
+      double retrievalCost;
+
+      Burst()
+	: count(), booleanCost(0), retrievalCost(0)
+      { }
+
+      /// @return the number of queries after which we retrieve
+      unsigned
+      threshold() const;
+    };
+
+    /// maps retrieval dl-queries to their bursts
+    typedef std::map<DLQuery::shared_pointer, Burst,
+		     boost::indirect_fun<std::less<DLQuery> > > BurstMap;
+
+    /// @brief the bookkeeping of a cached QueryCtx
+    struct Meta
+    {
+      /// the dl-query of the CacheEntry
+      DLQuery::shared_pointer dlq;
+      /// the CacheSet which holds the QueryCtx
+      CacheSet* set;
+      /// the interned interpretation of the QueryCtx
+      CacheSet::Key key;
+      /// estimated size in bytes
+      std::size_t bytes;
+      /// microseconds it took to answer the QueryCtx
+      double cost;
+      /// number of cache hits plus one
+      unsigned long freq;
+      /// GDSF priority, the lowest one is evicted first
+      double priority;
+      /// the key in the FrequencySketch
+      std::size_t hash;
+    };
+
+    typedef std::map<const QueryCtx*, Meta> MetaMap;
+
+    /// the cached QueryCtx'en ordered by their priority
+    typedef std::set<std::pair<double, const QueryCtx*> > PriorityQueue;
+
     /// the cache
     QueryAnswerMap cacheMap;
 
-    virtual const CacheSet*
+    /// the consistency cache
+    ConsistencyMap consistencyMap;
+
+    /// the bursts of boolean queries
+    BurstMap bursts;
+
+    /// interns the atoms of the cached interpretations
+    AtomTable atoms;
+
+    /// bookkeeping of all cached QueryCtx'en
+    mutable MetaMap meta;
+
+    /// eviction order
+    mutable PriorityQueue queue;
+
+    /// popularity of the recently asked queries
+    mutable FrequencySketch sketch;
+
+    /// memory budget in bytes, 0 means no limit
+    std::size_t budget;
+
+    /// estimated number of bytes of the cached QueryCtx'en and #aside
+    std::size_t used;
+
+    /// estimated number of bytes of the instances, the bursts, and
+    /// the consistency cache
+    std::size_t aside;
+
+    /// GDSF inflation value, i.e., the priority of the last eviction
+    double inflation;
+
+    /// filter queries by popularity before caching them
+    bool admission;
+
+    /// the persistent answers of earlier runs, may be 0
+    CacheStore* store;
+
+    /// serializes the public member functions
+    mutable boost::mutex mutex;
+
+    /**
+     * @param q
+     *
+     * @return true if the answer of @a q has been restored from
+     * #store into @a q
+     */
+    bool
+    restore(const QueryCtx::shared_pointer& q) const;
+
+    /// count a cache hit of @a q
+    void
+    touch(const QueryCtx::shared_pointer& q) const;
+
+    /// @return the key of @a q in #sketch
+    std::size_t
+    hash(const QueryCtx::shared_pointer& q) const;
+
+    /// drop the bookkeeping of @a q, which was removed from its CacheSet
+    void
+    forget(const QueryCtx* q);
+
+    /// count @a bytes more in #aside
+    void
+    grow(std::size_t bytes);
+
+    /// count @a bytes less in #aside
+    void
+    shrink(std::size_t bytes);
+
+    /// @return the burst of the retrieval dl-query @a rf, a new one if there is none
+    Burst&
+    burst(const DLQuery::shared_pointer& rf);
+
+    /// remove the boolean dl-query @a dlq, which has no cached QueryCtx anymore,
+    /// from the instances of its retrieval dl-query
+    void
+    dropInstance(const DLQuery::shared_pointer& dlq);
+
+    /// drop the instances, the bursts, and the consistency cache
+    void
+    prune();
+
+    /**
+     * Evict QueryCtx'en until @a bytes more bytes fit into #budget,
+     * and prune() if that is not enough.
+     */
+    void
+    evict(std::size_t bytes);
+
+    virtual const CacheEntry*
     find(const QueryCtx::shared_pointer& q) const;
 
+    /**
+     * @param q
+     * @param f the cache entry of the dl-query of @a q
+     * @param fill if false, the Answer of @a q stays untouched
+     *
+     * @return a cached QueryCtx which answers @a q, or @a q itself if
+     * the bounds of its answer coincide, which fills its Answer then.
+     */
+    virtual QueryCtx::shared_pointer
+    isValid(const QueryCtx::shared_pointer& q, const CacheEntry& f, bool fill = true) const;
+
+    /**
+     * See bounds(). Besides the retrieval queries of @a f, the
+     * answers of the boolean instances of @a f narrow the bounds.
+     *
+     * @param i the interned interpretation of a retrieval query
+     * @param known false if the interpretation has atoms which have
+     * not been interned
+     * @param f the cache entry of the retrieval query
+     * @param lower
+     * @param upper
+     *
+     * @return true if there is an upper bound, false otherwise.
+     */
+    virtual bool
+    bounds(const CacheSet::Key& i, bool known, const CacheEntry& f,
+	   std::set<ComfortTuple>& lower, std::set<ComfortTuple>& upper) const;
+
+    /**
+     * Answers the boolean or mixed query @a q by filtering the cached
+     * answer of the retrieval query which asks for all tuples of the
+     * dl-query of @a q.
+     *
+     * @param q
+     * @param fill if false, the Answer of @a q stays untouched
+     *
+     * @return @a q with its Answer filled, or an empty
+     * QueryCtx::shared_pointer if there is no such answer
+     */
     virtual QueryCtx::shared_pointer
-    isValid(const QueryCtx::shared_pointer& q, const CacheSet& f) const;
+    fromRetrieval(const QueryCtx::shared_pointer& q, bool fill = true) const;
+
+    /// private copy ctor
+    Cache(const Cache&);
+
+    /// private assignment op
+    Cache&
+    operator= (const Cache&);
 
   public:
     /// ctor
     explicit
     Cache(CacheStats& s)
       : BaseCache(s),
-	cacheMap()
+	cacheMap(),
+	consistencyMap(),
+	bursts(),
+	atoms(),
+	meta(),
+	queue(),
+	sketch(),
+	budget(0),
+	used(0),
+	aside(0),
+	inflation(0),
+	admission(true),
+	store(0),
+	mutex()
     { }
 
+    /// Dtor
+    virtual
+    ~Cache();
+
     virtual QueryCtx::shared_pointer
     cacheHit(const QueryCtx::shared_pointer& query) const;
 
+    virtual bool
+    contains(const QueryCtx::shared_pointer& query) const;
+
+    virtual bool
+    bounds(const QueryCtx::shared_pointer& query,
+	   std::set<ComfortTuple>& lower,
+	   std::set<ComfortTuple>& upper) const;
+
+    /**
+     * Inserts @a query and evicts the cached QueryCtx'en with the
+     * lowest GDSF priority, i.e., frequency times cost per byte, if
+     * the cache exceeds its budget. If admission is on, @a query is
+     * dropped instead if it was asked less often than the first
+     * QueryCtx to evict.
+     *
+     * @param query
+     * @param cost
+     */
+    virtual void
+    insert(const QueryCtx::shared_pointer& query, unsigned long cost = 0);
+
+    virtual bool
+    consistency(const QueryCtx::shared_pointer& query, bool& consistent) const;
+
+    /**
+     * Keeps the minimal inconsistent and the maximal consistent
+     * interpretations of the ontology of @a query.
+     *
+     * @param query
+     * @param consistent
+     */
+    virtual void
+    insertConsistency(const QueryCtx::shared_pointer& query, bool consistent);
+
+    /**
+     * Promotes a burst once the boolean queries asked with the same
+     * interpretation have cost as much as the retrieval query is
+     * expected to cost, which is at most twice the optimal cost.
+     *
+     * @param query
+     *
+     * @return the retrieval dl-query or an empty DLQuery::shared_pointer
+     */
+    virtual DLQuery::shared_pointer
+    promote(const QueryCtx::shared_pointer& query);
+
+    virtual void
+    setBudget(std::size_t bytes);
+
+    virtual void
+    setAdmission(bool admit);
+
     virtual void
-    insert(const QueryCtx::shared_pointer& query);
+    setStore(CacheStore* s);
   };
 
 
@@ -257,7 +708,7 @@ namespace dl {
      * noop.
      */
     void
-    insert(const QueryCtx::shared_pointer& /* query */)
+    insert(const QueryCtx::shared_pointer& /* query */, unsigned long /* cost */ = 0)
     { }
   };
 
@@ -0,0 +1,194 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   CacheStore.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 18:40:12 2026
+ *
+ * @brief  A persistent store of answered dl-queries.
+ *
+ *
+ */
+
+
+#ifndef _CACHESTORE_H
+#define _CACHESTORE_H
+
+#include "QueryCtx.h"
+#include "DLError.h"
+
+#include <map>
+#include <list>
+#include <string>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief Keeps the answers of dl-queries in a file, so that later
+   * runs do not need to ask the DL-reasoner again.
+   *
+   * The file starts with a version line, followed by records
+   *
+   *   KLEN VLEN\\n KEY VALUE\\n
+   *
+   * where KEY consists of the URI of the ontology, the hash of its
+   * content, the reasoner flags, the canonical form of the dl-query,
+   * and the projected interpretation, and VALUE is the answer. The
+   * file is mapped into memory when the store opens, and only the
+   * answers which are asked for are decoded. New records are appended
+   * right away, so a crash loses nothing.
+   *
+   * The first time an ontology is used, the records for other
+   * contents of its document are dropped, and the file is compacted
+   * when the store closes.
+   *
+   * Concurrent runs may share the file. Appends hold a shared
+   * flock(2), while cutting off a torn record and compacting hold an
+   * exclusive one. A run only compacts if no other run appended since
+   * it loaded the file.
+   */
+  class CacheStore
+  {
+  private:
+    /// an encoded answer
+    struct Record
+    {
+      const char* data;
+      std::size_t size;
+    };
+
+    /// maps keys to their answers
+    typedef std::map<std::string, Record> RecordMap;
+
+    /// maps ontology URIs to the content hash of their document
+    typedef std::map<std::string, std::string> VersionMap;
+
+    /// the name of the file
+    std::string file;
+    /// the file descriptor we append to
+    int fd;
+    /// the mapped file
+    void* base;
+    /// the length of the mapping
+    std::size_t length;
+    /// the size of #file if only this run appended to it, npos otherwise
+    std::size_t known;
+    /// the records of the file and of this run
+    RecordMap records;
+    /// the values appended in this run, in a list so they don't move
+    std::list<std::string> appended;
+    /// the ontologies whose records have been checked
+    VersionMap versions;
+    /// true if records have been invalidated
+    bool stale;
+
+    /**
+     * Locks #file with the flock(2) operation @a op. If another run
+     * replaced #file in the meantime, #fd is reopened on the new file.
+     *
+     * @param op LOCK_SH or LOCK_EX
+     *
+     * @return false if #fd has been reopened
+     */
+    bool
+    lock(int op) throw (DLError);
+
+    /// reads the records of #file
+    void
+    load() throw (DLError);
+
+    /// rewrites #file with the valid records only
+    void
+    compact() throw (DLError);
+
+    /**
+     * Drops the records of the ontology of @a query if they were
+     * computed for a different content of its document.
+     *
+     * @param query
+     *
+     * @return the key of @a query
+     */
+    std::string
+    validate(const QueryCtx& query);
+
+    /// private copy ctor
+    CacheStore(const CacheStore&);
+
+    /// private assignment op
+    CacheStore&
+    operator= (const CacheStore&);
+
+  public:
+    /**
+     * Opens or creates @a file. A file of another version is
+     * replaced.
+     *
+     * @param file
+     */
+    explicit
+    CacheStore(const std::string& file) throw (DLError);
+
+    /// Dtor, compacts the file if needed.
+    ~CacheStore();
+
+    /**
+     * @param query
+     *
+     * @return true if the answer of @a query was found, it has been
+     * filled into the Answer of @a query then.
+     */
+    bool
+    lookup(const QueryCtx& query);
+
+    /// @return true if the answer of @a query is known
+    bool
+    contains(const QueryCtx& query);
+
+    /**
+     * Appends the answer of @a query unless it is known already or
+     * erroneous.
+     *
+     * @param query
+     */
+    void
+    store(const QueryCtx& query) throw (DLError);
+
+    /// @return the number of records
+    std::size_t
+    size() const
+    {
+      return records.size();
+    }
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _CACHESTORE_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
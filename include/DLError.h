@@ -76,6 +76,19 @@ namespace dl {
     { }
   };
 
+
+  /**
+   * @brief Exception thrown when the DL-reasoner misses a deadline.
+   */
+  class DLTimeoutError : public DLError
+  {
+  public:
+    explicit
+    DLTimeoutError(const std::string& arg)
+      : DLError(arg)
+    { }
+  };
+
 } // namespace dl
 } // namespace dlvhex
 
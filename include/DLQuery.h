@@ -40,6 +40,8 @@
 
 #include <iosfwd>
 #include <iterator>
+#include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
@@ -75,10 +77,36 @@ namespace dl {
     /// bitvector for quickly comparing the pattern tuple
     unsigned long typeFlags;
 
+    /// query asks for datatype fillers
+    bool datatype;
+
+    /// canonical form, see canonicalize()
+    std::string canonical;
+
     /// setup #typeFlags and #pattern
     void
     setPatternTuple(const ComfortTuple& pattern);
 
+    /**
+     * Computes #canonical, a string representation of this query
+     * which is equal for equivalent queries, i.e.,
+     *
+     *  - each query is a union of conjunctions, plain queries have a
+     *    single atom,
+     *  - all names get the namespace of the ontology,
+     *  - the variables of the pattern tuple are renamed in the order
+     *    of their first occurrence, then the other variables in the
+     *    order of their first occurrence in the sorted atoms,
+     *  - atoms and conjunctions are sorted, and
+     *  - plain retrieval queries with distinct variables are equal to
+     *    the corresponding single atom conjunctive query.
+     *
+     * Since the answer tuples follow the pattern tuple, equal
+     * canonical forms yield equal answers.
+     */
+    void
+    canonicalize();
+
   public:
     /** 
      * Ctor for a plain dl-query.
@@ -145,6 +173,18 @@ namespace dl {
     virtual bool
     isUnionConjQuery() const;
 
+    /// @return true if this query asks for datatype role fillers
+    virtual bool
+    isDatatype() const;
+
+    /// mark this query as datatype role query
+    virtual void
+    setDatatype();
+
+    /// @return the canonical form of this query
+    virtual const std::string&
+    getCanonical() const;
+
     friend std::ostream&
     operator<< (std::ostream& os, const DLQuery& q);
 
@@ -234,8 +274,8 @@ namespace dl {
   }
 
   /**
-   * @brief lexicographically compare @a q1 to @a q2 and check if @a
-   * q1 is less than @a q2.
+   * @brief compare the ontologies and then the canonical forms of @a
+   * q1 and @a q2 and check if @a q1 is less than @a q2.
    *
    * @param q1
    * @param q2
@@ -245,8 +285,8 @@ namespace dl {
   operator< (const DLQuery& q1, const DLQuery& q2);
 
   /**
-   * @brief lexicographically compare @a q1 to @a q2 and check if both
-   * dl-queries are equal.
+   * @brief check if @a q1 and @a q2 have the same ontology and the
+   * same canonical form.
    *
    * @param q1
    * @param q2
@@ -255,21 +295,8 @@ namespace dl {
   inline bool
   operator== (const DLQuery& q1, const DLQuery& q2)
   {
-    ///@todo right now, we only support plain queries
-    assert(!q1.isConjQuery() && !q1.isUnionConjQuery());
-
-    if (q1.isConjQuery() == q2.isConjQuery() &&
-	q1.isUnionConjQuery() == q2.isUnionConjQuery() &&
-	*q1.getOntology() == *q2.getOntology()
-	)
-      {
-	return q1.isConjQuery() ?
-	  q1.getConjQuery() == q2.getConjQuery() :
-	  (q2.isUnionConjQuery() ? q1.getUnionConjQuery() == q2.getUnionConjQuery() :
-	   q1.getQuery() == q2.getQuery());
-      }
-
-    return false;
+    return *q1.getOntology() == *q2.getOntology()
+      && q1.getCanonical() == q2.getCanonical();
   }
 
   /**
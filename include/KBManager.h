@@ -35,8 +35,14 @@
 
 #include <string>
 #include <set>
+#include <map>
+#include <list>
+#include <sstream>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <dlvhex2/ComfortPluginInterface.h>
 
 #include "DLError.h"
 
@@ -53,11 +59,81 @@ namespace dl {
   public:
     typedef std::set<std::string> KBSet;
 
+    /// maps open KBs to the fingerprint of their source document
+    typedef std::map<std::string, std::string> FingerprintMap;
+
+    /// a temporary ABox in the DL-reasoner
+    struct WorkingABox
+    {
+      /// name of the ABox
+      std::string name;
+      /// the open KB whose ABox has been cloned into #name, empty
+      /// if the ABox is not usable
+      std::string source;
+      /// fingerprint of #source and #ints
+      std::size_t key;
+      /// the assertions which have been added to the clone
+      ComfortInterpretation ints;
+    };
+
+    /// working ABoxes, the most recently used one first
+    typedef std::list<WorkingABox> ABoxPool;
+
+    /// state flags of a DL-reasoner session
+    enum
+      {
+	SESSION = 0x1,      ///< DL-reasoner has been reset
+	UNA = 0x2,          ///< unique name assumption is turned on
+	DATASUBSTRATE = 0x4 ///< data substrate mirroring is enabled
+      };
+
   protected:
     /// a KB name
     std::string kbName;
     /// a list of open KBs
     KBSet openKBs;
+    /// fingerprints of the documents loaded into #openKBs
+    FingerprintMap fingerprints;
+    /// current session flags
+    unsigned session;
+    /// the working ABoxes, the current one is in front
+    ABoxPool aboxes;
+    /// upper bound for the size of #aboxes
+    unsigned maxABoxes;
+
+    /** 
+     * @param source an open KB
+     * @param ints an interpretation
+     * @return the fingerprint of @a source and @a ints
+     */
+    static std::size_t
+    fingerprint(const std::string& source, const ComfortInterpretation& ints)
+    {
+      std::ostringstream oss;
+      oss << source;
+
+      for (ComfortInterpretation::const_iterator it = ints.begin(); it != ints.end(); ++it)
+	{
+	  oss << ' ' << *it;
+	}
+
+      return boost::hash<std::string>()(oss.str());
+    }
+
+    /// mark all working ABoxes cloned from @a source as unusable,
+    /// or all of them if @a source is empty
+    void
+    dropWorkingABoxes(const std::string& source)
+    {
+      for (ABoxPool::iterator it = aboxes.begin(); it != aboxes.end(); ++it)
+	{
+	  if (source.empty() || it->source == source)
+	    {
+	      it->source.clear();
+	      it->ints.clear();
+	    }
+	}
+    }
     
   public:
     /** 
@@ -68,7 +144,8 @@ namespace dl {
      */
     explicit
     KBManager(const std::string& name, const KBSet& kbs = KBSet())
-      : kbName(name), openKBs(kbs)
+      : kbName(name), openKBs(kbs), fingerprints(), session(0),
+	aboxes(), maxABoxes(1)
     { }
 
     virtual
@@ -90,12 +167,13 @@ namespace dl {
     { }
 
     /** 
-     * @return #kbName
+     * @return the name of the current working ABox, which is #kbName
+     * unless there are several working ABoxes.
      */
     virtual const std::string&
     getKBName() const
     {
-      return kbName;
+      return aboxes.empty() ? kbName : aboxes.front().name;
     }
 
     /** 
@@ -117,6 +195,175 @@ namespace dl {
       return openKBs.find(kb) != openKBs.end();
     }
 
+    /** 
+     * @param kb check if kb is loaded.
+     * @param fingerprint fingerprint of the source document of @a kb
+     * @return true if #kb is in #openKBs and was loaded from a
+     * document with fingerprint @a fingerprint, false otw.
+     */
+    virtual bool
+    isOpenKB(const std::string& kb, const std::string& fingerprint)
+    {
+      FingerprintMap::const_iterator it = fingerprints.find(kb);
+      return isOpenKB(kb) && it != fingerprints.end() && it->second == fingerprint;
+    }
+
+    /** 
+     * Remember that @a kb has been loaded from a document with
+     * fingerprint @a fingerprint.
+     * 
+     * @param kb 
+     * @param fingerprint 
+     */
+    virtual void
+    addOpenKB(const std::string& kb, const std::string& fingerprint)
+    {
+      openKBs.insert(kb);
+      fingerprints[kb] = fingerprint;
+
+      // the working ABoxes are clones of the previous version of kb
+      dropWorkingABoxes(kb);
+    }
+
+    /** 
+     * Set the number of working ABoxes.
+     * 
+     * @param n at least one
+     */
+    virtual void
+    setMaxWorkingABoxes(unsigned n)
+    {
+      maxABoxes = n > 0 ? n : 1;
+    }
+
+    /** 
+     * Select the working ABox for a query. If there is a working
+     * ABox for @a source extended by @a ints, it becomes the current
+     * one. Otherwise, the current one is a new ABox while we have
+     * less than #maxABoxes, or the least recently used ABox.
+     * 
+     * @param source an open KB
+     * @param ints the assertions required by the query
+     * 
+     * @return true if the current working ABox is a clone of @a
+     * source extended by @a ints, false otw.
+     */
+    virtual bool
+    selectWorkingABox(const std::string& source, const ComfortInterpretation& ints)
+    {
+      const std::size_t key = fingerprint(source, ints);
+
+      for (ABoxPool::iterator it = aboxes.begin(); it != aboxes.end(); ++it)
+	{
+	  if (!it->source.empty() && it->key == key &&
+	      it->source == source && it->ints == ints)
+	    {
+	      aboxes.splice(aboxes.begin(), aboxes, it);
+	      return true;
+	    }
+	}
+
+      if (aboxes.size() < maxABoxes)
+	{
+	  std::ostringstream oss;
+	  oss << kbName;
+
+	  if (!aboxes.empty())
+	    {
+	      oss << '-' << aboxes.size();
+	    }
+
+	  aboxes.push_front(WorkingABox());
+	  aboxes.front().name = oss.str();
+	  aboxes.front().key = 0;
+	}
+      else
+	{
+	  aboxes.splice(aboxes.begin(), aboxes, --aboxes.end());
+	}
+
+      return false;
+    }
+
+    /** 
+     * @param source an open KB
+     * @return true if the current working ABox is a clone of the
+     * ABox of @a source, false otw.
+     */
+    virtual bool
+    hasWorkingABox(const std::string& source) const
+    {
+      return !aboxes.empty() && !source.empty() && aboxes.front().source == source;
+    }
+
+    /** 
+     * @return the assertions which have been added to the current
+     * working ABox.
+     */
+    virtual const ComfortInterpretation&
+    getWorkingABox() const
+    {
+      static const ComfortInterpretation none;
+      return aboxes.empty() ? none : aboxes.front().ints;
+    }
+
+    /** 
+     * Remember that the current working ABox is a clone of @a
+     * source extended by @a ints.
+     * 
+     * @param source an open KB, or the empty string if the ABox is
+     * not usable
+     * @param ints the assertions added to the clone
+     */
+    virtual void
+    setWorkingABox(const std::string& source, const ComfortInterpretation& ints)
+    {
+      if (aboxes.empty())
+	{
+	  aboxes.push_front(WorkingABox());
+	  aboxes.front().name = kbName;
+	}
+
+      WorkingABox& abox = aboxes.front();
+      abox.source = source;
+      abox.ints = ints;
+      abox.key = fingerprint(source, ints);
+    }
+
+    /** 
+     * @param flags session flags
+     * @return true if all @a flags are set in #session, false otw.
+     */
+    virtual bool
+    isSession(unsigned flags) const
+    {
+      return (session & flags) == flags;
+    }
+
+    /** 
+     * Add @a flags to #session.
+     * 
+     * @param flags session flags
+     */
+    virtual void
+    addSession(unsigned flags)
+    {
+      session |= flags;
+    }
+
+    /** 
+     * Forget the state of the DL-reasoner, i.e., clear #session,
+     * #openKBs, #fingerprints, and the working ABox. The next query
+     * has to setup the DL-reasoner from scratch.
+     */
+    virtual void
+    invalidateSession()
+    {
+      session = 0;
+      openKBs.clear();
+      fingerprints.clear();
+      dropWorkingABoxes("");
+    }
   };
 
 
@@ -165,6 +412,70 @@ namespace dl {
     {
       return false;
     }
+
+    /// @return false
+    bool
+    isOpenKB(const std::string&, const std::string&)
+    {
+      return false;
+    }
+
+    void
+    addOpenKB(const std::string& kb, const std::string& fingerprint)
+    {
+      kbMan->addOpenKB(kb, fingerprint);
+    }
+
+    void
+    setMaxWorkingABoxes(unsigned n)
+    {
+      kbMan->setMaxWorkingABoxes(n);
+    }
+
+    /// @return false, the KBs get reloaded and so the working ABoxes are stale
+    bool
+    selectWorkingABox(const std::string& source, const ComfortInterpretation& ints)
+    {
+      kbMan->selectWorkingABox(source, ints);
+      return false;
+    }
+
+    /// @return false, the KBs get reloaded and so the working ABox is stale
+    bool
+    hasWorkingABox(const std::string&) const
+    {
+      return false;
+    }
+
+    const ComfortInterpretation&
+    getWorkingABox() const
+    {
+      return kbMan->getWorkingABox();
+    }
+
+    void
+    setWorkingABox(const std::string& source, const ComfortInterpretation& ints)
+    {
+      kbMan->setWorkingABox(source, ints);
+    }
+
+    bool
+    isSession(unsigned flags) const
+    {
+      return kbMan->isSession(flags);
+    }
+
+    void
+    addSession(unsigned flags)
+    {
+      kbMan->addSession(flags);
+    }
+
+    void
+    invalidateSession()
+    {
+      kbMan->invalidateSession();
+    }
   };
 
 
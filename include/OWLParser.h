@@ -38,11 +38,14 @@
 #include "URI.h"
 
 #include <string>
+#include <vector>
 
 
 namespace dlvhex {
 namespace dl {
 
+  struct OWLDocument;
+
   /**
    * @brief Parse individuals, concepts names, role names and default
    * namespace of an OWL KB.
@@ -53,18 +56,14 @@ namespace dl {
     /// URI to the OWL KB
     URI uri;
 
-    /// helper struct for parsing concept and role names
-    struct HandlerFuns;
-
     /** 
-     * setup parser with @a userData and @a handler and parses the OWL
-     * document found at #uri.
+     * setup parser with @a doc and parses the OWL document found at
+     * #uri in a single pass.
      * 
-     * @param userData 
-     * @param handler 
+     * @param doc what to collect from the document
      */
     void
-    parse(void* userData, const HandlerFuns* handler) throw (DLParsingError);
+    parse(OWLDocument& doc) throw (DLParsingError);
 
 
   public:
@@ -78,6 +77,8 @@ namespace dl {
     static const std::string rdfsNspace;
     /// owl namespace
     static const std::string owlNspace;
+    /// owl:imports
+    static const std::string owlImports;
 
     static const std::string owlClass;
     static const std::string owlObjectProperty;
@@ -119,13 +120,37 @@ namespace dl {
     parseTBox(TBox& tbox) throw (DLParsingError);
 
     /**
-     * get default namespace
+     * get default namespace, stops parsing as soon as it is known.
      *
      * @param ns set namespace to this string
      */
     virtual void
     parseNamespace(std::string& ns) throw (DLParsingError);
 
+    /**
+     * get default namespace, concept and role names, and individuals
+     * in a single pass.
+     *
+     * @param ns set namespace to this string
+     * @param tbox add concept and role names to @a tbox
+     * @param abox add individuals to @a abox
+     */
+    virtual void
+    parseOntology(std::string& ns, TBox& tbox, ABox& abox) throw (DLParsingError);
+
+    /**
+     * get default namespace, concept and role names, individuals,
+     * and the imported documents in a single pass.
+     *
+     * @param ns set namespace to this string
+     * @param tbox add concept and role names to @a tbox
+     * @param abox add individuals to @a abox
+     * @param imports add the URIs of the owl:imports to @a imports
+     */
+    virtual void
+    parseOntology(std::string& ns, TBox& tbox, ABox& abox,
+		  std::vector<std::string>& imports) throw (DLParsingError);
+
     /** 
      * Fetch uri to file.
      * 
@@ -41,8 +41,10 @@
 #include <iostream>
 #include <string>
 #include <set>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/recursive_mutex.hpp>
 
 namespace dlvhex {
 namespace dl {
@@ -138,6 +140,8 @@ namespace dl {
   };
 
 
+  class OntologySnapshot;
+
   /**
    * @brief Basic information about ontologies.
    *
@@ -168,6 +172,23 @@ namespace dl {
     mutable TBox* tbox;
     /// individual names
     mutable ABox* abox;
+    /// URIs of the owl:imports of the document
+    mutable std::vector<std::string> imports;
+
+    /// the fingerprint of the document when #contentHash was computed
+    mutable std::string hashedFingerprint;
+    /// hash of the content of the document
+    mutable std::string contentHash;
+
+    /// the up-to-date snapshot of the document, may be empty
+    boost::shared_ptr<OntologySnapshot> snapshot;
+
+    /// protects the lazily computed members, which other threads
+    /// may ask for while the document is being loaded
+    mutable boost::recursive_mutex mutex;
+
+    /// the directory of the snapshots, empty if disabled
+    static std::string snapshotDirectory;
 
     //
     // we don't want Ontology to be constructed by the user, so keep
@@ -179,6 +200,18 @@ namespace dl {
     explicit
     Ontology(const URI& uri, const std::string& tempfile = "");
 
+    /// parses #tbox, #abox and #imports, or reads them from #snapshot
+    void
+    parse() const;
+
+    /// @return the file of the snapshot of the document
+    std::string
+    getSnapshotFile() const;
+
+    /// @return true if #snapshot describes the current document
+    bool
+    isSnapshotValid() const;
+
     /// private copy ctor
     Ontology(const Ontology&);
 
@@ -190,10 +223,27 @@ namespace dl {
     virtual
     ~Ontology();
 
-    /// factory method
+    /**
+     * Factory method, which may be called by several threads at
+     * once. Each document is opened only once, a thread which asks
+     * for a document that another thread is opening waits for it.
+     *
+     * @param uri
+     *
+     * @return the Ontology of @a uri
+     */
     static Ontology::shared_pointer
     createOntology(const std::string& uri);
 
+    /**
+     * Keep binary snapshots of the parsed local documents in @a dir,
+     * so that later runs do not need to parse them again.
+     *
+     * @param dir the directory, empty to disable snapshots
+     */
+    static void
+    setSnapshotDirectory(const std::string& dir);
+
     const URI&
     getURI() const;
 
@@ -209,6 +259,24 @@ namespace dl {
     const TBox&
     getTBox() const;
 
+    /// @return the URIs of the documents imported by owl:imports
+    const std::vector<std::string>&
+    getImports() const;
+
+    /** 
+     * @return a fingerprint of the local OWL document, which changes
+     * whenever the document is modified.
+     */
+    std::string
+    getFingerprint() const;
+
+    /**
+     * @return a hash of the content of the local OWL document, which
+     * stays the same across runs as long as the document does.
+     */
+    const std::string&
+    getContentHash() const;
+
     friend std::ostream&
     operator<< (std::ostream& os, const Ontology& o);
 
@@ -0,0 +1,136 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   OntologyLoader.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 23:05:18 2026
+ *
+ * @brief  Loads ontologies and their imports concurrently.
+ *
+ *
+ */
+
+
+#ifndef _ONTOLOGYLOADER_H
+#define _ONTOLOGYLOADER_H
+
+#include "Ontology.h"
+#include "URI.h"
+
+#include <set>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief Opens and parses a set of ontologies along with the
+   * documents they import, using a pool of threads.
+   *
+   * Each thread takes the next URI from the queue, opens it with
+   * Ontology::createOntology(), parses its names, and queues the
+   * documents of its owl:imports. Loading ends when the queue is
+   * empty and no thread works on a document anymore.
+   */
+  class OntologyLoader
+  {
+  public:
+    typedef std::vector<Ontology::shared_pointer> Ontologies;
+
+  private:
+    /// URIs waiting for a thread
+    std::deque<std::string> pending;
+    /// all URIs ever queued, so each document is loaded once
+    std::set<URI> seen;
+    /// the loaded ontologies
+    Ontologies loaded;
+    /// the errors of the documents which could not be loaded
+    std::vector<std::string> errors;
+    /// number of threads which load a document right now
+    unsigned busy;
+
+    /// protects the members above
+    boost::mutex mutex;
+    /// signals new URIs and the end of loading
+    boost::condition_variable changed;
+
+    /// queues @a uri unless seen, #mutex must be locked
+    void
+    push(const std::string& uri);
+
+    /// the loop of each thread
+    void
+    work();
+
+    /// private copy ctor
+    OntologyLoader(const OntologyLoader&);
+
+    /// private assignment op
+    OntologyLoader&
+    operator= (const OntologyLoader&);
+
+  public:
+    /// Ctor
+    OntologyLoader();
+
+    /**
+     * Queues @a uri for loading.
+     *
+     * @param uri
+     */
+    void
+    add(const std::string& uri);
+
+    /**
+     * Loads the queued ontologies and everything they import.
+     *
+     * @param threads the size of the thread pool, 0 for one thread
+     * per core
+     *
+     * @return the loaded ontologies, in no particular order
+     */
+    const Ontologies&
+    load(unsigned threads = 0);
+
+    /// @return the errors of the documents which failed to load
+    const std::vector<std::string>&
+    getErrors() const
+    {
+      return errors;
+    }
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _ONTOLOGYLOADER_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
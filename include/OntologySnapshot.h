@@ -0,0 +1,181 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   OntologySnapshot.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 21:12:40 2026
+ *
+ * @brief  A binary snapshot of the names of an ontology.
+ *
+ *
+ */
+
+
+#ifndef _ONTOLOGYSNAPSHOT_H
+#define _ONTOLOGYSNAPSHOT_H
+
+#include "Ontology.h"
+#include "DLError.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief Keeps the namespace, the TBox and the ABox of an OWL
+   * document in a file, so that later runs do not need to parse the
+   * document again.
+   *
+   * The file starts with a magic string, followed by the path, the
+   * fingerprint and the content hash of the document, its namespace,
+   * the URIs of its owl:imports, a table of the interned names, and
+   * the arrays of IDs of the concepts, roles, datatype roles and
+   * individuals. Numbers are
+   * 32-bit in host byte order, strings are a length followed by the
+   * characters. The file is mapped into memory and only the parts
+   * which are asked for are decoded.
+   */
+  class OntologySnapshot
+  {
+  private:
+    /// a string in the mapped file
+    typedef std::pair<const char*, std::size_t> String;
+
+    /// the sections of ID arrays
+    enum Section
+      {
+	CONCEPTS = 0,
+	ROLES,
+	DATATYPEROLES,
+	INDIVIDUALS,
+	SECTIONS
+      };
+
+    /// the mapped file
+    void* base;
+    /// the length of the mapping
+    std::size_t length;
+
+    String path;
+    String fingerprint;
+    String hash;
+    String nspace;
+
+    /// the URIs of the imported documents
+    std::vector<String> imports;
+
+    /// the interned names
+    std::vector<String> names;
+
+    /// the start of the ID arrays
+    const char* sections[SECTIONS];
+
+    /// checks the layout of the mapped file and indexes it
+    bool
+    index();
+
+    /// adds the names of section @a s to @a objs
+    void
+    read(Section s, TBox::Objects& objs) const;
+
+    /// private copy ctor
+    OntologySnapshot(const OntologySnapshot&);
+
+    /// private assignment op
+    OntologySnapshot&
+    operator= (const OntologySnapshot&);
+
+  public:
+    /**
+     * Maps @a file, which may be missing or broken.
+     *
+     * @param file
+     */
+    explicit
+    OntologySnapshot(const std::string& file);
+
+    /// Dtor
+    ~OntologySnapshot();
+
+    /// @return true if the snapshot could be mapped
+    bool
+    isValid() const
+    {
+      return base != 0;
+    }
+
+    /// @return the path of the document
+    std::string
+    getPath() const;
+
+    /// @return the fingerprint of the document, see Ontology::getFingerprint()
+    std::string
+    getFingerprint() const;
+
+    /// @return the content hash of the document, see Ontology::getContentHash()
+    std::string
+    getContentHash() const;
+
+    /// @return the default namespace of the document
+    std::string
+    getNamespace() const;
+
+    /// @param uris gets the URIs of the imported documents
+    void
+    getImports(std::vector<std::string>& uris) const;
+
+    /// @param tbox gets the concept and role names
+    void
+    getTBox(TBox& tbox) const;
+
+    /// @param abox gets the individuals
+    void
+    getABox(ABox& abox) const;
+
+    /**
+     * Writes the snapshot of @a o to @a file.
+     *
+     * @param file
+     * @param o
+     * @param tbox the TBox of @a o
+     * @param abox the ABox of @a o
+     * @param imports the URIs of the imported documents of @a o
+     */
+    static void
+    write(const std::string& file, const Ontology& o,
+	  const TBox& tbox, const ABox& abox,
+	  const std::vector<std::string>& imports) throw (DLError);
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _ONTOLOGYSNAPSHOT_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -0,0 +1,102 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   PreloadConverter.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 23:41:07 2026
+ *
+ * @brief  Finds the ontologies of the dl-atoms in a program.
+ *
+ *
+ */
+
+
+#ifndef _PRELOADCONVERTER_H
+#define _PRELOADCONVERTER_H
+
+#include <dlvhex2/PluginInterface.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace dlvhex {
+namespace dl {
+namespace racer {
+
+  //
+  // forward declarations
+  //
+  class RacerInterface;
+
+
+  /**
+   * @brief Passes the program through unchanged and lets the
+   * RacerInterface load the ontologies of its dl-atoms, while dlvhex
+   * goes on with parsing and grounding.
+   */
+  class PreloadConverter : public PluginConverter
+  {
+  private:
+    /// the plugin which loads the ontologies
+    RacerInterface& plugin;
+
+  public:
+    /// Ctor
+    explicit
+    PreloadConverter(RacerInterface& ri);
+
+    /// Dtor
+    virtual
+    ~PreloadConverter();
+
+    /**
+     * Copies @a i to @a o and preloads the ontologies used in @a i.
+     *
+     * @param i
+     * @param o
+     */
+    virtual void
+    convert(std::istream& i, std::ostream& o);
+
+    /**
+     * Collects the ontology URIs of the dl-atoms &dlX["uri",...] in
+     * @a program, skipping comments and other strings.
+     *
+     * @param program
+     * @param uris gets the URIs, each once
+     */
+    static void
+    scan(const std::string& program, std::vector<std::string>& uris);
+  };
+
+} // namespace racer
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _PRELOADCONVERTER_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
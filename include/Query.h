@@ -35,9 +35,11 @@
 #define _QUERY_H
 
 #include "DLQuery.h"
+#include "SymbolTable.h"
 
 #include <iosfwd>
 #include <iterator>
+#include <set>
 
 namespace dlvhex {
 namespace dl {
@@ -63,10 +65,22 @@ namespace dl {
     /// the projected interpretation
     ComfortInterpretation proj;
 
+    /// the keys of the atoms in #proj, interned once per query
+    std::vector<SymbolTable::AtomKey> keys;
+
+    /// the input predicates plusC, minusC, plusR, and minusR
+    ComfortTuple lambda;
+
     /// the dl-query
     DLQuery::shared_pointer query;
 
-    /// setup projected interpretations #proj
+    /// the answers of the dl-query are among these tuples
+    std::set<ComfortTuple> candidates;
+
+    /// true if #candidates restricts the answers
+    bool bounded;
+
+    /// setup projected interpretations #proj and their #keys
     void
     setInterpretation(const ComfortInterpretation& ints,
 		      const ComfortTerm& pc,
@@ -94,6 +108,16 @@ namespace dl {
 	  const ComfortTerm& mr,
 	  const ComfortInterpretation& i);
 
+    /** 
+     * Ctor for a sibling of @a q, i.e., a dl-query with the same input
+     * predicates and projected interpretation as @a q.
+     * 
+     * @param q dl-query
+     * @param sibling take input and projected interpretation from this query
+     */
+    Query(const DLQuery::shared_pointer& q,
+	  const Query& sibling);
+
     /// dtor.
     virtual
     ~Query()
@@ -108,6 +132,36 @@ namespace dl {
     virtual const ComfortInterpretation&
     getProjectedInterpretation() const;
 
+    /// @return the SymbolTable keys of the atoms in the projected interpretation, in its order
+    virtual const std::vector<SymbolTable::AtomKey>&
+    getProjectedKeys() const;
+
+    /// @return the input predicates plusC, minusC, plusR, and minusR
+    virtual const ComfortTuple&
+    getInputPredicates() const;
+
+    /**
+     * Restricts the answers of this query to @a c, e.g., because
+     * the cache knows that every other answer is either entailed or
+     * not entailed.
+     *
+     * @param c
+     */
+    virtual void
+    setCandidates(const std::set<ComfortTuple>& c);
+
+    /// drop the restriction of setCandidates()
+    virtual void
+    clearCandidates();
+
+    /// @return true if the answers are restricted to getCandidates()
+    virtual bool
+    hasCandidates() const;
+
+    /// @return the candidate answers of this query
+    virtual const std::set<ComfortTuple>&
+    getCandidates() const;
+
     friend std::ostream&
     operator<< (std::ostream& os, const Query& q);
 
@@ -38,9 +38,15 @@
 #include "Cache.h"
 
 #include <iosfwd>
+#include <utility>
+#include <vector>
+#include <set>
+#include <functional>
 
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/ptr_container/indirect_fun.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 
 namespace dlvhex {
@@ -64,6 +70,40 @@ namespace dl {
     virtual QueryCtx::shared_pointer
     query(QueryCtx::shared_pointer qctx) throw(DLError) = 0;
 
+    /**
+     * @return true if query() can be split into send() and
+     * receive(), which allows to pipeline the commands of several
+     * directors.
+     */
+    virtual bool
+    isPipelined() const
+    {
+      return false;
+    }
+
+    /**
+     * Sends the command for @a qctx without waiting for its answer.
+     *
+     * @param qctx
+     *
+     * @return true if a command was sent and its answer must be
+     * fetched with receive(), false otherwise.
+     */
+    virtual bool
+    send(QueryCtx::shared_pointer /* qctx */) throw(DLError)
+    {
+      return false;
+    }
+
+    /**
+     * Receives the answer of a previous send().
+     *
+     * @param qctx
+     */
+    virtual void
+    receive(QueryCtx::shared_pointer /* qctx */) throw(DLError)
+    { }
+
     typedef boost::shared_ptr<QueryBaseDirector> shared_pointer; 
   };
 
@@ -107,6 +147,31 @@ namespace dl {
      */
     virtual QueryCtx::shared_pointer
     query(QueryCtx::shared_pointer qctx) throw(DLError);
+
+    /// @return true
+    virtual bool
+    isPipelined() const
+    {
+      return true;
+    }
+
+    /**
+     * Builds the command using the Builder member.
+     *
+     * @param qctx
+     *
+     * @return the result of Builder::buildCommand()
+     */
+    virtual bool
+    send(QueryCtx::shared_pointer qctx) throw(DLError);
+
+    /**
+     * Parses the answer using the Parser member.
+     *
+     * @param qctx
+     */
+    virtual void
+    receive(QueryCtx::shared_pointer qctx) throw(DLError);
   };
 
 
@@ -216,6 +281,21 @@ namespace dl {
     virtual QueryCtx::shared_pointer
     handleInconsistency(QueryCtx::shared_pointer qctx);
 
+    /**
+     * Sends the commands of the directors in [@a beg, @a end) in one
+     * go and receives their answers in order afterwards.
+     *
+     * @param qctx
+     * @param beg
+     * @param end
+     *
+     * @return true if an answer reported inconsistency, false otw.
+     */
+    virtual bool
+    pipeline(QueryCtx::shared_pointer qctx,
+	     boost::ptr_vector<QueryBaseDirector>::iterator beg,
+	     boost::ptr_vector<QueryBaseDirector>::iterator end);
+
   public:
     /// Ctor
     explicit
@@ -229,12 +309,23 @@ namespace dl {
     virtual void
     add(QueryBaseDirector* d);
 
+    /// @return the stream of this composite
+    std::iostream&
+    getStream() const
+    {
+      return stream;
+    }
+
     /**
      * iterates through the list of QueryBaseDirectors and calls their
      * query() method. If the ABox gets inconsistent during the
      * iteration query() calls handleInconsitency() in order to
      * generate the appropriate answer.
      *
+     * If Registry::PIPELINE is set, the commands of consecutive
+     * pipelined directors are sent at once and their answers are
+     * received afterwards, which saves a round trip per command.
+     *
      * @param qctx
      *
      * @return the QueryCtx::shared_pointer with the corresponding
@@ -243,6 +334,18 @@ namespace dl {
     virtual QueryCtx::shared_pointer
     query(QueryCtx::shared_pointer qctx) throw(DLError);
 
+    /**
+     * Fills the trivial answer of @a qctx under an inconsistent ABox,
+     * i.e., true for boolean queries and all tuples of individuals
+     * for retrieval queries.
+     *
+     * @param qctx
+     *
+     * @return @a qctx
+     */
+    static QueryCtx::shared_pointer
+    inconsistentAnswer(QueryCtx::shared_pointer qctx);
+
     typedef boost::shared_ptr<QueryCompositeDirector> shared_pointer;
   };
 
@@ -284,6 +387,175 @@ namespace dl {
   };
 
 
+  /**
+   * @brief Answers dlConsistent queries with help of the consistency
+   * cache.
+   */
+  class QueryConsistencyDirector : public QueryBaseDirector
+  {
+  private:
+    /// the underlying director
+    QueryBaseDirector::shared_pointer director;
+
+    /// reference to the cache of QueryCtx objects
+    BaseCache& cache;
+
+  public:
+    /**
+     * Ctor.
+     *
+     * @param c the cache
+     * @param d delegation director
+     */
+    QueryConsistencyDirector(BaseCache& c, QueryBaseDirector::shared_pointer d);
+
+    /**
+     * Answers @a qctx from BaseCache::consistency() if possible,
+     * otherwise delegates to the underlying director and records the
+     * answer with BaseCache::insertConsistency().
+     *
+     * @param qctx
+     *
+     * @return the QueryCtx::shared_pointer with the corresponding
+     * Answer to the Query
+     */
+    virtual QueryCtx::shared_pointer
+    query(QueryCtx::shared_pointer qctx) throw(DLError);
+  };
+
+
+  /**
+   * @brief Answers a burst of boolean queries with a single retrieval
+   * query.
+   *
+   * Grounding a rule with a boolean dl-atom asks for one individual
+   * after the other. Once BaseCache::promote() tells that the burst
+   * pays off, the retrieval director asks for all individuals at
+   * once, and the query and the rest of the burst are answered from
+   * the cached retrieval answer.
+   */
+  class QueryPromotingDirector : public QueryBaseDirector
+  {
+  private:
+    /// the caching director of the query
+    QueryBaseDirector::shared_pointer director;
+
+    /// the caching director of the retrieval query
+    QueryBaseDirector::shared_pointer retrieval;
+
+    /// reference to the cache of QueryCtx objects
+    BaseCache& cache;
+
+  public:
+    /**
+     * Ctor.
+     *
+     * @param c the cache
+     * @param d delegation director
+     * @param r director for the retrieval query, which sets up the
+     * ABox just like @a d
+     */
+    QueryPromotingDirector(BaseCache& c,
+			   QueryBaseDirector::shared_pointer d,
+			   QueryBaseDirector::shared_pointer r);
+
+    /**
+     * Poses the retrieval query of @a qctx first if @a qctx is not
+     * cached and its burst gets promoted, and delegates to the
+     * underlying director afterwards.
+     *
+     * @param qctx
+     *
+     * @return the QueryCtx::shared_pointer with the corresponding
+     * Answer to the Query
+     */
+    virtual QueryCtx::shared_pointer
+    query(QueryCtx::shared_pointer qctx) throw(DLError);
+  };
+
+
+  /**
+   * @brief Caching director which coalesces the evaluation of a
+   * query with the evaluation of its siblings.
+   *
+   * Siblings are queries with the same input and projected
+   * interpretation, but a different dl-query. If the query is not
+   * cached, the commands of the siblings which are not cached either
+   * are appended to the underlying QueryCompositeDirector, hence they
+   * share its ABox setup and are sent in one go if pipelining is
+   * enabled. Their answers are cached for the upcoming queries.
+   *
+   * A sibling which fails is neither cached nor does it fail the
+   * query. Only dl-queries which have been answered become siblings
+   * of later queries, a failing one is dropped again.
+   */
+  class QueryCoalescingDirector : public QueryBaseDirector
+  {
+  public:
+    /// dl-queries ordered by value
+    typedef std::set<DLQuery::shared_pointer,
+		     boost::indirect_fun<std::less<DLQuery> > > DLQuerySet;
+
+  private:
+    /// a sibling query and the director which poses it
+    typedef std::pair<QueryCtx::shared_pointer,
+		      QueryBaseDirector::shared_pointer> Sibling;
+
+    /// the underlying director
+    QueryCompositeDirector::shared_pointer director;
+
+    /// reference to the cache of QueryCtx objects
+    BaseCache& cache;
+
+    /// the siblings of the query
+    std::vector<Sibling> siblings;
+
+    /// the answered dl-queries with the ontology and input of the query
+    DLQuerySet& known;
+
+    /// protects #known
+    boost::mutex& knownMutex;
+
+    /// adds the dl-query of @a qctx to #known, or drops it if @a answered is false
+    void
+    remember(const QueryCtx::shared_pointer& qctx, bool answered);
+
+  public:
+    /** 
+     * Ctor.
+     * 
+     * @param c the cache
+     * @param d delegation director
+     * @param k the sibling candidates, which learn about the answered queries
+     * @param m protects @a k
+     */
+    QueryCoalescingDirector(BaseCache& c, QueryCompositeDirector::shared_pointer d,
+			    DLQuerySet& k, boost::mutex& m);
+
+    /**
+     * Adds a sibling of the query.
+     *
+     * @param qctx the sibling query
+     * @param d the director which poses @a qctx without any setup
+     */
+    virtual void
+    add(QueryCtx::shared_pointer qctx, QueryBaseDirector::shared_pointer d);
+
+    /**
+     * Like QueryCachingDirector::query(), but evaluates the uncached
+     * siblings of @a qctx together with @a qctx and caches them as
+     * well, unless @a qctx turned out to be incoherent.
+     *
+     * @param qctx
+     *
+     * @return the QueryCtx::shared_pointer with the corresponding
+     * Answer to the Query
+     */
+    virtual QueryCtx::shared_pointer
+    query(QueryCtx::shared_pointer qctx) throw(DLError);
+  };
+
+
 } // namespace dl
 } // namespace dlvhex
 
@@ -70,6 +70,22 @@ namespace dl {
     return qctx;
   }
 
+  template <class Builder, class Parser>
+  bool
+  QueryDirector<Builder, Parser>::send(QueryCtx::shared_pointer qctx)
+    throw(DLError)
+  {
+    return builder.buildCommand(qctx->getQuery());
+  }
+
+  template <class Builder, class Parser>
+  void
+  QueryDirector<Builder, Parser>::receive(QueryCtx::shared_pointer qctx)
+    throw(DLError)
+  {
+    parser.parse(qctx->getAnswer());
+  }
+
 } // namespace dl
 } // namespace dlvhex
 
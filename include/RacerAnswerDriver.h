@@ -90,6 +90,24 @@ namespace racer {
   };
 
 
+  /**
+   * @brief Parses the answer of a boolean nRQL query which asks for
+   * the consistency of an ABox.
+   *
+   * RACER denies nRQL queries on an inconsistent ABox with an error,
+   * which is the negative answer here and not an incoherent one.
+   */
+  class RacerConsistencyAnswerDriver : public RacerAnswerDriver
+  {
+  public:
+    explicit
+    RacerConsistencyAnswerDriver(std::istream& is);
+
+    virtual void
+    parse(Answer& answer) throw (DLParsingError);
+  };
+
+
   /**
    * @brief Ignores a RACER reply to parse answer and errors without
    * an exception.
@@ -70,6 +70,11 @@ namespace racer {
    * @brief Creates a state command for adding a list of
    * Individuals/Pairs to Concepts/Roles.
    *
+   * The working ABox in the KBManager tells which assertions are
+   * already in the ABox, so the command only retracts and adds the
+   * difference to the interpretation of the query. Must be used
+   * right after RacerCloneABoxBuilder.
+   *
    * @see state macro in RacerPro Reference Manual
    */
   class RacerStateBuilder : public QueryBaseBuilder
@@ -85,13 +90,32 @@ namespace racer {
      * @param q use the interpretation of Query to generate a state
      * command
      *
-     * @return true if we could add something to the abox, false otherwise.
+     * @return true if we have to change the abox, false otherwise.
      */
     virtual bool
     buildCommand(Query& q) throw (DLBuildingError);
   };
 
 
+  /**
+   * @brief Clones the ABox of KB |realuri| into the KBManager's
+   * kb-name unless the working ABox is a clone of |realuri| which
+   * is cheaper to update than to rebuild, or Registry::ABOXDELTA
+   * is off.
+   *
+   * @see clone-abox macro in RacerPro Reference manual.
+   */
+  class RacerCloneABoxBuilder : public QueryBaseBuilder
+  {
+  public:
+    explicit
+    RacerCloneABoxBuilder(std::ostream&);
+
+    virtual bool
+    buildCommand(Query& q) throw (DLBuildingError);
+  };
+
+
   /**
    * @brief Creates an individual-instance? command in order to check
    * whether an individual is a member of a concept.
@@ -185,7 +209,9 @@ namespace racer {
 
 
   /**
-   * @brief Opens an OWL from file or URL as KB "DEFAULT".
+   * @brief Opens an OWL from file or URL as KB |realuri| unless the
+   * KBManager knows that RACER already holds the current version of
+   * the document.
    *
    * @see owl-read-file and owl-read-document functions in RacerPro
    * Reference manual.
@@ -201,6 +227,77 @@ namespace racer {
   };
 
 
+  /**
+   * @brief Reads all owl:imports of KB |realuri| and registers
+   * |realuri| as open KB in the KBManager.
+   *
+   * Must be used right after RacerOpenOWLBuilder, since both
+   * builders skip their command if the KB is already open.
+   *
+   * @see kb-ontologies in RacerPro Reference manual.
+   */
+  class RacerImportOntologiesBuilder : public QueryBaseBuilder
+  {
+  public:
+    explicit
+    RacerImportOntologiesBuilder(std::ostream&);
+
+    virtual bool
+    buildCommand(Query& q) throw (DLBuildingError);
+  };
+
+
+  /**
+   * @brief Performs a full reset in RACER if the KBManager has no
+   * valid session, i.e., on the first query or after RACER has seen
+   * an inconsistent ABox or a failure.
+   *
+   * @see full-reset function in RacerPro Reference manual. 
+   */
+  class RacerFullResetBuilder : public QueryBaseBuilder
+  {
+  public:
+    explicit
+    RacerFullResetBuilder(std::ostream&);
+
+    virtual bool
+    buildCommand(Query& q) throw (DLBuildingError);
+  };
+
+
+  /**
+   * @brief Turns on the unique name assumption once per session if
+   * Registry::UNA is set.
+   *
+   * @see set-unique-name-assumption function in RacerPro Reference manual. 
+   */
+  class RacerUNABuilder : public QueryBaseBuilder
+  {
+  public:
+    explicit
+    RacerUNABuilder(std::ostream&);
+
+    virtual bool
+    buildCommand(Query& q) throw (DLBuildingError);
+  };
+
+
+  /**
+   * @brief Enables data substrate mirroring once per session.
+   *
+   * @see enable-data-substrate-mirroring function in RacerPro Reference manual.
+   */
+  class RacerDataSubstrateMirroringBuilder : public QueryBaseBuilder
+  {
+  public:
+    explicit
+    RacerDataSubstrateMirroringBuilder(std::ostream&);
+
+    virtual bool
+    buildCommand(Query& q) throw (DLBuildingError);
+  };
+
+
   /**
    * @brief An adapter for classes with a ctor
    * Adaptee::Adaptee(Query&) and an operator<<(ostream&, const
@@ -422,7 +519,13 @@ namespace racer {
     const std::string
     operator() (KBManager& k) const
     {
-      return "(forget-abox " + k.getKBName() + ")";
+      return (*this)(k.getKBName());
+    }
+
+    const std::string
+    operator() (const std::string& abox) const
+    {
+      return "(forget-abox " + abox + ")";
     }
   };
 
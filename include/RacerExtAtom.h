@@ -34,8 +34,16 @@
 #define _RACEREXTATOM_H
 
 #include "QueryDirector.h"
+#include "DLQuery.h"
 
 #include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <boost/ptr_container/indirect_fun.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace dlvhex {
 namespace dl {
@@ -50,19 +58,16 @@ namespace racer {
   /**
    * @brief Base class for RACER external atoms.
    */
-  template <class GetKBManager>
+  template <class GetRacerPool>
   class RacerExtAtom : public ComfortPluginAtom
   {
   protected:
-    /// keep a reference to the iostream in order to create the
-    /// director instances
-    std::iostream& stream;
-
-    /// get a reference to the KBManager
-    GetKBManager getKBManager;
+    /// get a reference to the RacerPool
+    GetRacerPool getRacerPool;
 
     /// protected ctor
-    RacerExtAtom(std::string name, std::iostream&);
+    explicit
+    RacerExtAtom(std::string name);
 
     /// dtor
     virtual
@@ -103,12 +108,13 @@ namespace racer {
      * director classes.
      *
      * @param query
+     * @param stream the connection to the RACER backend of @a query
      *
      * @return a QueryBaseDirector::shared_pointer representing the
      * appropriate command to send to the RACER process
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query&  query) const = 0;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const = 0;
 
 
   public:
@@ -129,19 +135,92 @@ namespace racer {
   /**
    * @brief Base class for cached external atoms.
    */
-  template <class GetKBManager, class GetCache>
-  class RacerCachingAtom : public RacerExtAtom<GetKBManager>
+  template <class GetRacerPool, class GetCache>
+  class RacerCachingAtom : public RacerExtAtom<GetRacerPool>
   {
+  private:
+    /// dl-queries answered so far, ordered by value
+    typedef QueryCoalescingDirector::DLQuerySet DLQuerySet;
+
+    /// maps the real URI of an ontology and the input predicates to
+    /// the dl-queries answered with them
+    typedef std::map<std::pair<std::string, ComfortTuple>, DLQuerySet> SiblingMap;
+
+    /// the candidates for coalescing
+    mutable SiblingMap siblings;
+
+    /// protects #siblings
+    mutable boost::mutex siblingsMutex;
+
   protected:
     /// get a reference to the cache of QueryCtx objects
     GetCache getCache;
 
-    /// @return a caching director for @a comp
+    /// upper bound for the number of siblings evaluated along with a query
+    static const unsigned maxSiblings = 64;
+
+    /**
+     * If Registry::COALESCE is set, the siblings of @a query, i.e.,
+     * the dl-queries which were asked with the same ontology and
+     * input predicates before, are evaluated along with @a query.
+     *
+     * @param query
+     * @param comp the director chain of @a query
+     *
+     * @return a caching director for @a comp
+     */
     virtual QueryBaseDirector::shared_pointer
-    cacheQuery(QueryCompositeDirector::shared_pointer comp) const;
+    cacheQuery(const dlvhex::dl::Query& query,
+	       QueryCompositeDirector::shared_pointer comp) const;
+
+    /**
+     * Creates the director which poses @a query to an ABox which is
+     * already set up.
+     *
+     * @param query
+     * @param stream
+     *
+     * @return the director, or 0 if @a query cannot be coalesced
+     */
+    virtual QueryBaseDirector*
+    getQueryDirector(const dlvhex::dl::Query& /* query */, std::iostream& /* stream */) const
+    {
+      return 0;
+    }
+
+    /**
+     * Creates the director which retrieves all tuples of a dl-query
+     * from an ABox which is already set up.
+     *
+     * @param stream
+     *
+     * @return the director, or 0 if bursts of boolean queries cannot
+     * be promoted to retrievals
+     */
+    virtual QueryBaseDirector*
+    getRetrievalDirector(std::iostream& /* stream */) const
+    {
+      return 0;
+    }
+
+    /**
+     * If Registry::PROMOTE is set and @a query is a boolean or mixed
+     * query, a burst of queries like @a query may be answered by a
+     * retrieval query, which is set up just like @a query.
+     *
+     * @param query
+     * @param stream
+     * @param cached the caching director of @a query
+     *
+     * @return a QueryPromotingDirector for @a cached, or @a cached
+     */
+    virtual QueryBaseDirector::shared_pointer
+    promoteQuery(const dlvhex::dl::Query& query, std::iostream& stream,
+		 QueryBaseDirector::shared_pointer cached) const;
 
   public:
-    RacerCachingAtom(std::string name, std::iostream&);
+    explicit
+    RacerCachingAtom(std::string name);
   };
 
 
@@ -149,8 +228,8 @@ namespace racer {
    * @brief Implements the concept retrieving atom
    * &dlC[kb,plusC,minusC,plusR,minusR,query](X).
    */
-  template <class GetKBManager, class GetCache>
-  class RacerConceptAtom : public RacerCachingAtom<GetKBManager,GetCache>
+  template <class GetRacerPool, class GetCache>
+  class RacerConceptAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /**
@@ -158,14 +237,31 @@ namespace racer {
      * retrieval query and creates the director chain accordingly.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
+
+    /**
+     * creates the boolean or retrieval concept query for the pattern tuple of @a query.
+     *
+     * @param query
+     * @param stream
+     *
+     * @return the query director
+     */
+    virtual QueryBaseDirector*
+    getQueryDirector(const dlvhex::dl::Query& query, std::iostream& stream) const;
+
+    /// creates the concept retrieval query
+    virtual QueryBaseDirector*
+    getRetrievalDirector(std::iostream& stream) const;
 
   public:
-    RacerConceptAtom(std::string name, std::iostream&);
+    explicit
+    RacerConceptAtom(std::string name);
   };
 
 
@@ -173,8 +269,8 @@ namespace racer {
    * @brief Implements the role retrieving atom
    * &dlR[kb,plusC,minusC,plusR,minusR,query](X,Y).
    */
-  template <class GetKBManager, class GetCache>
-  class RacerRoleAtom : public RacerCachingAtom<GetKBManager,GetCache>
+  template <class GetRacerPool, class GetCache>
+  class RacerRoleAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /**
@@ -183,14 +279,31 @@ namespace racer {
      * chain accordingly.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
+
+    /**
+     * creates the boolean, retrieval or individual filler role query for the pattern tuple of @a query.
+     *
+     * @param query
+     * @param stream
+     *
+     * @return the query director
+     */
+    virtual QueryBaseDirector*
+    getQueryDirector(const dlvhex::dl::Query& query, std::iostream& stream) const;
+
+    /// creates the role retrieval query
+    virtual QueryBaseDirector*
+    getRetrievalDirector(std::iostream& stream) const;
 
   public:
-    RacerRoleAtom(std::string name, std::iostream&);
+    explicit
+    RacerRoleAtom(std::string name);
   };
 
 
@@ -199,23 +312,25 @@ namespace racer {
    * @brief Implements the consistency checking atom
    * &dlConsistent[kb,plusC,minusC,plusR,minusR]().
    */
-  template <class GetKBManager>
-  class RacerConsistentAtom : public RacerExtAtom<GetKBManager>
+  template <class GetRacerPool, class GetCache>
+  class RacerConsistentAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /**
-     * creates a director chain to check the consistency of the ABox.
+     * creates a director chain to check the consistency of the ABox,
+     * which is skipped if the consistency cache knows the answer.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
 
   public:
     explicit
-    RacerConsistentAtom(std::string name, std::iostream&);
+    RacerConsistentAtom(std::string name);
   };
 
 
@@ -223,8 +338,8 @@ namespace racer {
    * @brief Implements the datatype role retrieving atom
    * &dlDR[kb,plusC,minusC,plusR,minusR,query](X,Y).
    */
-  template <class GetKBManager, class GetCache>
-  class RacerDatatypeRoleAtom : public RacerCachingAtom<GetKBManager,GetCache>
+  template <class GetRacerPool, class GetCache>
+  class RacerDatatypeRoleAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /** 
@@ -241,14 +356,16 @@ namespace racer {
      * chain accordingly.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
 
   public:
-    RacerDatatypeRoleAtom(std::string name, std::iostream&);
+    explicit
+    RacerDatatypeRoleAtom(std::string name);
   };
 
 
@@ -257,22 +374,23 @@ namespace racer {
    * &dlCQn[kb,plusC,minusC,plusR,minusR,query](X_1,-,X_n), where n
    * is given at instantiation time.
    */
-  template <class GetKBManager, class GetCache>
-  class RacerCQAtom : public RacerCachingAtom<GetKBManager,GetCache>
+  template <class GetRacerPool, class GetCache>
+  class RacerCQAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /**
      * Create a conjunctive query director chain.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
 
   public:
-    RacerCQAtom(std::string name, std::iostream&, unsigned n);
+    RacerCQAtom(std::string name, unsigned n);
   };
 
 
@@ -281,22 +399,23 @@ namespace racer {
    * &dlUCQn[kb,plusC,minusC,plusR,minusR,query](X_1,-,X_n), where n
    * is given at instantiation time.
    */
-  template <class GetKBManager, class GetCache>
-  class RacerUCQAtom : public RacerCachingAtom<GetKBManager,GetCache>
+  template <class GetRacerPool, class GetCache>
+  class RacerUCQAtom : public RacerCachingAtom<GetRacerPool,GetCache>
   {
   protected:
     /**
      * Create a union of conjunctive queries director chain.
      *
      * @param query
+     * @param stream
      *
      * @return
      */
     virtual QueryBaseDirector::shared_pointer
-    getDirectors(const dlvhex::dl::Query& query) const;
+    getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const;
 
   public:
-    RacerUCQAtom(std::string name, std::iostream&, unsigned n);
+    RacerUCQAtom(std::string name, unsigned n);
   };
 
 
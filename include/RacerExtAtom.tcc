@@ -42,6 +42,8 @@
 #include "Query.h"
 #include "Answer.h"
 #include "Cache.h"
+#include "KBManager.h"
+#include "RacerPool.h"
 #include "RacerNRQL.h"
 #include "RacerNRQLBuilder.h"
 
@@ -72,6 +74,12 @@ namespace racer {
   /// request a list of individuals which are fillers of a role for a
   /// specified individual
   typedef QueryDirector<RacerIndividualFillersBuilder, RacerAnswerDriver> RacerIndvFillersQuery;
+  /// pose a concept or role query under the premise of the input
+  typedef QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLConceptRoleBuilder> >,
+			RacerAnswerDriver> RacerPremiseQuery;
+  /// ask whether the ABox is consistent under the premise of the input
+  typedef QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLConsistencyBuilder> >,
+			RacerConsistencyAnswerDriver> RacerPremiseConsistentQuery;
 
 
   /// request to open an OWL document
@@ -81,26 +89,47 @@ namespace racer {
   typedef QueryDirector<RacerStateBuilder, RacerAnswerDriver> RacerConceptRolePM;
 
   
-  template<class GetKBManager>
-  RacerExtAtom<GetKBManager>::RacerExtAtom(std::string name, std::iostream& s)
-    : ComfortPluginAtom(name), stream(s), getKBManager()
+  template<class GetRacerPool>
+  RacerExtAtom<GetRacerPool>::RacerExtAtom(std::string name)
+    : ComfortPluginAtom(name), getRacerPool()
   { }
 
 
-  template<class GetKBManager>
+  template<class GetRacerPool>
   void
-  RacerExtAtom<GetKBManager>::retrieve(const ComfortPluginAtom::ComfortQuery& query,
+  RacerExtAtom<GetRacerPool>::retrieve(const ComfortPluginAtom::ComfortQuery& query,
 				       ComfortPluginAtom::ComfortAnswer& answer) throw(PluginError)
   {
     try
       {
-	QueryCtx::shared_pointer qctx(new QueryCtx(query, getKBManager()));
+	// route the query to a free RACER backend, preferably to one
+	// which has the ontology of the query already loaded
+	Ontology::shared_pointer onto;
 
-	QueryBaseDirector::shared_pointer dirs = getDirectors(qctx->getQuery());
+	if (!query.input.empty())
+	  {
+	    onto = Ontology::createOntology(query.input[0].getUnquotedString());
+	  }
+
+	RacerPool::Lease backend(getRacerPool(), onto);
+
+	QueryCtx::shared_pointer qctx(new QueryCtx(query, backend.getKBManager()));
+
+	QueryBaseDirector::shared_pointer dirs = getDirectors(qctx->getQuery(), backend.getStream());
 
 	boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
 
-	qctx = dirs->query(qctx);
+	try
+	  {
+	    qctx = dirs->query(qctx);
+	  }
+	catch (std::exception&)
+	  {
+	    // we don't know in which state RACER is now, so start
+	    // over with a fresh session in the next query
+	    backend.getKBManager().invalidateSession();
+	    throw;
+	  }
 
 	boost::posix_time::ptime end = boost::posix_time::microsec_clock::local_time();
       
@@ -140,105 +169,161 @@ namespace racer {
   
 
 
-  template<class GetKBManager>
+  template<class GetRacerPool>
   void
-  RacerExtAtom<GetKBManager>::setupRacer(QueryCompositeDirector::shared_pointer& comp) const
+  RacerExtAtom<GetRacerPool>::setupRacer(QueryCompositeDirector::shared_pointer& comp) const
   {
-    ///@todo this is a temporarly fix for Racer's bug with inconsistent ABoxen
-    comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerFullResetCmd>,
-	      RacerIgnoreAnswer>(this->stream)
+    // reset RACER only if the session has been invalidated (initial
+    // query, inconsistent ABox, or communication failure)
+    comp->add(new QueryDirector<RacerFullResetBuilder,
+	      RacerIgnoreAnswer>(comp->getStream())
       );
 
-    ///@todo this is a temporarly fix for Racer's bug with inconsistent ABoxen
-    comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerUNACmd>,
-	      RacerIgnoreAnswer>(this->stream)
+    // turn on unique name assumption once per session
+    comp->add(new QueryDirector<RacerUNABuilder,
+	      RacerIgnoreAnswer>(comp->getStream())
       );
-
-#if 0
-    if (!Registry::getUNA() && (Registry::getFlags() & Registry::UNA)) // only set UNA once
-      {
-	// turn on unique name assumption
-	comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerUNACmd>,
-		  RacerIgnoreAnswer>(this->stream)
-		  );
-	
-	Registry::setUNA(true);
-      }
-#endif // 0
   }
   
 
-  template<class GetKBManager>
+  template<class GetRacerPool>
   void
-  RacerExtAtom<GetKBManager>::openOntology(const dlvhex::dl::Query& query,
+  RacerExtAtom<GetRacerPool>::openOntology(const dlvhex::dl::Query& /* query */,
 					   QueryCompositeDirector::shared_pointer& comp) const
   {
-     ///@todo this is a temporarly fix for Racer's bug with inconsistent ABoxen
-#if 0    
-    // check if Racer has an open KB with the name of the real URI of
-    // the query's ontology, we can reuse it
-
-    std::string kbname = "<" + query.getDLQuery()->getOntology()->getRealURI().getString() + ">";
-
-    if (!getKBManager().isOpenKB(kbname))
-      {
-	// update opened KBs
-	getKBManager().updateOpenKB();
-
-	if (!getKBManager().isOpenKB(kbname)) // only open OWL after we updated the open KBs
-	  {
-#endif // 0
-
-	    comp->add(new RacerOpenOWL(this->stream));
+    // both directors skip their commands if Racer has an open KB
+    // with the name of the real URI of the query's ontology, which
+    // has not changed on disk since we opened it
+    comp->add(new RacerOpenOWL(comp->getStream()));
 	    
-	    // import all referenced ontologies
-	    comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerImportOntologiesCmd>,
-		      RacerIgnoreAnswer>(this->stream)
-		      );
-
-    ///@todo this is a temporarly fix for Racer's bug with inconsistent ABoxen
-#if 0
-	  }
-      }
-#endif // 0
+    // import all referenced ontologies and remember the open KB
+    comp->add(new QueryDirector<RacerImportOntologiesBuilder,
+	      RacerIgnoreAnswer>(comp->getStream())
+	      );
   }
 
 
-  template<class GetKBManager>
+  template<class GetRacerPool>
   void
-  RacerExtAtom<GetKBManager>::increaseABox(const dlvhex::dl::Query& /* query */,
+  RacerExtAtom<GetRacerPool>::increaseABox(const dlvhex::dl::Query& /* query */,
 					   QueryCompositeDirector::shared_pointer& comp) const
   {
-    // create a temporary ABox for the (state) command
-    comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerCloneABoxCmd>,
-	      RacerIgnoreAnswer>(this->stream)
+    // create a temporary ABox for the (state) command, unless we
+    // can reuse the working ABox of the previous query
+    comp->add(new QueryDirector<RacerCloneABoxBuilder,
+	      RacerIgnoreAnswer>(comp->getStream())
 	      );
     
-    // add concept and role assertions via (state) command
-    comp->add(new RacerConceptRolePM(this->stream));
+    // add and retract concept and role assertions via (state) command
+    comp->add(new RacerConceptRolePM(comp->getStream()));
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerCachingAtom<GetKBManager,GetCache>::RacerCachingAtom(std::string name, std::iostream& s)
-    : RacerExtAtom<GetKBManager>(name, s), getCache()
+  template <class GetRacerPool, class GetCache>
+  RacerCachingAtom<GetRacerPool,GetCache>::RacerCachingAtom(std::string name)
+    : RacerExtAtom<GetRacerPool>(name), getCache()
   { }
 
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
+  QueryBaseDirector::shared_pointer
+  RacerCachingAtom<GetRacerPool,GetCache>::cacheQuery(const dlvhex::dl::Query& query,
+						      QueryCompositeDirector::shared_pointer comp) const
+  {
+    if (!(Registry::getFlags() & Registry::COALESCE))
+      {
+	// use the QueryCachingDirector as proxy for the QueryCompositeDirector
+	return QueryBaseDirector::shared_pointer(new QueryCachingDirector(getCache(), comp));
+      }
+
+    const DLQuery::shared_pointer& dlq = query.getDLQuery();
+    std::vector<DLQuery::shared_pointer> sibs;
+
+    // std::map keeps its elements in place, so known stays valid
+    DLQuerySet* known = 0;
+
+    {
+      boost::mutex::scoped_lock lock(siblingsMutex);
+
+      known = &siblings[std::make_pair(dlq->getOntology()->getRealURI().getString(),
+				       query.getInputPredicates())];
+
+      for (typename DLQuerySet::const_iterator it = known->begin();
+	   it != known->end() && sibs.size() < maxSiblings; ++it)
+	{
+	  if (**it != *dlq)
+	    {
+	      sibs.push_back(*it);
+	    }
+	}
+    }
+
+    // dlq joins the candidates once it has been answered
+    boost::shared_ptr<QueryCoalescingDirector> coal
+      (new QueryCoalescingDirector(getCache(), comp, *known, siblingsMutex));
+
+    for (std::vector<DLQuery::shared_pointer>::const_iterator it = sibs.begin();
+	 it != sibs.end(); ++it)
+      {
+	// the siblings share the input and the ABox setup of query
+	Query* q = new Query(*it, query);
+	QueryCtx::shared_pointer sctx(new QueryCtx(q, new Answer(q)));
+	QueryBaseDirector* d = getQueryDirector(*q, comp->getStream());
+
+	if (d)
+	  {
+	    coal->add(sctx, QueryBaseDirector::shared_pointer(d));
+	  }
+      }
+
+    return coal;
+  }
+
+
+
+
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerCachingAtom<GetKBManager,GetCache>::cacheQuery(QueryCompositeDirector::shared_pointer comp) const
+  RacerCachingAtom<GetRacerPool,GetCache>::promoteQuery(const dlvhex::dl::Query& query,
+							std::iostream& stream,
+							QueryBaseDirector::shared_pointer cached) const
   {
-    // use the QueryCachingDirector as proxy for the QueryCompositeDirector
-    return QueryBaseDirector::shared_pointer(new QueryCachingDirector(getCache(), comp));
+    if (!(Registry::getFlags() & Registry::PROMOTE) || query.getDLQuery()->isRetrieval())
+      {
+	return cached;
+      }
+
+    QueryBaseDirector* d = getRetrievalDirector(stream);
+
+    if (!d)
+      {
+	return cached;
+      }
+
+    // the retrieval query gets the same ABox setup as query
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
+
+    this->setupRacer(comp);
+    this->openOntology(query, comp);
+
+    if (!(Registry::getFlags() & Registry::PREMISE))
+      {
+	this->increaseABox(query, comp);
+      }
+
+    comp->add(d);
+
+    QueryBaseDirector::shared_pointer retrieval(new QueryCachingDirector(getCache(), comp));
+
+    return QueryBaseDirector::shared_pointer(new QueryPromotingDirector(getCache(), cached, retrieval));
   }
 
 
 
 
-  template <class GetKBManager>
-  RacerConsistentAtom<GetKBManager>::RacerConsistentAtom(std::string name, std::iostream& s)
-    : RacerExtAtom<GetKBManager>(name, s)
+  template <class GetRacerPool, class GetCache>
+  RacerConsistentAtom<GetRacerPool,GetCache>::RacerConsistentAtom(std::string name)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlConsistent[kb,plusC,minusC,plusR,minusR]()
@@ -255,28 +340,39 @@ namespace racer {
 
 
   
-  template <class GetKBManager>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerConsistentAtom<GetKBManager>::getDirectors(const dlvhex::dl::Query& q) const
+  RacerConsistentAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& q, std::iostream& stream) const
   {
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(q, comp);
-    this->increaseABox(q, comp);
 
-    // ask whether ABox is consistent
-    comp->add
-      (new QueryDirector<RacerFunAdapterBuilder<RacerABoxConsistentCmd>,RacerAnswerDriver>(this->stream)
-       );
+    if (Registry::getFlags() & Registry::PREMISE)
+      {
+	// ask whether ABox and input are consistent in one go
+	comp->add(new RacerPremiseConsistentQuery(stream));
+      }
+    else
+      {
+	this->increaseABox(q, comp);
+
+	// ask whether ABox is consistent
+	comp->add
+	  (new QueryDirector<RacerFunAdapterBuilder<RacerABoxConsistentCmd>,RacerAnswerDriver>(stream)
+	   );
+      }
 
-    return comp;
+    // consistency is monotone in the input, so the consistency cache
+    // may answer without asking RACER
+    return QueryBaseDirector::shared_pointer(new QueryConsistencyDirector(this->getCache(), comp));
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerConceptAtom<GetKBManager,GetCache>::RacerConceptAtom(std::string name, std::iostream& s)
-    : RacerCachingAtom<GetKBManager,GetCache>(name, s)
+  template <class GetRacerPool, class GetCache>
+  RacerConceptAtom<GetRacerPool,GetCache>::RacerConceptAtom(std::string name)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlC[kb,plusC,minusC,plusR,minusR,query](X)
@@ -293,38 +389,67 @@ namespace racer {
   }
   
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerConceptAtom<GetKBManager,GetCache>::getDirectors(const dlvhex::dl::Query& query) const
+  RacerConceptAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const
   {
-    const DLQuery::shared_pointer& dlq = query.getDLQuery();
-
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(query, comp);
-    this->increaseABox(query, comp);
-    
-    if (dlq->isRetrieval()) // retrieval mode
+
+    // the premise of a retrieve-under-premise query carries the input
+    if (!(Registry::getFlags() & Registry::PREMISE))
       {
-	comp->add(new RacerConceptQuery(this->stream));
+	this->increaseABox(query, comp);
+      }
+
+    comp->add(getQueryDirector(query, stream));
+
+    return this->promoteQuery(query, stream, this->cacheQuery(query, comp));
+  }
+
+
+  template <class GetRacerPool, class GetCache>
+  QueryBaseDirector*
+  RacerConceptAtom<GetRacerPool,GetCache>::getQueryDirector(const dlvhex::dl::Query& query, std::iostream& stream) const
+  {
+    const DLQuery::shared_pointer& dlq = query.getDLQuery();
+
+    if (Registry::getFlags() & Registry::PREMISE)
+      {
+	// pose the concept query under the premise of the input
+	return new RacerPremiseQuery(stream);
+      }
+    else if (dlq->isRetrieval()) // retrieval mode
+      {
+	return new RacerConceptQuery(stream);
       }
     else if (dlq->isBoolean()) // boolean query mode
       {
-	comp->add(new RacerIsConceptQuery(this->stream));
+	return new RacerIsConceptQuery(stream);
       }
-    else
+
+    throw PluginError("DLQuery has wrong query type, expected retrieval or boolean query");
+  }
+
+
+  template <class GetRacerPool, class GetCache>
+  QueryBaseDirector*
+  RacerConceptAtom<GetRacerPool,GetCache>::getRetrievalDirector(std::iostream& stream) const
+  {
+    if (Registry::getFlags() & Registry::PREMISE)
       {
-	throw PluginError("DLQuery has wrong query type, expected retrieval or boolean query");
+	return new RacerPremiseQuery(stream);
       }
 
-    return this->cacheQuery(comp);
+    return new RacerConceptQuery(stream);
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerRoleAtom<GetKBManager,GetCache>::RacerRoleAtom(std::string name, std::iostream& s)
-    : RacerCachingAtom<GetKBManager,GetCache>(name, s)
+  template <class GetRacerPool, class GetCache>
+  RacerRoleAtom<GetRacerPool,GetCache>::RacerRoleAtom(std::string name)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlR[kb,plusC,minusC,plusR,minusR,query](X,Y)
@@ -341,13 +466,13 @@ namespace racer {
   }
 
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerRoleAtom<GetKBManager,GetCache>::getDirectors(const dlvhex::dl::Query& query) const
+  RacerRoleAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const
   {
     const DLQuery::shared_pointer& dlq = query.getDLQuery();
 
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(query, comp);
@@ -356,27 +481,17 @@ namespace racer {
 
     if (!dlq->isConjQuery() && !dlq->isUnionConjQuery()) // positive role queries are old-school queries
     {
-	this->increaseABox(query, comp);
-	
-	if (dlq->isRetrieval()) // retrieval mode
-	{
-	    comp->add(new RacerRoleQuery(this->stream));
-	}
-	else if (dlq->isBoolean()) // boolean query mode
-	{
-	    comp->add(new RacerIsRoleQuery(this->stream));
-	}
-	else if (dlq->isMixed()) // pattern retrieval mode
+	// the premise of a retrieve-under-premise query carries the input
+	if (!(Registry::getFlags() & Registry::PREMISE))
 	{
-	    comp->add(new RacerIndvFillersQuery(this->stream));
-	}
-	else
-	{
-	    throw PluginError("DLQuery has wrong query type, expected retrieval, boolean or mixed query");
+	    this->increaseABox(query, comp);
 	}
 
-	// good news, in this setting, we can reuse our cache
-	return this->cacheQuery(comp);
+	comp->add(getQueryDirector(query, stream));
+
+	// good news, in this setting, we can reuse our cache, and
+	// bursts of boolean queries may ask for all pairs at once
+	return this->promoteQuery(query, stream, this->cacheQuery(query, comp));
     } 
     else // negative role queries (not R) are conjunctive queries due to a racer bug
     {
@@ -386,18 +501,63 @@ namespace racer {
 	// because Racer can handle (not R) in nRQLs.
 	comp->add
 	    (new QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLConjunctionBuilder> >,
-	     RacerAnswerDriver>(this->stream)
+	     RacerAnswerDriver>(stream)
 	    );
 
-	///@todo right now we don't cache role queries, because the (not R) stuff can only be handled in CQs
-	return comp;
+	// the canonical form of (not R) is shared with the equivalent CQ
+	return this->cacheQuery(query, comp);
     }
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerDatatypeRoleAtom<GetKBManager,GetCache>::RacerDatatypeRoleAtom(std::string name, std::iostream& s)
-    : RacerCachingAtom<GetKBManager,GetCache>(name, s)
+  template <class GetRacerPool, class GetCache>
+  QueryBaseDirector*
+  RacerRoleAtom<GetRacerPool,GetCache>::getQueryDirector(const dlvhex::dl::Query& query, std::iostream& stream) const
+  {
+    const DLQuery::shared_pointer& dlq = query.getDLQuery();
+
+    if (dlq->isConjQuery() || dlq->isUnionConjQuery()) // negative role queries
+      {
+	return 0;
+      }
+    else if (Registry::getFlags() & Registry::PREMISE)
+      {
+	// pose the role query under the premise of the input
+	return new RacerPremiseQuery(stream);
+      }
+    else if (dlq->isRetrieval()) // retrieval mode
+      {
+	return new RacerRoleQuery(stream);
+      }
+    else if (dlq->isBoolean()) // boolean query mode
+      {
+	return new RacerIsRoleQuery(stream);
+      }
+    else if (dlq->isMixed()) // pattern retrieval mode
+      {
+	return new RacerIndvFillersQuery(stream);
+      }
+
+    throw PluginError("DLQuery has wrong query type, expected retrieval, boolean or mixed query");
+  }
+
+
+  template <class GetRacerPool, class GetCache>
+  QueryBaseDirector*
+  RacerRoleAtom<GetRacerPool,GetCache>::getRetrievalDirector(std::iostream& stream) const
+  {
+    if (Registry::getFlags() & Registry::PREMISE)
+      {
+	return new RacerPremiseQuery(stream);
+      }
+
+    return new RacerRoleQuery(stream);
+  }
+
+
+  template <class GetRacerPool, class GetCache>
+  RacerDatatypeRoleAtom<GetRacerPool,GetCache>::RacerDatatypeRoleAtom(std::string name)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlDR[kb,plusC,minusC,plusR,minusR,query](X,Y)
@@ -414,37 +574,26 @@ namespace racer {
   }
 
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   void
-  RacerDatatypeRoleAtom<GetKBManager,GetCache>::setupRacer(QueryCompositeDirector::shared_pointer& comp) const
+  RacerDatatypeRoleAtom<GetRacerPool,GetCache>::setupRacer(QueryCompositeDirector::shared_pointer& comp) const
   {
-    RacerExtAtom<GetKBManager>::setupRacer(comp);
-
-    ///@todo we have to enable datasubstrate mirroring all the time as racer will be resetted all the time
-#if 0    
-    if (!Registry::getDataSubstrateMirroring())
-      {
-#endif // 0
-
-	// enable data substrate mirroring
-	comp->add(new QueryDirector<RacerFunAdapterBuilder<RacerDataSubstrateMirroringCmd>,
-		  RacerIgnoreAnswer>(this->stream)
-	  );
+    RacerExtAtom<GetRacerPool>::setupRacer(comp);
 
-#if 0	
-	Registry::setDataSubstrateMirroring(true);
-      }
-#endif // 0
+    // enable data substrate mirroring once per session
+    comp->add(new QueryDirector<RacerDataSubstrateMirroringBuilder,
+	      RacerIgnoreAnswer>(comp->getStream())
+      );
   }
 
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerDatatypeRoleAtom<GetKBManager,GetCache>::getDirectors(const dlvhex::dl::Query& query) const
+  RacerDatatypeRoleAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const
   {
     const DLQuery::shared_pointer& dlq = query.getDLQuery();
     
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(query, comp);
@@ -456,7 +605,7 @@ namespace racer {
 	// pose datatype role query
 	comp->add
 	  (new QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLDatatypeBuilder> >,
-	   RacerAnswerDriver>(this->stream)
+	   RacerAnswerDriver>(stream)
 	  );
       }
     else
@@ -464,14 +613,16 @@ namespace racer {
 	throw PluginError("DLQuery has wrong query type, expected retrieval or mixed query");
       }
     
-    ///@todo right now we don't cache datatype queries
-    return comp;
+    // datatype fillers are not individuals, so keep them apart in the cache
+    dlq->setDatatype();
+
+    return this->cacheQuery(query, comp);
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerCQAtom<GetKBManager,GetCache>::RacerCQAtom(std::string name, std::iostream& s, unsigned n)
-    : RacerCachingAtom<GetKBManager,GetCache>(name, s)
+  template <class GetRacerPool, class GetCache>
+  RacerCQAtom<GetRacerPool,GetCache>::RacerCQAtom(std::string name, unsigned n)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlCQn[kb,plusC,minusC,plusR,minusR,query](X_1,...,X_n)
@@ -488,11 +639,11 @@ namespace racer {
   }
   
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerCQAtom<GetKBManager,GetCache>::getDirectors(const dlvhex::dl::Query& query) const
+  RacerCQAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const
   {
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(query, comp);
@@ -502,17 +653,17 @@ namespace racer {
     // pose a conjunctive query
     comp->add
       (new QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLConjunctionBuilder> >,
-       RacerAnswerDriver>(this->stream)
+       RacerAnswerDriver>(stream)
       );
   
-    ///@todo right now we don't cache conjunctive queries
-    return comp;
+    // renamed variants of a CQ share its canonical form, and so its cache entries
+    return this->cacheQuery(query, comp);
   }
 
 
-  template <class GetKBManager, class GetCache>
-  RacerUCQAtom<GetKBManager,GetCache>::RacerUCQAtom(std::string name, std::iostream& s, unsigned n)
-    : RacerCachingAtom<GetKBManager,GetCache>(name, s)
+  template <class GetRacerPool, class GetCache>
+  RacerUCQAtom<GetRacerPool,GetCache>::RacerUCQAtom(std::string name, unsigned n)
+    : RacerCachingAtom<GetRacerPool,GetCache>(name)
   {
     //
     // &dlUCQn[kb,plusC,minusC,plusR,minusR,query](X_1,...,X_n)
@@ -529,11 +680,11 @@ namespace racer {
   }
   
 
-  template <class GetKBManager, class GetCache>
+  template <class GetRacerPool, class GetCache>
   QueryBaseDirector::shared_pointer
-  RacerUCQAtom<GetKBManager,GetCache>::getDirectors(const dlvhex::dl::Query& query) const
+  RacerUCQAtom<GetRacerPool,GetCache>::getDirectors(const dlvhex::dl::Query& query, std::iostream& stream) const
   {
-    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(this->stream));
+    QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(stream));
     
     this->setupRacer(comp);
     this->openOntology(query, comp);
@@ -543,11 +694,11 @@ namespace racer {
     // pose a union of conjunctive queries
     comp->add
       (new QueryDirector<RacerAdapterBuilder<NRQLRetrieveUnderPremise<NRQLDisjunctionBuilder> >,
-       RacerAnswerDriver>(this->stream)
+       RacerAnswerDriver>(stream)
       );
 
-    ///@todo right now we don't cache conjunctive queries
-    return comp;
+    // renamed and reordered variants of a UCQ share its cache entries
+    return this->cacheQuery(query, comp);
   }
 
 
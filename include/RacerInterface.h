@@ -39,14 +39,9 @@
 #include "DFOutputBuilder.h"
 #include "HexDLConverter.h"
 
-namespace dlvhex {
+#include <boost/thread/thread.hpp>
 
-  //
-  // forward declaration
-  //
-  namespace util {
-    class TCPIOStream;
-  } //namespace util
+namespace dlvhex {
 
 namespace dl {
 
@@ -55,11 +50,16 @@ namespace dl {
   //
   class BaseCache;
   class CacheStats;
+  class CacheStore;
   class DLOptimizer;
-  class KBManager;
 
 namespace racer {
 
+  //
+  // forward declarations
+  //
+  class RacerPool;
+
 
   /**
    * @brief Concrete factory for the Plugin infrastructure.
@@ -76,12 +76,18 @@ namespace racer {
     // explicitly in the dtor of RacerInterface.
     //
 
-    /// the tcp streaming interface to the RACER server
-    dlvhex::util::TCPIOStream* stream;
+    /// the RACER servers
+    RacerPool* pool;
     /// the cache statistics
     CacheStats* stats;
     /// the cache for RACER queries
     BaseCache* cache;
+    /// memory budget of the cache in bytes, 0 for no limit
+    std::size_t cacheBudget;
+    /// filter the cached queries by popularity
+    bool cacheAdmission;
+    /// the dl-cache file which keeps answers across runs, may be 0
+    CacheStore* store;
     /// DL converter facility
     HexDLConverter* dlconverter;
     /// DF converter facility
@@ -89,13 +95,23 @@ namespace racer {
     dlvhex::df::DFOutputBuilder* dfoutputbuilder;
     /// DL optimizer facility
     DLOptimizer* dloptimizer;
-    /// the kb-manager for RACER
-    KBManager* kbManager;
 
     /// current ontology; moved to this level to be shared between the
     /// df-rewriter and the hex-rewriter
     dlvhex::dl::Ontology::shared_pointer ontology;
 
+    /// loads the ontologies of the program in the background, may be 0
+    boost::thread* preloading;
+
+    /**
+     * Loads the ontologies @a uris, their imports, and the ontology
+     * of --ontology, and opens them in the RACER servers.
+     *
+     * @param uris
+     */
+    void
+    loadOntologies(const std::vector<std::string>& uris);
+
     //
     // keep those ctors private, we don't want multiple instantiations
     //
@@ -125,13 +141,22 @@ namespace racer {
       return cache;
     }
 
-    ///@return the current KBManager
-    KBManager*
-    getKBManager() const
+    ///@return the pool of RACER servers
+    RacerPool*
+    getRacerPool() const
     {
-      return kbManager;
+      return pool;
     }
 
+    /**
+     * Starts loading the ontologies @a uris in the background, so
+     * the first dl-atoms do not have to wait for the whole load.
+     *
+     * @param uris
+     */
+    void
+    preload(const std::vector<std::string>& uris);
+
     /**
      * @return the DL converter.
      */
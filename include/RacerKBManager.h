@@ -64,7 +64,7 @@ namespace racer {
     RacerKBManager(std::iostream& s, const std::string& name = "");
 
     /** 
-     * Remove ABox #kbName from RACER.
+     * Remove all working ABoxes from RACER.
      */
     void
     removeKB() throw (DLError);
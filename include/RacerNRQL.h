@@ -213,6 +213,15 @@ namespace racer {
     /// Query object used to create the nRQL query
     const Query& query;
 
+    /** 
+     * output the body of #query to @a s, restricted to the
+     * candidates of #query if there are any.
+     * 
+     * @param s 
+     */
+    void
+    createRestrictedBody(std::ostream& s) const;
+
   public:
     /** 
      * Ctor.
@@ -36,6 +36,8 @@
 #include "Query.h"
 #include "KBManager.h"
 
+#include <sstream>
+
 namespace dlvhex {
 namespace dl {
 namespace racer {
@@ -47,6 +49,27 @@ namespace racer {
   { }
 
 
+  template <class Builder>
+  void
+  NRQLQuery<Builder>::createRestrictedBody(std::ostream& s) const
+  {
+    std::ostringstream filter;
+
+    if (this->builder.createFilter(filter, this->query))
+      {
+	s << "(and ";
+
+	this->builder.createBody(s, this->query);
+
+	s << ' ' << filter.str() << ')';
+      }
+    else
+      {
+	this->builder.createBody(s, this->query);
+      }
+  }
+
+
   template <class Builder>
   NRQLRetrieve<Builder>::NRQLRetrieve(const Query& q)
     : NRQLQuery<Builder>(q)
@@ -63,7 +86,7 @@ namespace racer {
 
     s << ") ";
 
-    this->builder.createBody(s, this->query);
+    this->createRestrictedBody(s);
   
     return s << " :abox " << this->query.getKBManager().getKBName() << ')';
   }
@@ -111,7 +134,7 @@ namespace racer {
 
     s << ") ";
 
-    this->builder.createBody(s, this->query);
+    this->createRestrictedBody(s);
     
     return s << " :abox |" << this->query.getDLQuery()->getOntology()->getRealURI() << "|)";
   }
@@ -36,6 +36,8 @@
 
 #include "DLError.h"
 
+#include <dlvhex2/ComfortPluginInterface.h>
+
 #include <iosfwd>
 
 namespace dlvhex {
@@ -99,6 +101,21 @@ namespace racer {
     virtual bool
     createPremise(std::ostream& stream, const Query& query) const
       throw(DLBuildingError);
+
+    /** 
+     * Uses the candidates of @a query and put a nRQL union into @a
+     * stream, which binds the variables of the output list to one of
+     * the candidates.
+     * 
+     * @param stream output the union to this stream
+     * @param query use this query
+     * 
+     * @return true if method created an output, false if the answers
+     * of @a query are not restricted.
+     */
+    virtual bool
+    createFilter(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
   };
 
 
@@ -123,6 +140,25 @@ namespace racer {
     virtual bool
     createPremise(std::ostream& stream, const Query& query) const
       throw(DLBuildingError);
+
+    /** 
+     * Put the ABox assertions which turn an ABox extended by @a
+     * current into one extended by the interpretation of @a query
+     * into @a stream, i.e., retractions for the assertions only in
+     * @a current and additions for the ones only in the
+     * interpretation.
+     * 
+     * @param stream output the ABox assertions to this stream
+     * @param query use this query
+     * @param current the assertions in the ABox
+     * 
+     * @return true if method created an output, false otherwise.
+     */
+    virtual bool
+    createDelta(std::ostream& stream,
+		const Query& query,
+		const ComfortInterpretation& current) const
+      throw(DLBuildingError);
   };
 
 
@@ -196,6 +232,16 @@ namespace racer {
     createHead(std::ostream& stream, const Query& query) const
       throw(DLBuildingError);
 
+    /** 
+     * The fillers are bound to substrate variables, which we
+     * cannot compare to individuals.
+     * 
+     * @return false
+     */
+    virtual bool
+    createFilter(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
+
     /** 
      * Uses @a query to build a datatype role query.
      * 
@@ -209,6 +255,75 @@ namespace racer {
       throw(DLBuildingError);
   };
 
+  /**
+   * @brief Builds nRQL queries for concept and role queries, i.e.,
+   * retrieval, boolean, and mixed queries of dlC and dlR atoms.
+   */
+  class NRQLConceptRoleBuilder : public NRQLBaseBuilder
+  {
+  public:
+    NRQLConceptRoleBuilder () : NRQLBaseBuilder()
+    { }
+
+    /** 
+     * Uses the variables in the output list of @a query to build the
+     * head expression. Boolean queries get an empty head.
+     * 
+     * @param stream output the head expression to this stream
+     * @param query  use this query
+     * 
+     * @return true if method created an output, false otherwise.
+     */
+    virtual bool
+    createHead(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
+
+    /** 
+     * Uses @a query to build a single concept or role query atom.
+     * 
+     * @param stream output the query atom to this stream
+     * @param query  use this query
+     * 
+     * @return true
+     */
+    virtual bool
+    createBody(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
+  };
+
+
+  /**
+   * @brief Builds a boolean nRQL query which holds iff the ABox is
+   * consistent.
+   */
+  class NRQLConsistencyBuilder : public NRQLBaseBuilder
+  {
+  public:
+    NRQLConsistencyBuilder () : NRQLBaseBuilder()
+    { }
+
+    /** 
+     * Boolean queries have an empty head.
+     * 
+     * @return false
+     */
+    virtual bool
+    createHead(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
+
+    /** 
+     * Outputs the trivially true query.
+     * 
+     * @param stream output the query to this stream
+     * @param query  use this query
+     * 
+     * @return true
+     */
+    virtual bool
+    createBody(std::ostream& stream, const Query& query) const
+      throw(DLBuildingError);
+  };
+
 } // namespace racer
 } // namespace dl
 } // namespace dlvhex
@@ -0,0 +1,271 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ * 
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+
+/**
+ * @file   RacerPool.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 10:12:31 2026
+ * 
+ * @brief  A pool of RACER backends.
+ * 
+ * 
+ */
+
+#ifndef _RACERPOOL_H
+#define _RACERPOOL_H
+
+#include "Ontology.h"
+#include "DLError.h"
+#include "TCPStream.h"
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace dlvhex {
+namespace dl {
+
+  //
+  // forward declaration
+  //
+  class KBManager;
+
+namespace racer {
+
+  /**
+   * @brief Keeps a list of RACER endpoints and dispatches dl-atom
+   * evaluations to them.
+   *
+   * Each backend has its own connection and its own KBManager, hence
+   * its own temporary ABox and session state. A backend is leased
+   * exclusively for a whole dl-atom evaluation. Whenever possible, a
+   * query is routed to a free backend which has the ontology of the
+   * query already loaded.
+   */
+  class RacerPool
+  {
+  public:
+    /// a RACER endpoint
+    struct Backend
+    {
+      /// connection to RACER
+      dlvhex::util::TCPIOStream* stream;
+      /// keeps track of the state of RACER
+      KBManager* kbManager;
+      /// leased by an evaluation
+      bool busy;
+    };
+
+    /**
+     * @brief Leases a backend of a RacerPool during its lifetime.
+     */
+    class Lease
+    {
+    private:
+      RacerPool& pool;
+      Backend& backend;
+
+      /// private copy ctor
+      Lease(const Lease&);
+
+      /// private assignment op
+      Lease&
+      operator= (const Lease&);
+
+    public:
+      /**
+       * Ctor. Blocks until a backend is free.
+       *
+       * @param p lease a backend of @a p
+       * @param onto prefer a backend which has @a onto loaded
+       */
+      Lease(RacerPool& p, const Ontology::shared_pointer& onto) throw (DLError);
+
+      /// Dtor, releases the backend.
+      ~Lease();
+
+      std::iostream&
+      getStream() const;
+
+      KBManager&
+      getKBManager() const;
+    };
+
+  private:
+    /// list of RACER endpoints
+    boost::ptr_vector<Backend> backends;
+
+    /// wrap the KBManager of each backend in a NullKBManager
+    bool reload;
+
+    /// deadline for each command in milliseconds
+    unsigned timeout;
+
+    /// number of working ABoxes of each backend
+    unsigned aboxes;
+
+    /// session file of the first backend, the others append .N
+    std::string session;
+
+    /// record or replay the sessions of the backends
+    dlvhex::util::TCPIOStream::SessionMode mode;
+
+    /// @return the session file of the @a i-th backend
+    std::string
+    sessionFile(std::size_t i) const;
+
+    /**
+     * Waits until @a b is free and opens @a ontos in it.
+     *
+     * @param b
+     * @param ontos
+     */
+    void
+    preloadBackend(Backend& b, const std::vector<Ontology::shared_pointer>& ontos);
+
+    /// protects #backends
+    mutable boost::mutex mutex;
+
+    /// signals released backends
+    boost::condition_variable released;
+
+    /// private copy ctor
+    RacerPool(const RacerPool&);
+
+    /// private assignment op
+    RacerPool&
+    operator= (const RacerPool&);
+
+  public:
+    /// Ctor, creates an empty pool.
+    RacerPool();
+
+    /// Dtor, removes the temporary ABoxes from RACER.
+    ~RacerPool();
+
+    /**
+     * Adds a new backend. Must not be called while a backend is
+     * leased.
+     *
+     * @param host RACER host
+     * @param port RACER port
+     */
+    void
+    addBackend(const std::string& host, unsigned port);
+
+    /**
+     * Removes all backends. Must not be called while a backend is
+     * leased.
+     */
+    void
+    clear();
+
+    /**
+     * Force reloading of ontologies in all backends.
+     *
+     * @see NullKBManager
+     */
+    void
+    setReload();
+
+    /**
+     * Set the deadline for each command sent to the backends.
+     *
+     * @param ms milliseconds, 0 turns off deadlines
+     */
+    void
+    setTimeout(unsigned ms);
+
+    /**
+     * Set the number of working ABoxes each backend keeps in RACER.
+     *
+     * @param n at least one
+     *
+     * @see KBManager::selectWorkingABox
+     */
+    void
+    setWorkingABoxes(unsigned n);
+
+    /**
+     * Record the conversation with each backend into a session file,
+     * or replay it from there without talking to RACER.
+     *
+     * @param file session file of the first backend, the other
+     * backends use file.1, file.2, ...
+     * @param m the session mode
+     *
+     * @see dlvhex::util::TCPIOStream::setSession
+     */
+    void
+    setSession(const std::string& file, dlvhex::util::TCPIOStream::SessionMode m);
+
+    /// @return the number of backends
+    std::size_t
+    size() const;
+
+    /**
+     * Waits for a free backend and marks it as busy.
+     *
+     * @param onto the ontology of the query, may be empty
+     *
+     * @return a free backend, which has @a onto already loaded if
+     * such a backend is free.
+     */
+    Backend&
+    acquire(const Ontology::shared_pointer& onto) throw (DLError);
+
+    /**
+     * Marks @a b as free.
+     *
+     * @param b
+     */
+    void
+    release(Backend& b);
+
+    /**
+     * Opens @a ontos in every backend before the first dl-atom asks
+     * for them. The backends are loaded concurrently, a dl-atom
+     * evaluation waits for a backend which is still loading. Does
+     * nothing if ontologies are reloaded for each query, or if the
+     * sessions are recorded or replayed.
+     *
+     * @param ontos
+     */
+    void
+    preload(const std::vector<Ontology::shared_pointer>& ontos);
+  };
+
+} // namespace racer
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _RACERPOOL_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -462,6 +462,54 @@ namespace racer {
   };
 
 
+  /**
+   * forget concept assertion.
+   */
+  class ABoxForgetConceptAssertion : public ABoxAssertion
+  {
+  private:
+    const ABoxConceptDescrExpr::shared_pointer cExpr;
+    const ABoxQueryIndividual::shared_pointer iExpr;
+    const std::string& abox;
+
+  protected:
+    std::ostream&
+    output(std::ostream& s) const;
+
+  public:
+    ABoxForgetConceptAssertion(ABoxConceptDescrExpr::const_pointer c,
+			       ABoxQueryIndividual::const_pointer i,
+			       const std::string& a)
+      : cExpr(c), iExpr(i), abox(a)
+    { }
+  };
+
+
+  /**
+   * forget role assertion.
+   */
+  class ABoxForgetRoleAssertion : public ABoxAssertion
+  {
+  private:
+    const ABoxRoleDescrExpr::shared_pointer rExpr;
+    const ABoxQueryIndividual::shared_pointer i1Expr;
+    const ABoxQueryIndividual::shared_pointer i2Expr;
+    const std::string& abox;
+
+  protected:
+    std::ostream&
+    output(std::ostream& s) const;
+
+  public:
+    ABoxForgetRoleAssertion(ABoxRoleDescrExpr::const_pointer r,
+			    ABoxQueryIndividual::const_pointer i1,
+			    ABoxQueryIndividual::const_pointer i2,
+			    const std::string& a)
+      : rExpr(r), i1Expr(i1), i2Expr(i2), abox(a)
+    { }
+  };
+
+
   /**
    * Base class for simple and complex query expressions.
    */
@@ -49,10 +49,6 @@ namespace dl {
     static unsigned flags;
     /// verbosity level
     static unsigned verbose;
-    /// did we set UNA?
-    static bool una;
-    /// did we set datasubstrate mirroring?
-    static bool datasubstrate;
 
     /// pure virtual dtor, we don't want an instance or a child
     virtual
@@ -62,7 +58,13 @@ namespace dl {
     /// flags for the Registry
     enum
       {
-	UNA = 0x1
+	UNA = 0x1,
+	PIPELINE = 0x2, ///< pipeline the commands of a QueryCompositeDirector
+	ABOXDELTA = 0x4, ///< update the working ABox instead of cloning it
+	PREMISE = 0x8, ///< evaluate dl-atoms with a single retrieve-under-premise
+	COALESCE = 0x10, ///< evaluate the siblings of a dl-atom along with it
+	PROMOTE = 0x20, ///< answer bursts of boolean dl-atoms with one retrieval
+	PRELOAD = 0x40 ///< load the ontologies of the program before the first dl-atom
       };
 
     static void
@@ -76,18 +78,6 @@ namespace dl {
 
     static void
     setVerbose(unsigned);
-
-    static bool
-    getUNA();
-
-    static void
-    setUNA(bool);
-
-    static bool
-    getDataSubstrateMirroring();
-
-    static void
-    setDataSubstrateMirroring(bool);
   };
 
 } // namespace dl
@@ -0,0 +1,179 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SessionStream.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 10:12:40 2026
+ *
+ * @brief  Record and replay the conversation of a TCPStreamBuf.
+ *
+ *
+ */
+
+#ifndef _SESSIONSTREAM_H
+#define _SESSIONSTREAM_H
+
+#include "TCPStream.h"
+
+#include <string>
+#include <fstream>
+
+
+namespace dlvhex {
+namespace util {
+
+  /**
+   * @brief A TCPStreamBuf which writes everything it sends and
+   * receives to a session file.
+   *
+   * The session file consists of records
+   *
+   *   > MS LEN\\n BYTES\\n   for LEN sent bytes, and
+   *   < MS LEN\\n BYTES\\n   for LEN received bytes,
+   *
+   * where MS is the time in milliseconds since the session started.
+   * Each '>' record is one round trip to the peer.
+   */
+  class RecordingStreamBuf : public TCPStreamBuf
+  {
+  private:
+    /// the session file
+    std::ofstream session;
+    /// start of the session in milliseconds (monotonic clock)
+    long long start;
+
+    /// appends a record of @a n bytes at @a s of direction @a dir
+    void
+    record(char dir, const std::streambuf::char_type* s, std::streamsize n);
+
+    /// private copy ctor
+    RecordingStreamBuf(const RecordingStreamBuf&);
+
+  protected:
+    virtual void
+    transmit(const std::streambuf::char_type* s, std::streamsize n);
+
+    virtual std::streamsize
+    fetch(std::streambuf::char_type* s, std::streamsize n);
+
+  public:
+    /**
+     * Ctor.
+     *
+     * @param host connect to this host
+     * @param port connect to this port
+     * @param file record the session into this file
+     *
+     * Throws std::ios_base::failure if @a file cannot be written.
+     */
+    RecordingStreamBuf(const std::string& host,
+		       unsigned port,
+		       const std::string& file);
+  };
+
+
+  /**
+   * @brief A TCPStreamBuf which never connects but serves the
+   * answers of a session file written by RecordingStreamBuf.
+   *
+   * The commands sent to a ReplayStreamBuf must be the recorded ones,
+   * otherwise it throws std::ios_base::failure. The i-th recorded
+   * answer line becomes available as soon as i command lines are
+   * sent, so the replay does not depend on how the commands are split
+   * into round trips. A different number of round trips or unsent
+   * commands are reported to std::cerr when the buffer is destroyed.
+   */
+  class ReplayStreamBuf : public TCPStreamBuf
+  {
+  private:
+    /// the session file
+    const std::string file;
+
+    /// the recorded command stream
+    std::string commands;
+    /// the recorded answer stream
+    std::string answers;
+
+    /// number of sent bytes of #commands
+    std::string::size_type sent;
+    /// number of served bytes of #answers
+    std::string::size_type served;
+    /// end of the answers which may be served by now
+    std::string::size_type available;
+
+    /// number of recorded round trips
+    unsigned recorded;
+    /// number of replayed round trips
+    unsigned replayed;
+
+    /// reads the session #file
+    void
+    load();
+
+    /// private copy ctor
+    ReplayStreamBuf(const ReplayStreamBuf&);
+
+  protected:
+    virtual void
+    transmit(const std::streambuf::char_type* s, std::streamsize n);
+
+    virtual std::streamsize
+    fetch(std::streambuf::char_type* s, std::streamsize n);
+
+  public:
+    /**
+     * Ctor.
+     *
+     * @param host pretend to be connected to this host
+     * @param port pretend to be connected to this port
+     * @param file replay the session in this file
+     *
+     * Throws std::ios_base::failure if @a file cannot be read.
+     */
+    ReplayStreamBuf(const std::string& host,
+		    unsigned port,
+		    const std::string& file);
+
+    /// Dtor, reports the differences to the recorded session.
+    virtual
+    ~ReplayStreamBuf();
+
+    /// @return true, there is nothing to connect to.
+    virtual bool
+    open();
+
+    /// @return true, there is nothing to connect to.
+    virtual bool
+    isOpen() const;
+  };
+
+} // namespace util
+} // namespace dlvhex
+
+
+#endif /* _SESSIONSTREAM_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
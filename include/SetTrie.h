@@ -0,0 +1,229 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SetTrie.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 14:31:05 2026
+ *
+ * @brief  A trie of sets which answers subset and superset queries.
+ *
+ *
+ */
+
+
+#ifndef _SETTRIE_H
+#define _SETTRIE_H
+
+#include <map>
+#include <vector>
+#include <utility>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief Maps sets of IDs to values of type @a T.
+   *
+   * A set is stored as path of its IDs in ascending order, hence
+   * sets with a common prefix share nodes. Finding a stored subset or
+   * superset of a set only visits the paths which may lead to one.
+   * Each node keeps a 64-bit signature of the IDs below it, which
+   * rejects subtrees without a superset in O(1).
+   *
+   * @see I. Savnik. Index Data Structure for Fast Subset and Superset
+   * Queries. In CD-ARES 2013, volume 8127 of LNCS, pages 134-148.
+   * Springer, 2013.
+   */
+  template <class T>
+  class SetTrie
+  {
+  public:
+    /// a set of IDs in ascending order
+    typedef std::vector<unsigned> Key;
+
+    /// a stored set and its value
+    typedef std::pair<Key, T> Entry;
+
+  private:
+    struct Node
+    {
+      typedef std::map<unsigned, Node*> Children;
+
+      /// children ordered by their ID
+      Children children;
+      /// the value of the set ending in this node
+      T value;
+      /// true if a set ends in this node
+      bool hasValue;
+      /// number of sets ending in this subtree
+      std::size_t size;
+      /// signature of the IDs of the children and their subtrees
+      unsigned long long below;
+
+      Node()
+	: children(), value(), hasValue(false), size(0), below(0)
+      { }
+
+      ~Node();
+
+      /// recomputes #below from the children
+      void
+      sign();
+    };
+
+    /// the empty set
+    Node root;
+
+    /// @return the signature bit of @a id
+    static unsigned long long
+    bit(unsigned id)
+    {
+      return 1ULL << (id % 64);
+    }
+
+    /**
+     * @param k
+     * @param sig gets the signature of k[i], k[i+1], ... at position i
+     */
+    static void
+    suffixes(const Key& k, std::vector<unsigned long long>& sig);
+
+    const T*
+    findSubset(const Node& n, const Key& k, std::size_t pos) const;
+
+    const T*
+    findSuperset(const Node& n, const Key& k, std::size_t pos,
+		 const std::vector<unsigned long long>& sig) const;
+
+    const T*
+    any(const Node& n) const;
+
+    void
+    subsets(const Node& n, const Key& k, std::size_t pos,
+	    Key& path, std::vector<Entry>& out) const;
+
+    void
+    supersets(const Node& n, const Key& k, std::size_t pos,
+	      const std::vector<unsigned long long>& sig,
+	      Key& path, std::vector<Entry>& out) const;
+
+    bool
+    erase(Node& n, const Key& k, std::size_t pos);
+
+    /// private copy ctor
+    SetTrie(const SetTrie&);
+
+    /// private assignment op
+    SetTrie&
+    operator= (const SetTrie&);
+
+  public:
+    /// Ctor, creates an empty trie.
+    SetTrie()
+      : root()
+    { }
+
+    /**
+     * @param k
+     * @param v
+     *
+     * @return false if @a k is already stored, @a v is dropped then.
+     */
+    bool
+    insert(const Key& k, const T& v);
+
+    /**
+     * @param k
+     *
+     * @return false if @a k was not stored.
+     */
+    bool
+    erase(const Key& k);
+
+    /// @return the value of @a k, 0 if @a k is not stored.
+    const T*
+    find(const Key& k) const;
+
+    /// @return the value of a stored subset of @a k, 0 if there is none.
+    const T*
+    findSubset(const Key& k) const
+    {
+      return findSubset(root, k, 0);
+    }
+
+    /// @return the value of a stored superset of @a k, 0 if there is none.
+    const T*
+    findSuperset(const Key& k) const
+    {
+      std::vector<unsigned long long> sig;
+      suffixes(k, sig);
+      return findSuperset(root, k, 0, sig);
+    }
+
+    /// @param out gets all stored subsets of @a k
+    void
+    subsets(const Key& k, std::vector<Entry>& out) const
+    {
+      Key path;
+      subsets(root, k, 0, path, out);
+    }
+
+    /// @param out gets all stored supersets of @a k
+    void
+    supersets(const Key& k, std::vector<Entry>& out) const
+    {
+      std::vector<unsigned long long> sig;
+      suffixes(k, sig);
+      Key path;
+      supersets(root, k, 0, sig, path, out);
+    }
+
+    /// @param out gets all stored sets
+    void
+    entries(std::vector<Entry>& out) const
+    {
+      supersets(Key(), out);
+    }
+
+    /// @return the number of stored sets
+    std::size_t
+    size() const
+    {
+      return root.size;
+    }
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+
+// include the implemantation of the templates
+#include "SetTrie.tcc"
+
+
+#endif /* _SETTRIE_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -0,0 +1,317 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SetTrie.tcc
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 14:31:05 2026
+ *
+ * @brief  Template implementation for SetTrie class.
+ *
+ *
+ */
+
+#ifndef _SETTRIE_TCC
+#define _SETTRIE_TCC
+
+namespace dlvhex {
+namespace dl {
+
+  template <class T>
+  SetTrie<T>::Node::~Node()
+  {
+    for (typename Children::iterator it = children.begin(); it != children.end(); ++it)
+      {
+	delete it->second;
+      }
+  }
+
+
+  template <class T>
+  void
+  SetTrie<T>::Node::sign()
+  {
+    below = 0;
+
+    for (typename Children::const_iterator it = children.begin(); it != children.end(); ++it)
+      {
+	below |= bit(it->first) | it->second->below;
+      }
+  }
+
+
+  template <class T>
+  void
+  SetTrie<T>::suffixes(const Key& k, std::vector<unsigned long long>& sig)
+  {
+    sig.assign(k.size() + 1, 0);
+
+    for (std::size_t i = k.size(); i > 0; --i)
+      {
+	sig[i - 1] = sig[i] | bit(k[i - 1]);
+      }
+  }
+
+
+  template <class T>
+  bool
+  SetTrie<T>::insert(const Key& k, const T& v)
+  {
+    std::vector<Node*> path(1, &root);
+
+    for (Key::const_iterator it = k.begin(); it != k.end(); ++it)
+      {
+	Node*& child = path.back()->children[*it];
+
+	if (child == 0)
+	  {
+	    child = new Node;
+	  }
+
+	path.push_back(child);
+      }
+
+    if (path.back()->hasValue)
+      {
+	return false;
+      }
+
+    path.back()->value = v;
+    path.back()->hasValue = true;
+
+    std::vector<unsigned long long> sig;
+    suffixes(k, sig);
+
+    for (std::size_t i = 0; i < path.size(); ++i)
+      {
+	++path[i]->size;
+	path[i]->below |= sig[i]; // the IDs of k below path[i]
+      }
+
+    return true;
+  }
+
+
+  template <class T>
+  bool
+  SetTrie<T>::erase(const Key& k)
+  {
+    return erase(root, k, 0);
+  }
+
+
+  template <class T>
+  bool
+  SetTrie<T>::erase(Node& n, const Key& k, std::size_t pos)
+  {
+    if (pos == k.size())
+      {
+	if (!n.hasValue)
+	  {
+	    return false;
+	  }
+
+	n.value = T();
+	n.hasValue = false;
+      }
+    else
+      {
+	typename Node::Children::iterator it = n.children.find(k[pos]);
+
+	if (it == n.children.end() || !erase(*it->second, k, pos + 1))
+	  {
+	    return false;
+	  }
+
+	if (it->second->size == 0) // prune the empty subtree
+	  {
+	    delete it->second;
+	    n.children.erase(it);
+	  }
+
+	n.sign();
+      }
+
+    --n.size;
+    return true;
+  }
+
+
+  template <class T>
+  const T*
+  SetTrie<T>::find(const Key& k) const
+  {
+    const Node* n = &root;
+
+    for (Key::const_iterator it = k.begin(); it != k.end(); ++it)
+      {
+	typename Node::Children::const_iterator c = n->children.find(*it);
+
+	if (c == n->children.end())
+	  {
+	    return 0;
+	  }
+
+	n = c->second;
+      }
+
+    return n->hasValue ? &n->value : 0;
+  }
+
+
+  template <class T>
+  const T*
+  SetTrie<T>::findSubset(const Node& n, const Key& k, std::size_t pos) const
+  {
+    if (n.hasValue)
+      {
+	return &n.value;
+      }
+
+    // follow each remaining ID of k which has a child
+    for (; pos < k.size(); ++pos)
+      {
+	typename Node::Children::const_iterator c = n.children.find(k[pos]);
+
+	if (c != n.children.end())
+	  {
+	    const T* v = findSubset(*c->second, k, pos + 1);
+
+	    if (v)
+	      {
+		return v;
+	      }
+	  }
+      }
+
+    return 0;
+  }
+
+
+  template <class T>
+  const T*
+  SetTrie<T>::any(const Node& n) const
+  {
+    if (n.hasValue)
+      {
+	return &n.value;
+      }
+
+    // a non-empty trie has a value in each leaf
+    return n.children.empty() ? 0 : any(*n.children.begin()->second);
+  }
+
+
+  template <class T>
+  const T*
+  SetTrie<T>::findSuperset(const Node& n, const Key& k, std::size_t pos,
+			   const std::vector<unsigned long long>& sig) const
+  {
+    if (pos == k.size()) // every set below n contains k
+      {
+	return any(n);
+      }
+
+    if (sig[pos] & ~n.below) // some ID of k is missing below n
+      {
+	return 0;
+      }
+
+    // children with smaller IDs may still lead to k[pos], larger ones not
+    typename Node::Children::const_iterator end = n.children.upper_bound(k[pos]);
+
+    for (typename Node::Children::const_iterator c = n.children.begin(); c != end; ++c)
+      {
+	const T* v = findSuperset(*c->second, k, c->first == k[pos] ? pos + 1 : pos, sig);
+
+	if (v)
+	  {
+	    return v;
+	  }
+      }
+
+    return 0;
+  }
+
+
+  template <class T>
+  void
+  SetTrie<T>::subsets(const Node& n, const Key& k, std::size_t pos,
+		      Key& path, std::vector<Entry>& out) const
+  {
+    if (n.hasValue)
+      {
+	out.push_back(std::make_pair(path, n.value));
+      }
+
+    for (; pos < k.size(); ++pos)
+      {
+	typename Node::Children::const_iterator c = n.children.find(k[pos]);
+
+	if (c != n.children.end())
+	  {
+	    path.push_back(c->first);
+	    subsets(*c->second, k, pos + 1, path, out);
+	    path.pop_back();
+	  }
+      }
+  }
+
+
+  template <class T>
+  void
+  SetTrie<T>::supersets(const Node& n, const Key& k, std::size_t pos,
+			const std::vector<unsigned long long>& sig,
+			Key& path, std::vector<Entry>& out) const
+  {
+    if (n.hasValue && pos == k.size())
+      {
+	out.push_back(std::make_pair(path, n.value));
+      }
+
+    if (sig[pos] & ~n.below) // some ID of k is missing below n
+      {
+	return;
+      }
+
+    typename Node::Children::const_iterator end =
+      pos == k.size() ? n.children.end() : n.children.upper_bound(k[pos]);
+
+    for (typename Node::Children::const_iterator c = n.children.begin(); c != end; ++c)
+      {
+	path.push_back(c->first);
+	supersets(*c->second, k,
+		  pos < k.size() && c->first == k[pos] ? pos + 1 : pos,
+		  sig, path, out);
+	path.pop_back();
+      }
+  }
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _SETTRIE_TCC */
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -0,0 +1,114 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SymbolTable.h
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 22:05:31 2026
+ *
+ * @brief  Process-wide interning of terms.
+ *
+ *
+ */
+
+
+#ifndef _SYMBOLTABLE_H
+#define _SYMBOLTABLE_H
+
+#include <dlvhex2/ComfortPluginInterface.h>
+
+#include <string>
+#include <vector>
+
+namespace dlvhex {
+namespace dl {
+
+  /**
+   * @brief Maps the terms of all ontologies, queries and answers to
+   * dense 32-bit IDs.
+   *
+   * The IDs are handed out in the order the terms are seen and stay
+   * valid until the process ends, hence terms may be compared and
+   * hashed by their IDs. The table may be used by all threads of the
+   * RacerPool, lookups of known terms do not block each other.
+   */
+  class SymbolTable
+  {
+  private:
+    /// pure virtual dtor, we don't want an instance or a child
+    virtual
+    ~SymbolTable() = 0;
+
+  public:
+    /// the strong negation flag and the term IDs of an atom
+    typedef std::vector<unsigned> AtomKey;
+
+    /**
+     * @param t
+     *
+     * @return the ID of @a t, a fresh one if we haven't seen it yet
+     */
+    static unsigned
+    intern(const ComfortTerm& t);
+
+    /**
+     * Interns the terms of all atoms of @a i at once.
+     *
+     * @param i
+     * @param keys gets the AtomKey of each atom of @a i, in the order of @a i
+     */
+    static void
+    intern(const ComfortInterpretation& i, std::vector<AtomKey>& keys);
+
+    /**
+     * Looks up @a t without interning it.
+     *
+     * @param t
+     * @param id gets the ID of @a t
+     *
+     * @return false if @a t was never interned
+     */
+    static bool
+    find(const ComfortTerm& t, unsigned& id);
+
+    /**
+     * @param id
+     *
+     * @return the term of @a id
+     */
+    static ComfortTerm
+    getTerm(unsigned id);
+
+    /// @return the number of interned terms
+    static std::size_t
+    size();
+  };
+
+} // namespace dl
+} // namespace dlvhex
+
+#endif /* _SYMBOLTABLE_H */
+
+
+// Local Variables:
+// mode: C++
+// End:
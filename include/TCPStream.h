@@ -36,6 +36,9 @@
 #include <string>
 #include <streambuf>
 #include <iostream>
+#include <map>
+
+#include <netinet/in.h> // struct sockaddr_in
 
 
 namespace dlvhex {
@@ -48,6 +51,11 @@ namespace util {
    * output character stream. The connection is going to be
    * established in a lazy manner, i.e. only when something is
    * actually sent or received.
+   *
+   * The socket is non-blocking and we wait for it with epoll(7), so
+   * each command may be subject to a deadline. If the peer does not
+   * respond in time, the connection is closed and a
+   * dlvhex::dl::DLTimeoutError is thrown.
    */
   class TCPStreamBuf : public std::streambuf
   {
@@ -59,19 +67,80 @@ namespace util {
     
     /// TCP Socket filedescriptor
     int sockfd;
+    /// epoll filedescriptor for #sockfd
+    int epfd;
+
+    /// address of host:port, resolved once
+    struct sockaddr_in addr;
+    /// true if #addr is valid
+    bool resolved;
 
-    /// size of i/o sequences
-    std::streamsize bufsize;
+    /// size of output sequence
+    std::streamsize obufsize;
+    /// size of input sequence
+    std::streamsize ibufsize;
 
     /// output character sequence
     std::streambuf::char_type* obuf;
     /// input character sequence
     std::streambuf::char_type* ibuf;
+    /// end of the received data in #ibuf
+    std::streambuf::char_type* iend;
+
+    /// keep the output sequence in #obuf on sync()
+    bool corked;
+
+    /// deadline for each command in milliseconds, 0 means no deadline
+    unsigned timeout;
+    /// the current deadline in milliseconds (monotonic clock)
+    long long deadline;
 
     /// Allocates the buffers at initialization time.
     void
     initBuffers();
 
+    /// Resolves #host once and fills #addr.
+    void
+    resolve();
+
+    /// Arms #deadline for the next answer.
+    void
+    arm();
+
+    /**
+     * Waits for @a events on #sockfd until #deadline.
+     *
+     * @param events EPOLLIN or EPOLLOUT
+     */
+    void
+    wait(unsigned events);
+
+    /**
+     * Sends the pending output sequence to the peer.
+     *
+     * @return -1 on failure.
+     */
+    std::streambuf::int_type
+    sendOutput();
+
+    /**
+     * @param b start of an answer in #ibuf
+     *
+     * @return the end of the answer starting at @a b, i.e., the
+     * position right after the next newline, or #iend if the answer
+     * is incomplete.
+     */
+    std::streambuf::char_type*
+    answerEnd(std::streambuf::char_type* b) const;
+
+    /**
+     * Receives more input. The unconsumed part of the current answer
+     * is moved to the front of #ibuf, which grows if it cannot hold
+     * the answer any longer, so an answer always stays contiguous.
+     */
+    void
+    receive();
+
     /// private assignment op
     TCPStreamBuf&
     operator= (const TCPStreamBuf&);
@@ -79,7 +148,32 @@ namespace util {
 
   protected:
     /**
-     * Called when output buffer is full.
+     * Sends @a n characters starting at @a s to the peer.
+     *
+     * @param s
+     * @param n
+     *
+     * Throws std::ios_base::failure if the connection broke.
+     */
+    virtual void
+    transmit(const std::streambuf::char_type* s, std::streamsize n);
+
+    /**
+     * Receives at most @a n characters into @a s. Waits until
+     * something is available or the deadline passed.
+     *
+     * @param s
+     * @param n
+     *
+     * @return the number of received characters, which is positive.
+     * Throws std::ios_base::failure if the connection broke.
+     */
+    virtual std::streamsize
+    fetch(std::streambuf::char_type* s, std::streamsize n);
+
+    /**
+     * Called when output buffer is full. If the stream is corked,
+     * the output buffer grows, otw. it will be sent.
      *
      * @param c put this character into the output buffer
      *
@@ -89,17 +183,20 @@ namespace util {
     overflow(std::streambuf::int_type c);
 
     /**
-     * Called when input buffer is empty.
+     * Called when the current answer in the input buffer is
+     * consumed. Answers are newline-terminated, hence we signal the
+     * end of an answer with traits::eof() and keep subsequent
+     * (pipelined) answers in the input buffer for the next read.
      *
      * @return first character of pending input or traits::eof() for
-     * no pending data.
+     * the end of the current answer.
      */
     virtual std::streambuf::int_type
     underflow();
 
     /**
-     * Called when output buffer needs syncronization and resets the
-     * input buffer.
+     * Called when output buffer needs syncronization. Does nothing
+     * while the stream is corked.
      *
      * @return -1 on failure.
      */
@@ -112,14 +209,14 @@ namespace util {
      *
      * @param host connect to this host
      * @param port connect to this port
-     * @param bufsize buffer bufsize bytes
+     * @param bufsize initial size of the buffers in bytes
      */
     explicit
     TCPStreamBuf(const std::string& host,
 		 unsigned port,
-		 std::streamsize bufsize = 256);
+		 std::streamsize bufsize = 65536);
 
-    /// Copy Ctor
+    /// Copy Ctor, the copy has its own connection
     TCPStreamBuf(const TCPStreamBuf& sb);
 
     /// Dtor
@@ -148,6 +245,45 @@ namespace util {
     virtual bool
     isOpen() const;
 
+    /**
+     * Cork or uncork the stream. While corked, flushing the stream
+     * does not send anything, so consecutive commands end up in a
+     * single send(). The pending output is sent as soon as we wait
+     * for an answer or the stream gets synced after uncorking.
+     *
+     * @param c true to cork, false to uncork
+     */
+    virtual void
+    cork(bool c);
+
+    /**
+     * Set the deadline for each command.
+     *
+     * @param ms milliseconds, 0 turns off deadlines
+     */
+    virtual void
+    setTimeout(unsigned ms);
+
+    /**
+     * Provides the complete current answer in place, i.e., without
+     * copying it out of the input buffer. Waits for the rest of the
+     * answer if necessary.
+     *
+     * @param b set to the first character of the answer
+     * @param e set to the position right after the terminating newline
+     *
+     * The range stays valid until the next read from this buffer.
+     */
+    virtual void
+    answer(const std::streambuf::char_type*& b,
+	   const std::streambuf::char_type*& e);
+
+    /**
+     * Skips the rest of the current answer, the next read starts
+     * with the subsequent (pipelined) answer.
+     */
+    virtual void
+    nextAnswer();
   };
 
 
@@ -156,6 +292,34 @@ namespace util {
    */
   class TCPIOStream : public std::iostream
   {
+  public:
+    /// what happens to the conversation with the peers
+    enum SessionMode
+      {
+	LIVE,   ///< just talk to the peers
+	RECORD, ///< talk to the peers and record the session
+	REPLAY  ///< replay a recorded session, don't connect
+      };
+
+  private:
+    typedef std::map<std::pair<std::string, unsigned>, TCPStreamBuf*> ConnectionMap;
+
+    /// keeps the connections alive across setConnection()
+    ConnectionMap connections;
+
+    /// deadline for each command in milliseconds
+    unsigned timeout;
+
+    /// session file, later connections append .N
+    std::string session;
+
+    /// the current session mode
+    SessionMode mode;
+
+    /// @return a new streambuf for host:port according to #mode
+    TCPStreamBuf*
+    createStreamBuf(const std::string& host, unsigned port) const;
+
   public:
     /// Default Ctor
     TCPIOStream(const std::string& host, unsigned port);
@@ -165,7 +329,8 @@ namespace util {
     ~TCPIOStream();
 
     /** 
-     * Setup a new connection to host:port.
+     * Setup a new connection to host:port. Previous connections
+     * stay open, so switching back to them does not reconnect.
      * 
      * @param host
      * @param port
@@ -178,6 +343,26 @@ namespace util {
      */
     bool
     isOpen() const;
+
+    /**
+     * Set the deadline for each command.
+     *
+     * @param ms milliseconds, 0 turns off deadlines
+     */
+    void
+    setTimeout(unsigned ms);
+
+    /**
+     * Record or replay the conversation with the peers. All
+     * connections are dropped and set up again in the new mode.
+     *
+     * @param file the session file
+     * @param m the session mode
+     *
+     * @see RecordingStreamBuf, ReplayStreamBuf
+     */
+    void
+    setSession(const std::string& file, SessionMode m);
   };
 
 } // namespace util
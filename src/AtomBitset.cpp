@@ -0,0 +1,139 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   AtomBitset.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 14:02:11 2026
+ *
+ * @brief  Interpretations as bitsets of interned atoms.
+ *
+ *
+ */
+
+
+#include "AtomBitset.h"
+
+using namespace dlvhex::dl;
+
+
+void
+AtomBitset::set(unsigned id)
+{
+  if (id / bits >= words.size())
+    {
+      words.resize(id / bits + 1, 0);
+    }
+
+  words[id / bits] |= word_type(1) << (id % bits);
+}
+
+
+bool
+AtomBitset::test(unsigned id) const
+{
+  return id / bits < words.size() && (words[id / bits] >> (id % bits)) & 1;
+}
+
+
+std::size_t
+AtomBitset::count() const
+{
+  std::size_t n = 0;
+
+  for (std::vector<word_type>::const_iterator it = words.begin(); it != words.end(); ++it)
+    {
+      n += __builtin_popcountl(*it);
+    }
+
+  return n;
+}
+
+
+void
+AtomBitset::elements(std::vector<unsigned>& ids) const
+{
+  ids.clear();
+
+  for (std::size_t i = 0; i < words.size(); ++i)
+    {
+      for (word_type w = words[i]; w; w &= w - 1) // clear the lowest bit
+	{
+	  ids.push_back(i * bits + __builtin_ctzl(w));
+	}
+    }
+}
+
+
+unsigned
+AtomTable::intern(const AtomKey& k)
+{
+  IdMap::iterator it = ids.lower_bound(k);
+
+  if (it == ids.end() || it->first != k) // fresh atom
+    {
+      it = ids.insert(it, std::make_pair(k, static_cast<unsigned>(ids.size())));
+    }
+
+  return it->second;
+}
+
+
+void
+AtomTable::intern(const std::vector<AtomKey>& keys, AtomBitset& b)
+{
+  b = AtomBitset();
+
+  for (std::vector<AtomKey>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+    {
+      b.set(intern(*it));
+    }
+}
+
+
+bool
+AtomTable::lookup(const std::vector<AtomKey>& keys, AtomBitset& b) const
+{
+  b = AtomBitset();
+  bool known = true;
+
+  for (std::vector<AtomKey>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+    {
+      IdMap::const_iterator f = ids.find(*it);
+
+      if (f != ids.end())
+	{
+	  b.set(f->second);
+	}
+      else
+	{
+	  known = false;
+	}
+    }
+
+  return known;
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
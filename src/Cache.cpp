@@ -34,228 +34,1222 @@
 #include "QueryCtx.h"
 #include "Query.h"
 #include "Answer.h"
+#include "URI.h"
 
-#include <iterator>
-#include <functional>
+#include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+
+#include <boost/functional/hash.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <boost/shared_ptr.hpp>
+
+using namespace dlvhex::dl;
+
+
+namespace {
+
+  using dlvhex::ComfortTerm;
+  using dlvhex::ComfortTuple;
+
+  /// the overhead of a node in a std::set or std::map
+  const std::size_t nodeBytes = 4 * sizeof(void*);
+
+  /// the threshold of a burst as long as we know nothing about the costs
+  const unsigned defaultBurst = 3;
+
+  /// we retrieve after this many queries of a burst in any case
+  const unsigned maxBurst = 32;
+
+  /// the number of interpretations a burst keeps track of
+  const std::size_t maxPending = 1024;
+
+  /// the weight of a new cost in the running average
+  const double costWeight = 0.25;
+
+  /// adds @a cost to the running average @a avg
+  void
+  average(double& avg, unsigned long cost)
+  {
+    avg = avg > 0 ? (1 - costWeight) * avg + costWeight * cost : cost;
+  }
+
+  std::size_t
+  termBytes(const ComfortTerm& t)
+  {
+    return sizeof(ComfortTerm) + t.strval.capacity();
+  }
+
+  std::size_t
+  tupleBytes(const ComfortTuple& t)
+  {
+    std::size_t n = sizeof(ComfortTuple);
+
+    for (ComfortTuple::const_iterator it = t.begin(); it != t.end(); ++it)
+      {
+	n += termBytes(*it);
+      }
+
+    return n;
+  }
+
+  /// @return an estimate of the memory held by a set @a k of IDs in a SetTrie or std::map
+  std::size_t
+  keyBytes(const std::vector<unsigned>& k)
+  {
+    return nodeBytes + sizeof(k) + k.size() * (nodeBytes + sizeof(unsigned));
+  }
+
+  /// @return an estimate of the memory held by an instance for tuple @a t
+  std::size_t
+  instanceBytes(const ComfortTuple& t)
+  {
+    return nodeBytes + tupleBytes(t) + sizeof(DLQuery::shared_pointer) + sizeof(DLQuery);
+  }
+
+  /**
+   * @param qctx
+   *
+   * @return an estimate of the memory held by @a qctx and its entry
+   * in a SetTrie
+   */
+  std::size_t
+  footprint(const QueryCtx& qctx)
+  {
+    const Query& q = qctx.getQuery();
+    const Answer& a = qctx.getAnswer();
+    const dlvhex::ComfortInterpretation& i = q.getProjectedInterpretation();
+
+    std::size_t n = sizeof(QueryCtx) + sizeof(Query) + sizeof(Answer)
+      + a.getErrorMessage().capacity() + a.getWarningMessage().capacity();
+
+    for (dlvhex::ComfortInterpretation::const_iterator it = i.begin(); it != i.end(); ++it)
+      {
+	// the atom, its trie node, and its ID
+	n += 2 * nodeBytes + sizeof(dlvhex::ComfortAtom) + tupleBytes(it->tuple) + sizeof(unsigned);
+      }
+
+    for (std::set<ComfortTuple>::const_iterator it = a.begin(); it != a.end(); ++it)
+      {
+	n += nodeBytes + tupleBytes(*it);
+      }
+
+    return n;
+  }
+
+  /**
+   * @param t an individual of a pattern tuple or of an answer
+   * @param nspace the namespace of the ontology
+   *
+   * @return the URI of @a t
+   */
+  std::string
+  individual(const ComfortTerm& t, const std::string& nspace)
+  {
+    std::string s = t.getUnquotedString();
+
+    if (!dlvhex::dl::URI::isValid(s))
+      {
+	s = nspace + s;
+      }
+
+    if (s.size() >= 2 && s[0] == '<' && s[s.size() - 1] == '>') // turtle syntax
+      {
+	s = s.substr(1, s.size() - 2);
+      }
+
+    return s;
+  }
+
+  /**
+   * @param dlq
+   *
+   * @return the ground terms of the pattern tuple of @a dlq as
+   * individuals in the form of RACER answers
+   */
+  ComfortTuple
+  groundTuple(const DLQuery& dlq)
+  {
+    const ComfortTuple& pat = dlq.getPatternTuple();
+    const std::string& nspace = dlq.getOntology()->getNamespace();
+    ComfortTuple t;
+
+    for (std::size_t k = 0; k < pat.size(); ++k)
+      {
+	if (dlq.getTypeFlags() & (1UL << k))
+	  {
+	    t.push_back(ComfortTerm::createConstant("\"<" + individual(pat[k], nspace) + ">\""));
+	  }
+      }
+
+    return t;
+  }
+
+  /**
+   * @param s a set of answer tuples
+   * @param t a tuple of individuals
+   * @param nspace the namespace of the ontology
+   *
+   * @return true if @a s has a tuple with the individuals of @a t
+   */
+  bool
+  hasTuple(const std::set<ComfortTuple>& s, const ComfortTuple& t, const std::string& nspace)
+  {
+    for (std::set<ComfortTuple>::const_iterator it = s.begin(); it != s.end(); ++it)
+      {
+	bool match = it->size() == t.size();
+
+	for (std::size_t k = 0; match && k < t.size(); ++k)
+	  {
+	    match = individual((*it)[k], nspace) == individual(t[k], nspace);
+	  }
+
+	if (match)
+	  {
+	    return true;
+	  }
+      }
+
+    return false;
+  }
+
+  /**
+   * @param dlq
+   *
+   * @return the retrieval query which asks for all tuples of the
+   * plain boolean or mixed query @a dlq, empty otherwise
+   */
+  DLQuery::shared_pointer
+  retrievalForm(const DLQuery& dlq)
+  {
+    const ComfortTuple& pat = dlq.getPatternTuple();
+
+    if (pat.empty() || dlq.isRetrieval() || dlq.isDatatype() ||
+	dlq.isConjQuery() || dlq.isUnionConjQuery())
+      {
+	return DLQuery::shared_pointer();
+      }
+
+    ComfortTuple vars;
+
+    for (std::size_t k = 0; k < pat.size(); ++k)
+      {
+	if (pat[k].isInteger()) // not an individual
+	  {
+	    return DLQuery::shared_pointer();
+	  }
+
+	std::ostringstream oss;
+	oss << 'X' << k;
+	vars.push_back(ComfortTerm::createVariable(oss.str()));
+      }
+
+    return DLQuery::shared_pointer(new DLQuery(dlq.getOntology(), dlq.getQuery(), vars));
+  }
+
+} // anonymous namespace
+
+
+std::size_t
+FrequencySketch::index(unsigned row, std::size_t key)
+{
+  // odd multipliers give independent enough hash functions
+  static const unsigned long long seeds[depth] =
+    {
+      0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL
+    };
+
+  unsigned long long h = (static_cast<unsigned long long>(key) + row) * seeds[row];
+  h ^= h >> 32;
+
+  return row * width + static_cast<std::size_t>(h % width);
+}
+
+
+void
+FrequencySketch::add(std::size_t key)
+{
+  for (unsigned row = 0; row < depth; ++row)
+    {
+      unsigned char& c = counters[index(row, key)];
+
+      if (c < 255)
+	{
+	  ++c;
+	}
+    }
+
+  // age all counters from time to time, so old popularity fades
+  if (++additions >= 10 * width)
+    {
+      for (std::vector<unsigned char>::iterator it = counters.begin(); it != counters.end(); ++it)
+	{
+	  *it >>= 1;
+	}
+
+      additions /= 2;
+    }
+}
+
+
+unsigned
+FrequencySketch::estimate(std::size_t key) const
+{
+  unsigned n = 255;
+
+  for (unsigned row = 0; row < depth; ++row)
+    {
+      n = std::min<unsigned>(n, counters[index(row, key)]);
+    }
+
+  return n;
+}
+
+
+Cache::~Cache()
+{
+  for (QueryAnswerMap::iterator it = cacheMap.begin(); it != cacheMap.end(); ++it)
+    {
+      delete it->second;
+    }
+
+  for (ConsistencyMap::iterator it = consistencyMap.begin(); it != consistencyMap.end(); ++it)
+    {
+      delete it->second;
+    }
+}
+
+
+const Cache::CacheEntry*
+Cache::find(const QueryCtx::shared_pointer& q) const
+{
+  QueryAnswerMap::const_iterator foundit = cacheMap.find(q->getQuery().getDLQuery());
+
+  return foundit == cacheMap.end() ? 0 : foundit->second;
+}
+
+
+QueryCtx::shared_pointer
+Cache::isValid(const QueryCtx::shared_pointer& query, const Cache::CacheEntry& found,
+		bool fill) const
+{
+  const Query& q = query->getQuery();
+
+  // an atom we never interned cannot be in a cached interpretation,
+  // so only subsets of the interpretation of query may be cached
+  AtomBitset bits;
+  bool known = atoms.lookup(q.getProjectedKeys(), bits);
+
+  CacheSet::Key i;
+  bits.elements(i);
+
+  const QueryCtx::shared_pointer* p = 0;
+
+  ///@todo support for cq missing
+
+  if (q.getDLQuery()->isBoolean())
+    {
+      // a positive answer for j \subseteq i
+      p = found.positive.findSubset(i);
+
+      if (!p && known)
+	{
+	  // or a negative answer for j \supseteq i
+	  p = found.negative.findSuperset(i);
+	}
+    }
+  else if (known) // retrieval modes
+    {
+      // the set of ints in query must equal the set of ints in found
+      p = found.retrieval.find(i);
+    }
+
+  if (!p && !q.getDLQuery()->isBoolean())
+    {
+      // the answers of queries with smaller and larger
+      // interpretations may pin down the answer of query
+      std::set<ComfortTuple> lower, upper;
+
+      if (bounds(i, known, found, lower, upper) &&
+	  std::includes(lower.begin(), lower.end(), upper.begin(), upper.end()))
+	{
+	  if (fill)
+	    {
+	      Answer& a = query->getAnswer();
+
+	      for (std::set<ComfortTuple>::const_iterator it = lower.begin(); it != lower.end(); ++it)
+		{
+		  a.insert(*it);
+		}
+	    }
+
+	  return query;
+	}
+    }
+
+  return p ? *p : QueryCtx::shared_pointer(); // nothing found
+}
+
+
+bool
+Cache::bounds(const CacheSet::Key& i, bool known, const Cache::CacheEntry& found,
+	      std::set<ComfortTuple>& lower, std::set<ComfortTuple>& upper) const
+{
+  std::vector<CacheSet::Entry> entries;
+
+  // each answer for j \subseteq i is an answer for i
+  found.retrieval.subsets(i, entries);
+
+  for (std::vector<CacheSet::Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+      const Answer& a = it->second->getAnswer();
+
+      if (!a.getIncoherent() && a.getErrorMessage().empty())
+	{
+	  lower.insert(a.begin(), a.end());
+	}
+    }
+
+  // the boolean instances decide single tuples
+  std::set<ComfortTuple> excluded;
+
+  for (std::map<ComfortTuple, DLQuery::shared_pointer>::const_iterator it = found.instances.begin();
+       it != found.instances.end(); ++it)
+    {
+      QueryAnswerMap::const_iterator e = cacheMap.find(it->second);
+
+      if (e == cacheMap.end()) // evicted
+	{
+	  continue;
+	}
+
+      const QueryCtx::shared_pointer* p = e->second->positive.findSubset(i);
+
+      if (p && !(*p)->getAnswer().getIncoherent())
+	{
+	  lower.insert(it->first);
+	}
+      else if (known && e->second->negative.findSuperset(i))
+	{
+	  excluded.insert(it->first);
+	}
+    }
+
+  if (!known) // a superset of i has all its atoms
+    {
+      return false;
+    }
+
+  entries.clear();
+
+  // each answer for i is an answer for j \supseteq i
+  found.retrieval.supersets(i, entries);
+
+  bool isBounded = false;
+
+  for (std::vector<CacheSet::Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+      const Answer& a = it->second->getAnswer();
+
+      if (a.getIncoherent() || !a.getErrorMessage().empty())
+	{
+	  continue; // everything is entailed under an inconsistent ABox
+	}
+      else if (!isBounded)
+	{
+	  upper.insert(a.begin(), a.end());
+	  isBounded = true;
+	}
+      else
+	{
+	  std::set<ComfortTuple> tmp;
+	  std::set_intersection(upper.begin(), upper.end(), a.begin(), a.end(),
+				std::inserter(tmp, tmp.begin()));
+	  upper.swap(tmp);
+	}
+    }
+
+  for (std::set<ComfortTuple>::const_iterator it = excluded.begin(); it != excluded.end(); ++it)
+    {
+      upper.erase(*it);
+    }
+
+  return isBounded;
+}
+
+
+bool
+Cache::bounds(const QueryCtx::shared_pointer& query,
+	      std::set<ComfortTuple>& lower,
+	      std::set<ComfortTuple>& upper) const
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  const Query& q = query->getQuery();
+  const CacheEntry* found = find(query);
+
+  if (!found || q.getDLQuery()->isBoolean())
+    {
+      return false;
+    }
+
+  AtomBitset bits;
+  bool known = atoms.lookup(q.getProjectedKeys(), bits);
+
+  CacheSet::Key i;
+  bits.elements(i);
+
+  return bounds(i, known, *found, lower, upper);
+}
+
+
+QueryCtx::shared_pointer
+Cache::fromRetrieval(const QueryCtx::shared_pointer& query, bool fill) const
+{
+  const DLQuery::shared_pointer& dlq = query->getQuery().getDLQuery();
+  DLQuery::shared_pointer rf = retrievalForm(*dlq);
+
+  if (!rf)
+    {
+      return QueryCtx::shared_pointer();
+    }
+
+  QueryAnswerMap::const_iterator found = cacheMap.find(rf);
+
+  if (found == cacheMap.end())
+    {
+      return QueryCtx::shared_pointer();
+    }
+
+  AtomBitset bits;
+  bool known = atoms.lookup(query->getQuery().getProjectedKeys(), bits);
+
+  CacheSet::Key i;
+  bits.elements(i);
+
+  const ComfortTuple t = groundTuple(*dlq);
+  const std::string& nspace = dlq->getOntology()->getNamespace();
+  const QueryCtx::shared_pointer* p = known ? found->second->retrieval.find(i) : 0;
+  bool answer = false;
+
+  if (p && !(*p)->getAnswer().getIncoherent() && (*p)->getAnswer().getErrorMessage().empty())
+    {
+      const Answer& r = (*p)->getAnswer();
+
+      if (dlq->isBoolean())
+	{
+	  answer = hasTuple(r, t, nspace);
+	}
+      else // mixed query, keep the tuples with the ground terms of dlq
+	{
+	  if (fill)
+	    {
+	      Answer& a = query->getAnswer();
+	      const ComfortTuple& pat = dlq->getPatternTuple();
+
+	      for (Answer::const_iterator it = r.begin(); it != r.end(); ++it)
+		{
+		  ComfortTuple out(*it);
+		  bool match = true;
+
+		  for (std::size_t k = 0; match && k < pat.size(); ++k)
+		    {
+		      if (dlq->getTypeFlags() & (1UL << k))
+			{
+			  match = individual((*it)[k], nspace) == individual(pat[k], nspace);
+
+			  // like Answer::addTuple
+			  std::string c = pat[k].getUnquotedString();
+			  out[k] = ComfortTerm::createConstant(URI::isValid(c) ? c : nspace + c);
+			}
+		    }
+
+		  if (match)
+		    {
+		      a.insert(out);
+		    }
+		}
+	    }
+
+	  return query;
+	}
+    }
+  else if (dlq->isBoolean())
+    {
+      // the bounds of the retrieval query may decide the tuple of dlq
+      std::set<ComfortTuple> lower, upper;
+      bool isBounded = bounds(i, known, *found->second, lower, upper);
+
+      if (hasTuple(lower, t, nspace))
+	{
+	  answer = true;
+	}
+      else if (isBounded && !hasTuple(upper, t, nspace))
+	{
+	  answer = false;
+	}
+      else
+	{
+	  return QueryCtx::shared_pointer();
+	}
+    }
+  else
+    {
+      return QueryCtx::shared_pointer();
+    }
+
+  if (fill)
+    {
+      Answer& a = query->getAnswer();
+      a.setAnswer(answer);
+
+      if (answer) // like RacerAnswerDriver
+	{
+	  a.insert(ComfortTuple());
+	}
+    }
+
+  return query;
+}
+
+
+QueryCtx::shared_pointer
+Cache::cacheHit(const QueryCtx::shared_pointer& query) const
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  const CacheEntry* found = find(query);
+  QueryCtx::shared_pointer p;
+
+  if (budget && admission)
+    {
+      sketch.add(hash(query));
+    }
+
+  if (found)
+    {
+      p = isValid(query, *found);
+    }
+
+  if (!p)
+    {
+      p = fromRetrieval(query);
+    }
+
+  if (p)
+    {
+      stats->hits(1);
+      touch(p);
+    }
+  else if (restore(query)) // answered in an earlier run
+    {
+      stats->hits(1);
+      p = query;
+    }
+  else // nothing found
+    {
+      stats->miss(1);
+    }
+
+  return p;
+}
+
+
+bool
+Cache::restore(const QueryCtx::shared_pointer& q) const
+{
+  return store && store->lookup(*q);
+}
+
+
+bool
+Cache::consistency(const QueryCtx::shared_pointer& query, bool& consistent) const
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  const Query& q = query->getQuery();
+
+  ConsistencyMap::const_iterator found =
+    consistencyMap.find(q.getDLQuery()->getOntology()->getRealURI().getString());
+
+  if (found == consistencyMap.end())
+    {
+      return false;
+    }
+
+  AtomBitset bits;
+  bool known = atoms.lookup(q.getProjectedKeys(), bits);
+
+  ConsistencySet::Key i;
+  bits.elements(i);
+
+  // an inconsistent j \subseteq i
+  if (found->second->inconsistent.findSubset(i))
+    {
+      consistent = false;
+      return true;
+    }
+
+  // or a consistent j \supseteq i, which has all atoms of i
+  if (known && found->second->consistent.findSuperset(i))
+    {
+      consistent = true;
+      return true;
+    }
+
+  return false;
+}
+
+
+void
+Cache::insertConsistency(const QueryCtx::shared_pointer& query, bool consistent)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  const Query& q = query->getQuery();
 
-#include <boost/iterator/indirect_iterator.hpp>
-#include <boost/shared_ptr.hpp>
+  const std::string& uri = q.getDLQuery()->getOntology()->getRealURI().getString();
+  ConsistencyEntry*& found = consistencyMap[uri];
 
-using namespace dlvhex::dl;
+  if (found == 0)
+    {
+      found = new ConsistencyEntry;
+      grow(nodeBytes + uri.capacity() + sizeof(ConsistencyEntry));
+    }
 
+  AtomBitset bits;
+  atoms.intern(q.getProjectedKeys(), bits);
 
-const Cache::CacheSet*
-Cache::find(const QueryCtx::shared_pointer& q) const
+  ConsistencySet::Key i;
+  bits.elements(i);
+
+  std::vector<ConsistencySet::Entry> remove;
+
+  if (consistent)
+    {
+      if (found->consistent.findSuperset(i)) // nothing new
+	{
+	  return;
+	}
+
+      // keep only maximal interpretations
+      found->consistent.subsets(i, remove);
+
+      for (std::vector<ConsistencySet::Entry>::const_iterator it = remove.begin(); it != remove.end(); ++it)
+	{
+	  found->consistent.erase(it->first);
+	  shrink(keyBytes(it->first));
+	}
+
+      found->consistent.insert(i, true);
+      grow(keyBytes(i));
+    }
+  else
+    {
+      if (found->inconsistent.findSubset(i)) // nothing new
+	{
+	  return;
+	}
+
+      // keep only minimal interpretations
+      found->inconsistent.supersets(i, remove);
+
+      for (std::vector<ConsistencySet::Entry>::const_iterator it = remove.begin(); it != remove.end(); ++it)
+	{
+	  found->inconsistent.erase(it->first);
+	  shrink(keyBytes(it->first));
+	}
+
+      found->inconsistent.insert(i, true);
+      grow(keyBytes(i));
+    }
+
+  if (budget)
+    {
+      evict(0);
+    }
+}
+
+
+void
+Cache::touch(const QueryCtx::shared_pointer& q) const
 {
-  QueryAnswerMap::const_iterator foundit = cacheMap.find(q->getQuery().getDLQuery());
+  MetaMap::iterator m = meta.find(q.get());
+
+  if (m != meta.end())
+    {
+      Meta& e = m->second;
 
-  return foundit == cacheMap.end() ? 0 : &foundit->second;
+      queue.erase(std::make_pair(e.priority, m->first));
+      ++e.freq;
+      e.priority = inflation + e.freq * e.cost / e.bytes;
+      queue.insert(std::make_pair(e.priority, m->first));
+    }
 }
 
 
-QueryCtx::shared_pointer
-Cache::isValid(const QueryCtx::shared_pointer& query, const Cache::CacheSet& found) const
+std::size_t
+Cache::hash(const QueryCtx::shared_pointer& q) const
+{
+  const DLQuery::shared_pointer& dlq = q->getQuery().getDLQuery();
+  const ComfortInterpretation& i = q->getQuery().getProjectedInterpretation();
+
+  std::size_t h = 0;
+  boost::hash_combine(h, dlq->getOntology()->getRealURI().getString());
+  boost::hash_combine(h, dlq->getCanonical());
+
+  for (ComfortInterpretation::const_iterator it = i.begin(); it != i.end(); ++it)
+    {
+      for (ComfortTuple::const_iterator t = it->tuple.begin(); t != it->tuple.end(); ++t)
+	{
+	  boost::hash_combine(h, t->strval);
+	  boost::hash_combine(h, t->intval);
+	}
+    }
+
+  return h;
+}
+
+
+void
+Cache::forget(const QueryCtx* q)
+{
+  MetaMap::iterator m = meta.find(q);
+
+  if (m != meta.end())
+    {
+      queue.erase(std::make_pair(m->second.priority, q));
+      used -= m->second.bytes;
+      stats->bytes(-static_cast<long>(m->second.bytes));
+      meta.erase(m);
+    }
+}
+
+
+void
+Cache::grow(std::size_t bytes)
+{
+  aside += bytes;
+  used += bytes;
+  stats->bytes(bytes);
+}
+
+
+void
+Cache::shrink(std::size_t bytes)
 {
-  for (CacheSet::const_iterator it = found.begin(); it != found.end(); ++it)
+  aside -= bytes;
+  used -= bytes;
+  stats->bytes(-static_cast<long>(bytes));
+}
+
+
+Cache::Burst&
+Cache::burst(const DLQuery::shared_pointer& rf)
+{
+  BurstMap::iterator b = bursts.lower_bound(rf);
+
+  if (b == bursts.end() || bursts.key_comp()(rf, b->first))
+    {
+      b = bursts.insert(b, std::make_pair(rf, Burst()));
+      grow(nodeBytes + sizeof(Burst) + sizeof(DLQuery));
+    }
+
+  return b->second;
+}
+
+
+void
+Cache::dropInstance(const DLQuery::shared_pointer& dlq)
+{
+  DLQuery::shared_pointer rf;
+
+  if (!dlq->isBoolean() || !(rf = retrievalForm(*dlq)))
+    {
+      return;
+    }
+
+  QueryAnswerMap::iterator r = cacheMap.find(rf);
+
+  if (r == cacheMap.end())
     {
-      const Query& q1 = query->getQuery();
-      const Query& q2 = (*it)->getQuery();
+      return;
+    }
 
-      const ComfortInterpretation& i = q1.getProjectedInterpretation();
-      const ComfortInterpretation& j = q2.getProjectedInterpretation();
+  ComfortTuple t = groundTuple(*dlq);
+  std::map<ComfortTuple, DLQuery::shared_pointer>::iterator it = r->second->instances.find(t);
 
-      ///@todo support for cq missing
+  if (it != r->second->instances.end() && *it->second == *dlq)
+    {
+      r->second->instances.erase(it);
+      shrink(instanceBytes(t));
 
-      if (q1.getDLQuery()->isBoolean())
+      if (r->second->empty())
 	{
-	  bool isPositive = (*it)->getAnswer().getAnswer();
-	  
-	  if (isPositive)
-	    {
-	      // does i include j, i.e. is j \subseteq i?
-	      if (std::includes(i.begin(), i.end(), j.begin(), j.end()))
-		{
-		  return *it;
-		}
-	    }
-	  else
-	    {
-	      // does j include i, i.e. is j \supseteq i?
-	      if (std::includes(j.begin(), j.end(), i.begin(), i.end()))
-		{
-		  return *it;
-		}
-	    }
+	  delete r->second;
+	  cacheMap.erase(r);
+	  stats->dlqno(-1);
+	}
+    }
+}
+
+
+void
+Cache::prune()
+{
+  // they only save round trips to RACER, the answers are in the QueryCtx'en
+  bursts.clear();
+
+  for (ConsistencyMap::iterator it = consistencyMap.begin(); it != consistencyMap.end(); ++it)
+    {
+      delete it->second;
+    }
+
+  consistencyMap.clear();
+
+  for (QueryAnswerMap::iterator it = cacheMap.begin(); it != cacheMap.end(); )
+    {
+      it->second->instances.clear();
+
+      if (it->second->empty())
+	{
+	  delete it->second;
+	  cacheMap.erase(it++);
+	  stats->dlqno(-1);
+	}
+      else
+	{
+	  ++it;
 	}
-      else // retrieval modes
+    }
+
+  shrink(aside);
+}
+
+
+void
+Cache::evict(std::size_t bytes)
+{
+  while (used + bytes > budget)
+    {
+      if (queue.empty()) // only the bookkeeping is left
 	{
-	  // is the set of ints in query equal to the set of ints in found?
-	  if (i.difference(j).size() == 0 && j.difference(i).size() == 0)
+	  if (aside)
 	    {
-	      return *it;
+	      prune();
 	    }
+
+	  return;
+	}
+
+      const QueryCtx* victim = queue.begin()->second;
+      Meta m = meta[victim];
+
+      // GDSF: the next entries start from the priority of the victim
+      inflation = m.priority;
+
+      forget(victim);
+
+      if (m.set->erase(m.key))
+	{
+	  stats->qctxno(-1);
+	  stats->evict(1);
+	}
+
+      QueryAnswerMap::iterator e = cacheMap.find(m.dlq);
+
+      if (e != cacheMap.end() && e->second->empty())
+	{
+	  delete e->second;
+	  cacheMap.erase(e);
+	  stats->dlqno(-1);
+
+	  // the retrieval dl-query cannot use the answers of m.dlq anymore
+	  dropInstance(m.dlq);
 	}
     }
+}
+
+
+unsigned
+Cache::Burst::threshold() const
+{
+  if (booleanCost <= 0 || retrievalCost <= 0)
+    {
+      return defaultBurst;
+    }
 
-  return QueryCtx::shared_pointer(); // nothing found
+  // ski rental: retrieve as soon as the single queries cost as much
+  double n = std::ceil(retrievalCost / booleanCost);
+
+  return n < 2 ? 2 : n > maxBurst ? maxBurst : static_cast<unsigned>(n);
 }
 
 
-QueryCtx::shared_pointer
-Cache::cacheHit(const QueryCtx::shared_pointer& query) const
+DLQuery::shared_pointer
+Cache::promote(const QueryCtx::shared_pointer& query)
 {
-  const CacheSet* found = find(query);
-  QueryCtx::shared_pointer p;
+  boost::mutex::scoped_lock lock(mutex);
 
-  if (found)
+  DLQuery::shared_pointer rf = retrievalForm(*query->getQuery().getDLQuery());
+
+  if (!rf)
     {
-      p = isValid(query, *found);
-      if (p) stats->hits(1);
-      else   stats->miss(1);
+      return rf;
     }
-  else // nothing found
+
+  Burst& b = burst(rf);
+
+  AtomBitset bits;
+  atoms.intern(query->getQuery().getProjectedKeys(), bits);
+
+  CacheSet::Key i;
+  bits.elements(i);
+
+  std::map<CacheSet::Key, unsigned>::iterator c = b.count.find(i);
+
+  if (c == b.count.end())
     {
-      stats->miss(1);
+      if (b.count.size() >= maxPending) // start over with the bursts of the recent inputs
+	{
+	  for (c = b.count.begin(); c != b.count.end(); ++c)
+	    {
+	      shrink(keyBytes(c->first) + sizeof(unsigned));
+	    }
+
+	  b.count.clear();
+	}
+
+      c = b.count.insert(std::make_pair(i, 0u)).first;
+      grow(keyBytes(i) + sizeof(unsigned));
     }
 
-  return p;
+  bool retrieve = ++c->second >= b.threshold();
+
+  if (retrieve)
+    {
+      b.count.erase(c);
+      shrink(keyBytes(i) + sizeof(unsigned));
+    }
+
+  if (budget)
+    {
+      evict(0);
+    }
+
+  return retrieve ? rf : DLQuery::shared_pointer();
 }
 
 
-namespace dlvhex {
-  namespace dl {
+void
+Cache::setBudget(std::size_t bytes)
+{
+  boost::mutex::scoped_lock lock(mutex);
 
-    struct InterSubset : public std::unary_function<const QueryCtx::shared_pointer&, bool>
+  budget = bytes;
+
+  if (budget)
     {
-      const QueryCtx::shared_pointer& q1;
+      evict(0);
+    }
+}
 
-      InterSubset(const QueryCtx::shared_pointer& q)
-	: q1(q)
-      { }
 
-      bool
-      operator() (const QueryCtx::shared_pointer& q2) const
-      {
-	const ComfortInterpretation& i = q1->getQuery().getProjectedInterpretation();
-	const ComfortInterpretation& j = q2->getQuery().getProjectedInterpretation();
-	// does i include j and i != j, i.e. is j \subset i?
-	return (i.difference(j).size() != 0 || j.difference(i).size() == 0) && std::includes(i.begin(), i.end(), j.begin(), j.end());
-      }
-    };
+void
+Cache::setAdmission(bool admit)
+{
+  boost::mutex::scoped_lock lock(mutex);
 
-    struct InterSuperset : public std::unary_function<const QueryCtx::shared_pointer&, bool>
-    {
-      const QueryCtx::shared_pointer& q1;
+  admission = admit;
+}
 
-      InterSuperset(const QueryCtx::shared_pointer& q)
-	: q1(q)
-      { }
 
-      bool
-      operator() (const QueryCtx::shared_pointer& q2) const
-      {
-	const ComfortInterpretation& i = q1->getQuery().getProjectedInterpretation();
-	const ComfortInterpretation& j = q2->getQuery().getProjectedInterpretation();
-	// does j include i and i != j, i.e. is j \supset i?
-	return (i.difference(j).size() != 0 || j.difference(i).size() != 0) && std::includes(j.begin(), j.end(), i.begin(), i.end());
-      }
-    };
+void
+Cache::setStore(CacheStore* s)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  store = s;
+}
+
 
-  } // namespace dl
-} // namespace dlvhex
+bool
+Cache::contains(const QueryCtx::shared_pointer& query) const
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  const CacheEntry* found = find(query);
+
+  return (found && isValid(query, *found, false))
+    || fromRetrieval(query, false)
+    || (store && store->contains(*query));
+}
 
 
 void
-Cache::insert(const QueryCtx::shared_pointer& query)
+Cache::insert(const QueryCtx::shared_pointer& query, unsigned long cost)
 {
-  QueryAnswerMap::iterator foundit = cacheMap.find(query->getQuery().getDLQuery());
-  CacheSet* found = foundit == cacheMap.end() ? 0 : &foundit->second;
+  boost::mutex::scoped_lock lock(mutex);
 
-  if (found) // found a dl-query in the map
+  if (meta.find(query.get()) != meta.end()) // already cached
     {
-      //
-      // first, we have to perform the cache maintainance algorithm
-      //
+      return;
+    }
 
-      typedef std::vector<CacheSet::iterator> RemoveVector;
-      RemoveVector remove;
-      std::insert_iterator<RemoveVector> rins = std::inserter(remove, remove.begin());
+  if (cost) // learn what single queries and their retrieval cost
+    {
+      const DLQuery::shared_pointer& dlq = query->getQuery().getDLQuery();
+      DLQuery::shared_pointer rf;
 
-      if (query->getQuery().getDLQuery()->isBoolean()) // boolean query
+      if (!dlq->isRetrieval() && (rf = retrievalForm(*dlq)))
 	{
-	  if (query->getAnswer().getAnswer()) // positive answer
-	    {
-	      // we only want to cache minimal interpretations
-	      InterSuperset iss(query);
+	  average(burst(rf).booleanCost, cost);
+	}
+      else
+	{
+	  BurstMap::iterator b = bursts.find(dlq);
 
-	      for (CacheSet::iterator it = found->begin(); it != found->end(); ++it)
-		{
-		  if ((*it)->getAnswer().getAnswer() && iss(*it))
-		    {
-		      *rins = it;
-		      ++rins;
-		    }
-		}
-	    }
-	  else // negative answer
+	  if (b != bursts.end())
 	    {
-	      // we only want to cache maximal interpretations
-	      InterSubset iss(query);
-
-	      for (CacheSet::iterator it = found->begin(); it != found->end(); ++it)
-		{
-		  if (!(*it)->getAnswer().getAnswer() && iss(*it))
-		    {
-		      *rins = it;
-		      ++rins;
-		    }
-		}
+	      average(b->second.retrievalCost, cost);
 	    }
 	}
-      else // retrieval query
+    }
+
+  if (store) // keep the answer for the next runs, even if we evict it
+    {
+      store->store(*query);
+    }
+
+  std::size_t bytes = footprint(*query);
+  std::size_t h = hash(query);
+
+  if (budget)
+    {
+      if (bytes > budget) // never fits
 	{
-	  // just insert it, nothing to remove. It should not occur
-	  // that we have a clash when inserting two QueryCtx'en with
-	  // the same interpretation since in that case we would have
-	  // a cache-hit.
+	  return;
 	}
 
-      //
-      // that is, we have to remove superfluous QueryCtx objects
-      //
-
-      for (RemoveVector::const_iterator it = remove.begin(); it != remove.end(); ++it)
+      // a query must be more popular than the one it evicts
+      if (admission && used + bytes > budget && !queue.empty() &&
+	  sketch.estimate(h) <= sketch.estimate(meta[queue.begin()->second].hash))
 	{
-	  found->erase(*it);
+	  return;
 	}
 
-      stats->qctxno(-remove.size());
+      evict(bytes);
+    }
+
+  CacheEntry*& found = cacheMap[query->getQuery().getDLQuery()];
+
+  if (found == 0) // dl-query not found, insert a new entry in the map
+    {
+      found = new CacheEntry;
+      stats->dlqno(1);
+    }
+
+  AtomBitset bits;
+  atoms.intern(query->getQuery().getProjectedKeys(), bits);
+
+  CacheSet::Key i;
+  bits.elements(i);
+
+  //
+  // first, we have to perform the cache maintainance algorithm
+  //
 
-      //
-      // after that, we can insert the new QueryCtx
-      //
+  CacheSet* cs = &found->retrieval;
+  std::vector<CacheSet::Entry> remove;
+
+  if (query->getQuery().getDLQuery()->isBoolean()) // boolean query
+    {
+      if (query->getAnswer().getAnswer()) // positive answer
+	{
+	  // we only want to cache minimal interpretations
+	  cs = &found->positive;
+	  cs->supersets(i, remove);
+	}
+      else // negative answer
+	{
+	  // we only want to cache maximal interpretations
+	  cs = &found->negative;
+	  cs->subsets(i, remove);
+	}
+    }
+  else // retrieval query
+    {
+      // just insert it, nothing to remove. It should not occur
+      // that we have a clash when inserting two QueryCtx'en with
+      // the same interpretation since in that case we would have
+      // a cache-hit.
+    }
 
-      std::pair<CacheSet::iterator, bool> p = found->insert(query);
+  //
+  // that is, we have to remove superfluous QueryCtx objects, but
+  // keep a QueryCtx with the same interpretation
+  //
 
-      // only update the statistics if we inserted a fresh QueryCtx
-      if (p.second)
+  for (std::vector<CacheSet::Entry>::const_iterator it = remove.begin(); it != remove.end(); ++it)
+    {
+      if (it->first != i && cs->erase(it->first))
 	{
-	  stats->qctxno(1);
+	  forget(it->second.get());
+	  stats->qctxno(-1);
 	}
     }
-  else // dl-query not found, insert a new entry in the map
+
+  //
+  // after that, we can insert the new QueryCtx
+  //
+
+  // only update the statistics if we inserted a fresh QueryCtx
+  if (cs->insert(i, query))
+    {
+      stats->qctxno(1);
+
+      Meta& m = meta[query.get()];
+      m.dlq = query->getQuery().getDLQuery();
+      m.set = cs;
+      m.key = i;
+      m.bytes = bytes;
+      m.cost = cost ? cost : 1;
+      m.freq = 1;
+      m.priority = inflation + m.cost / m.bytes;
+      m.hash = h;
+
+      queue.insert(std::make_pair(m.priority, query.get()));
+      used += bytes;
+      stats->bytes(bytes);
+    }
+
+  // a later retrieval query may use the answer of a boolean query
+  const DLQuery::shared_pointer& dlq = query->getQuery().getDLQuery();
+  DLQuery::shared_pointer rf;
+
+  if (dlq->isBoolean() && (rf = retrievalForm(*dlq)))
     {
-      CacheSet cs;
-      cs.insert(query);
-      std::pair<QueryAnswerMap::iterator, bool> p = cacheMap.insert
-	(std::make_pair(query->getQuery().getDLQuery(), cs));
+      CacheEntry*& r = cacheMap[rf];
 
-      // only update the statistics if we inserted a fresh QueryCtx
-      if (p.second)
+      if (r == 0)
 	{
+	  r = new CacheEntry;
 	  stats->dlqno(1);
-	  stats->qctxno(1);
+	}
+
+      ComfortTuple t = groundTuple(*dlq);
+
+      if (r->instances.insert(std::make_pair(t, dlq)).second)
+	{
+	  grow(instanceBytes(t));
+
+	  if (budget)
+	    {
+	      evict(0);
+	    }
 	}
     }
 }
@@ -264,8 +1258,15 @@ Cache::insert(const QueryCtx::shared_pointer& query)
 QueryCtx::shared_pointer
 DebugCache::cacheHit(const QueryCtx::shared_pointer& query) const
 {
+  boost::mutex::scoped_lock lock(mutex);
+
   std::cerr << "===== now looking for dl-query a = " << query->getQuery() << std::endl;
 
+  if (budget && admission)
+    {
+      sketch.add(hash(query));
+    }
+
   std::cerr << "----- cache content:" << std::endl;
 
   for (QueryAnswerMap::const_iterator it = cacheMap.begin();
@@ -274,16 +1275,21 @@ DebugCache::cacheHit(const QueryCtx::shared_pointer& query) const
       std::cerr << *(it->first) << std::endl;
     }
 
-  const CacheSet* found = Cache::find(query);
+  const CacheEntry* found = Cache::find(query);
 
   if (found)
     {
       std::cerr << "----- found cache(a): " << std::endl;
 
-      for (CacheSet::const_iterator it = found->begin();
-	   it != found->end(); ++it)
+      std::vector<CacheSet::Entry> entries;
+      found->positive.entries(entries);
+      found->negative.entries(entries);
+      found->retrieval.entries(entries);
+
+      for (std::vector<CacheSet::Entry>::const_iterator it = entries.begin();
+	   it != entries.end(); ++it)
 	{
-	  std::cerr << *(*it) << " = " << (*it)->getAnswer() << std::endl;
+	  std::cerr << *(it->second) << " = " << it->second->getAnswer() << std::endl;
 	}
 
       QueryCtx::shared_pointer p = Cache::isValid(query, *found);
@@ -292,6 +1298,7 @@ DebugCache::cacheHit(const QueryCtx::shared_pointer& query) const
 	{
 	  std::cerr << "===== cache-hit for a is " << *p << std::endl;
 	  stats->hits(1);
+	  touch(p);
 	  return p;
 	}
       else
@@ -304,6 +1311,20 @@ DebugCache::cacheHit(const QueryCtx::shared_pointer& query) const
       std::cerr << "===== NOT found in cache" << std::endl;
     }
 
+  if (Cache::fromRetrieval(query))
+    {
+      std::cerr << "===== answered a from the retrieval query: " << query->getAnswer() << std::endl;
+      stats->hits(1);
+      return query;
+    }
+
+  if (Cache::restore(query))
+    {
+      std::cerr << "===== restored a from the dl-cache file: " << query->getAnswer() << std::endl;
+      stats->hits(1);
+      return query;
+    }
+
   stats->miss(1);
 
   return QueryCtx::shared_pointer();
@@ -0,0 +1,563 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   CacheStore.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 18:40:12 2026
+ *
+ * @brief  A persistent store of answered dl-queries.
+ *
+ *
+ */
+
+
+#include "CacheStore.h"
+#include "Query.h"
+#include "Answer.h"
+#include "DLQuery.h"
+#include "Ontology.h"
+#include "Registry.h"
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <cstdio>       // rename()
+#include <cstdlib>      // mkstemp()
+#include <cstring>      // strlen()
+
+#include <fcntl.h>      // open()
+#include <unistd.h>     // write(), close(), ftruncate()
+#include <sys/types.h>
+#include <sys/stat.h>   // fstat(), stat()
+#include <sys/mman.h>   // mmap(), munmap()
+#include <sys/file.h>   // flock()
+
+using namespace dlvhex::dl;
+
+
+namespace {
+
+  using dlvhex::ComfortTerm;
+  using dlvhex::ComfortTuple;
+
+  /// the first line of a store, bump the version if the format changes
+  const char* const magic = "dlvhex-dlplugin cache 1\n";
+
+  /// @brief releases the flock(2) of a file descriptor when it goes out of scope
+  struct Unlock
+  {
+    const int& fd;
+
+    explicit
+    Unlock(const int& f)
+      : fd(f)
+    { }
+
+    ~Unlock()
+    {
+      ::flock(fd, LOCK_UN);
+    }
+  };
+
+  void
+  encode(std::ostream& os, const ComfortTerm& t)
+  {
+    if (t.isInteger())
+      {
+	os << 'i' << t.intval;
+      }
+    else
+      {
+	os << 's' << t.strval.size() << ':' << t.strval;
+      }
+  }
+
+  bool
+  decode(std::istream& is, ComfortTerm& t)
+  {
+    char c;
+    is >> c;
+
+    if (c == 'i')
+      {
+	int i;
+	is >> i;
+	t = ComfortTerm::createInteger(i);
+      }
+    else if (c == 's')
+      {
+	std::size_t n;
+
+	if (!(is >> n) || is.get() != ':')
+	  {
+	    return false;
+	  }
+
+	std::string s(n, '\0');
+	is.read(n ? &s[0] : 0, n);
+	t = ComfortTerm::createConstant(s);
+      }
+    else
+      {
+	return false;
+      }
+
+    return !is.fail();
+  }
+
+  void
+  encode(std::ostream& os, const ComfortTuple& t)
+  {
+    os << t.size();
+
+    for (ComfortTuple::const_iterator it = t.begin(); it != t.end(); ++it)
+      {
+	os << ' ';
+	encode(os, *it);
+      }
+
+    os << '\n';
+  }
+
+  bool
+  decode(std::istream& is, ComfortTuple& t)
+  {
+    std::size_t n;
+
+    if (!(is >> n))
+      {
+	return false;
+      }
+
+    t.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	if (!decode(is, t[i]))
+	  {
+	    return false;
+	  }
+      }
+
+    return true;
+  }
+
+  /**
+   * Parses a decimal number at @a p.
+   *
+   * @param p moves past the number and the next character
+   * @param end
+   * @param n gets the number
+   * @param sep the character which must follow the number
+   *
+   * @return false if there is no number followed by @a sep at @a p
+   */
+  bool
+  number(const char*& p, const char* end, std::size_t& n, char sep)
+  {
+    const char* start = p;
+    n = 0;
+
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+      {
+	n = n * 10 + (*p - '0');
+      }
+
+    return p != start && p < end && *p++ == sep;
+  }
+
+} // anonymous namespace
+
+
+
+CacheStore::CacheStore(const std::string& f) throw (DLError)
+  : file(f),
+    fd(-1),
+    base(0),
+    length(0),
+    known(0),
+    records(),
+    appended(),
+    versions(),
+    stale(false)
+{
+  load();
+}
+
+
+CacheStore::~CacheStore()
+{
+  // the dtor must not throw, so just tell what went wrong
+  try
+    {
+      if (stale)
+	{
+	  compact();
+	}
+    }
+  catch (DLError& e)
+    {
+      std::cerr << e.what() << std::endl;
+    }
+
+  if (base)
+    {
+      ::munmap(base, length);
+    }
+
+  if (fd != -1)
+    {
+      ::close(fd);
+    }
+}
+
+
+bool
+CacheStore::lock(int op) throw (DLError)
+{
+  bool same = true;
+
+  for (;;)
+    {
+      struct stat opened, named;
+
+      if (fd == -1 || ::flock(fd, op) != 0 || ::fstat(fd, &opened) != 0)
+	{
+	  throw DLError("Could not lock dl-cache file " + file + '.');
+	}
+
+      if (::stat(file.c_str(), &named) == 0 &&
+	  named.st_dev == opened.st_dev && named.st_ino == opened.st_ino)
+	{
+	  return same;
+	}
+
+      // another run compacted the file and renamed it over ours, the
+      // mapping of the old one stays valid
+      ::close(fd);
+      fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+      same = false;
+    }
+}
+
+
+void
+CacheStore::load() throw (DLError)
+{
+  fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+
+  if (fd == -1)
+    {
+      throw DLError("Could not open dl-cache file " + file + '.');
+    }
+
+  // nobody appends while we look for a torn record
+  lock(LOCK_EX);
+  Unlock unlock(fd);
+
+  struct stat stbuf;
+
+  if (::fstat(fd, &stbuf) != 0)
+    {
+      throw DLError("Could not open dl-cache file " + file + '.');
+    }
+
+  length = stbuf.st_size;
+  known = length;
+
+  if (length > 0)
+    {
+      base = ::mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+
+      if (base == MAP_FAILED)
+	{
+	  base = 0;
+	  throw DLError("Could not map dl-cache file " + file + '.');
+	}
+    }
+
+  const char* begin = static_cast<const char*>(base);
+  const char* end = begin + length;
+  const std::size_t mlen = std::strlen(magic);
+
+  if (length < mlen || std::string(begin, mlen) != magic)
+    {
+      // an empty file or another version, start over
+      if (::ftruncate(fd, 0) != 0 || ::write(fd, magic, mlen) != static_cast<ssize_t>(mlen))
+	{
+	  throw DLError("Could not write dl-cache file " + file + '.');
+	}
+
+      known = mlen;
+      return;
+    }
+
+  const char* p = begin + mlen;
+
+  while (p < end)
+    {
+      const char* q = p;
+      std::size_t klen, vlen;
+
+      if (!number(q, end, klen, ' ') || !number(q, end, vlen, '\n') ||
+	  static_cast<std::size_t>(end - q) < klen + vlen + 1 || q[klen + vlen] != '\n')
+	{
+	  break;
+	}
+
+      Record r = { q + klen, vlen };
+      records.insert(std::make_pair(std::string(q, klen), r));
+
+      p = q + klen + vlen + 1;
+    }
+
+  if (p < end) // cut off a record a crashed run was not able to finish
+    {
+      if (::ftruncate(fd, p - begin) != 0)
+	{
+	  throw DLError("Could not write dl-cache file " + file + '.');
+	}
+
+      known = p - begin;
+    }
+}
+
+
+void
+CacheStore::compact() throw (DLError)
+{
+  if (!lock(LOCK_EX))
+    {
+      return; // another run compacted already
+    }
+
+  Unlock unlock(fd);
+
+  struct stat stbuf;
+
+  if (known == std::string::npos || ::fstat(fd, &stbuf) != 0 ||
+      static_cast<std::size_t>(stbuf.st_size) != known)
+    {
+      return; // we would lose the records of other runs
+    }
+
+  std::vector<char> name(file.begin(), file.end());
+  const char suffix[] = ".XXXXXX";
+  name.insert(name.end(), suffix, suffix + sizeof(suffix));
+
+  int tmpfd = ::mkstemp(&name[0]);
+
+  if (tmpfd == -1)
+    {
+      throw DLError("Could not compact dl-cache file " + file + '.');
+    }
+
+  ::close(tmpfd);
+
+  std::string tmp(&name[0]);
+  std::ofstream out(tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+  out << magic;
+
+  for (RecordMap::const_iterator it = records.begin(); it != records.end(); ++it)
+    {
+      out << it->first.size() << ' ' << it->second.size << '\n' << it->first;
+      out.write(it->second.data, it->second.size);
+      out << '\n';
+    }
+
+  out.close();
+
+  if (!out || std::rename(tmp.c_str(), file.c_str()) != 0)
+    {
+      std::remove(tmp.c_str());
+      throw DLError("Could not compact dl-cache file " + file + '.');
+    }
+
+  stale = false;
+}
+
+
+std::string
+CacheStore::validate(const QueryCtx& query)
+{
+  const Query& q = query.getQuery();
+  const DLQuery::shared_pointer& dlq = q.getDLQuery();
+  const Ontology::shared_pointer& o = dlq->getOntology();
+
+  const std::string& uri = o->getRealURI().getString();
+  const std::string& hash = o->getContentHash();
+
+  VersionMap::iterator v = versions.find(uri);
+
+  if (v == versions.end() || v->second != hash)
+    {
+      // records of a URI are adjacent, drop those of another content
+      std::string prefix = uri + '\n';
+      std::string current = prefix + hash + '\n';
+
+      RecordMap::iterator it = records.lower_bound(prefix);
+
+      while (it != records.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+	{
+	  if (it->first.compare(0, current.size(), current) != 0)
+	    {
+	      records.erase(it++);
+	      stale = true;
+	    }
+	  else
+	    {
+	      ++it;
+	    }
+	}
+
+      versions[uri] = hash;
+    }
+
+  std::ostringstream oss;
+  oss << uri << '\n' << hash << '\n'
+      << (Registry::getFlags() & Registry::UNA) << '\n'
+      << dlq->getCanonical() << '\n';
+
+  const ComfortInterpretation& i = q.getProjectedInterpretation();
+
+  for (ComfortInterpretation::const_iterator it = i.begin(); it != i.end(); ++it)
+    {
+      encode(oss, it->tuple);
+    }
+
+  return oss.str();
+}
+
+
+bool
+CacheStore::lookup(const QueryCtx& query)
+{
+  RecordMap::const_iterator r = records.find(validate(query));
+
+  if (r == records.end())
+    {
+      return false;
+    }
+
+  std::istringstream iss(std::string(r->second.data, r->second.size));
+  bool answer, incoherent;
+  std::size_t n;
+
+  if (!(iss >> answer >> incoherent >> n))
+    {
+      return false;
+    }
+
+  std::set<ComfortTuple> tuples;
+
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      ComfortTuple t;
+
+      if (!decode(iss, t))
+	{
+	  return false;
+	}
+
+      tuples.insert(t);
+    }
+
+  Answer& a = query.getAnswer();
+  a.setAnswer(answer);
+  a.setIncoherent(incoherent);
+  a.insert(tuples.begin(), tuples.end());
+
+  return true;
+}
+
+
+bool
+CacheStore::contains(const QueryCtx& query)
+{
+  return records.find(validate(query)) != records.end();
+}
+
+
+void
+CacheStore::store(const QueryCtx& query) throw (DLError)
+{
+  const Answer& a = query.getAnswer();
+
+  if (!a.getErrorMessage().empty())
+    {
+      return;
+    }
+
+  std::string key = validate(query);
+
+  if (records.find(key) != records.end())
+    {
+      return;
+    }
+
+  std::ostringstream val;
+  val << a.getAnswer() << ' ' << a.getIncoherent() << ' ' << a.size() << '\n';
+
+  for (Answer::const_iterator it = a.begin(); it != a.end(); ++it)
+    {
+      encode(val, *it);
+    }
+
+  appended.push_back(val.str());
+  const std::string& v = appended.back();
+
+  // one write per record, so concurrent runs append whole records
+  std::ostringstream rec;
+  rec << key.size() << ' ' << v.size() << '\n' << key << v << '\n';
+  std::string s = rec.str();
+
+  {
+    // a run which cuts off a torn record or compacts waits for us
+    if (!lock(LOCK_SH))
+      {
+	known = std::string::npos;
+      }
+
+    Unlock unlock(fd);
+
+    if (::write(fd, s.data(), s.size()) != static_cast<ssize_t>(s.size()))
+      {
+	throw DLError("Could not write dl-cache file " + file + '.');
+      }
+  }
+
+  if (known != std::string::npos)
+    {
+      known += s.size();
+    }
+
+  Record r = { v.data(), v.size() };
+  records.insert(std::make_pair(key, r));
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -31,9 +31,14 @@
  */
 
 #include "DLQuery.h"
+#include "URI.h"
 
 #include <dlvhex2/ComfortPluginInterface.h>
 
+#include <algorithm>
+#include <map>
+#include <sstream>
+
 
 namespace dlvhex {
 namespace dl {
@@ -41,10 +46,6 @@ namespace dl {
   bool
   operator< (const DLQuery& q1, const DLQuery& q2)
   {
-    ///@todo right now, we only support plain queries
-    assert(!q1.isConjQuery() && !q1.isUnionConjQuery());
-    assert(!q2.isConjQuery() && !q2.isUnionConjQuery());
-
     // first check if ontology of q1 is less or greater than the ontology of q2
 
     if (*q1.getOntology() < *q2.getOntology())
@@ -56,69 +57,151 @@ namespace dl {
 	return false;
       }
 
-    // otw. the ontologies are equal and we have to consider the
-    // actual queries
+    // otw. the ontologies are equal and we compare the equivalence
+    // classes of the actual queries
+    return q1.getCanonical() < q2.getCanonical();
+  }
+
+} // namespace dl
+} // namespace dlvhex
+
+
+namespace {
+
+  using namespace dlvhex;
+
+  typedef std::map<std::string, std::string> Renaming;
+
+  /// @return @a s without quotes, and with namespace @a nspace unless it is a URI
+  std::string
+  name(const std::string& s, const std::string& nspace)
+  {
+    std::string n;
+
+    for (std::string::const_iterator it = s.begin(); it != s.end(); ++it)
+      {
+	if (*it != '"') n += *it;
+      }
+
+    return dlvhex::dl::URI::isValid(n) ? n : nspace + n;
+  }
+
+  /// @return the canonical predicate of @a a
+  std::string
+  predicate(const ComfortAtom& a, const std::string& nspace)
+  {
+    std::string p = a.getPredicate();
+
+    if (p == "==" || p == "!=") // (in)equalities have no namespace
+      {
+	return p;
+      }
+
+    bool neg = a.isStrongNegated() || (!p.empty() && p[0] == '-');
+
+    if (!p.empty() && p[0] == '-')
+      {
+	p.erase(0, 1);
+      }
+
+    return (neg ? "-" : "") + name(p, nspace);
+  }
+
+  /**
+   * @return the canonical form of @a t, variables are looked up in
+   * @a r. Unknown variables get the next name of @a r if @a fresh is
+   * not empty, otherwise they become @a unknown.
+   */
+  std::string
+  term(const ComfortTerm& t, const std::string& nspace, Renaming& r,
+       const std::string& fresh, const std::string& unknown)
+  {
+    if (t.isAnon())
+      {
+	return "_";
+      }
+    else if (!t.isVariable())
+      {
+	return name(t.getUnquotedString(), nspace);
+      }
+
+    Renaming::const_iterator it = r.find(t.getUnquotedString());
 
-    bool lessthan = q1.getQuery().getUnquotedString() < q2.getQuery().getUnquotedString();
+    if (it != r.end())
+      {
+	return it->second;
+      }
+    else if (fresh.empty())
+      {
+	return unknown;
+      }
+
+    std::ostringstream oss;
+    oss << fresh << r.size();
+    return r[t.getUnquotedString()] = oss.str();
+  }
 
-    // if q1 >= q2 we have to look at the query types in order to
-    // compute the < relation on them
-    if (!lessthan)
+  /// @return the canonical form of @a a under the renaming @a r
+  std::string
+  atom(const ComfortAtom& a, const std::string& nspace, Renaming& r,
+       const std::string& fresh, const std::string& unknown)
+  {
+    std::string s = predicate(a, nspace) + '(';
+
+    for (std::size_t i = 1; i < a.tuple.size(); ++i)
       {
-	// check equality on q1 and q2
-	bool eq = q1 == q2;
-
-	const ComfortTuple& p1 = q1.getPatternTuple();
-	const ComfortTuple& p2 = q2.getPatternTuple();
-	
-	// if query types are equal we have to distinguish between the
-	// actual pattern tuples in a component-wise fashion
-	if (eq &&
-	    q1.getTypeFlags() == q2.getTypeFlags() &&
-	    p1.size() == p2.size())
-	  {
-	    unsigned long type = q1.getTypeFlags();
-	    
-	    ComfortTuple::const_iterator it1 = p1.begin();
-	    ComfortTuple::const_iterator it2 = p2.begin();
-	    unsigned long mask = 0x1;
-
-	    for (;
-		 it1 != p1.end() && it2 != p2.end();
-		 ++it1, ++it2, mask <<= 1
-		 )
-	      {
-		if ((type & mask) == mask)
-		  {
-		    if (*it1 < *it2)
-		      {
-			lessthan = true;
-			break;
-		      }
-		  }
-	      }
-	  }
-	else if (eq && p1.size() < p2.size())
-	  {
-	    // equal but arity differs
-	    lessthan = true;
-	  }
-	else if (eq && p1.size() == p2.size() &&
-		 q1.getTypeFlags() < q2.getTypeFlags())
-	  {
-	    // equal but types differ
-	    lessthan = true;
-	  }
-	else
-	  {
-	    // nothing to do, either q1 > q2, or q1 == q1 and
-	    // typeFlags or sizes are >=
-	  }
+	s += (i > 1 ? "," : "") + term(a.tuple[i], nspace, r, fresh, unknown);
       }
-    
-    return lessthan;
+
+    return s + ')';
   }
 
+  /// @return the canonical form of the conjunction @a cq
+  std::string
+  conjunction(const ComfortInterpretation& cq, const std::string& nspace, const Renaming& pattern)
+  {
+    // order the atoms by their shape, i.e., with the existential
+    // variables left out
+    std::vector<std::pair<std::string, const ComfortAtom*> > shapes;
+
+    for (ComfortInterpretation::const_iterator it = cq.begin(); it != cq.end(); ++it)
+      {
+	Renaming r(pattern);
+	shapes.push_back(std::make_pair(atom(*it, nspace, r, "", "?"), &*it));
+      }
+
+    std::stable_sort(shapes.begin(), shapes.end());
+
+    // rename the existential variables in the order of the shapes,
+    // and sort the renamed atoms again
+    Renaming r(pattern);
+    std::vector<std::string> atoms;
+
+    for (std::vector<std::pair<std::string, const ComfortAtom*> >::const_iterator it = shapes.begin();
+	 it != shapes.end(); ++it)
+      {
+	// existential names count on from the pattern variables
+	atoms.push_back(atom(*it->second, nspace, r, "?e", ""));
+      }
+
+    std::sort(atoms.begin(), atoms.end());
+
+    std::string s = "(";
+
+    for (std::vector<std::string>::const_iterator it = atoms.begin(); it != atoms.end(); ++it)
+      {
+	s += (it != atoms.begin() ? "," : "") + *it;
+      }
+
+    return s + ')';
+  }
+
+} // anonymous namespace
+
+
+namespace dlvhex {
+namespace dl {
+
 
 DLQuery::DLQuery(Ontology::shared_pointer o, const ComfortTerm& q, const ComfortTuple& p)
   : ontology(o),
@@ -126,9 +209,12 @@ DLQuery::DLQuery(Ontology::shared_pointer o, const ComfortTerm& q, const Comfort
     cq(),
     ucq(),
     pattern(),
-    typeFlags(0)
+    typeFlags(0),
+    datatype(false),
+    canonical()
 {
   setPatternTuple(p);
+  canonicalize();
 }
 
 
@@ -138,9 +224,12 @@ DLQuery::DLQuery(Ontology::shared_pointer o, const ComfortInterpretation& c, con
     cq(c),
     ucq(),
     pattern(),
-    typeFlags(0)
+    typeFlags(0),
+    datatype(false),
+    canonical()
 {
   setPatternTuple(p);
+  canonicalize();
 }
 
 
@@ -150,9 +239,12 @@ DLQuery::DLQuery(Ontology::shared_pointer o, const std::vector<ComfortInterpreta
     cq(),
     ucq(u.begin(), u.end()),
     pattern(),
-    typeFlags(0)
+    typeFlags(0),
+    datatype(false),
+    canonical()
 {
   setPatternTuple(p);
+  canonicalize();
 }
 
 
@@ -265,6 +357,99 @@ DLQuery::getPatternTuple() const
   return this->pattern;
 }
 
+
+bool
+DLQuery::isDatatype() const
+{
+  return this->datatype;
+}
+
+
+void
+DLQuery::setDatatype()
+{
+  this->datatype = true;
+  canonicalize();
+}
+
+
+const std::string&
+DLQuery::getCanonical() const
+{
+  return this->canonical;
+}
+
+
+void
+DLQuery::canonicalize()
+{
+  const std::string& nspace = ontology->getNamespace();
+
+  // the variables of the pattern tuple come first
+  Renaming r;
+  std::string pat = "(";
+
+  for (ComfortTuple::const_iterator it = pattern.begin(); it != pattern.end(); ++it)
+    {
+      pat += (it != pattern.begin() ? "," : "") + term(*it, nspace, r, "?", "");
+    }
+
+  pat += ')';
+
+  std::vector<std::string> disjuncts;
+  char kind = 'Q'; // a (union of) conjunctive queries
+
+  if (isUnionConjQuery())
+    {
+      for (std::vector<ComfortInterpretation>::const_iterator it = ucq.begin(); it != ucq.end(); ++it)
+	{
+	  disjuncts.push_back(conjunction(*it, nspace, r));
+	}
+
+      std::sort(disjuncts.begin(), disjuncts.end());
+    }
+  else if (isConjQuery())
+    {
+      disjuncts.push_back(conjunction(cq, nspace, r));
+    }
+  else // plain query, i.e., a single atom over the pattern tuple
+    {
+      ComfortAtom a;
+      a.tuple.push_back(query);
+      a.tuple.insert(a.tuple.end(), pattern.begin(), pattern.end());
+
+      ComfortInterpretation i;
+      i.insert(a);
+      disjuncts.push_back(conjunction(i, nspace, r));
+
+      // only the answers of retrievals with distinct variables are
+      // shaped like the answers of the corresponding conjunctive
+      // query
+      bool distinct = typeFlags == 0 && r.size() == pattern.size();
+
+      for (ComfortTuple::const_iterator it = pattern.begin(); it != pattern.end(); ++it)
+	{
+	  distinct = distinct && it->isVariable() && !it->isAnon();
+	}
+
+      kind = distinct ? 'Q' : 'P';
+    }
+
+  if (datatype) // datatype fillers are not individuals
+    {
+      kind = 'D';
+    }
+
+  canonical = kind;
+
+  for (std::vector<std::string>::const_iterator it = disjuncts.begin(); it != disjuncts.end(); ++it)
+    {
+      canonical += (it != disjuncts.begin() ? " v " : "") + *it;
+    }
+
+  canonical += pat;
+}
+
 } // namespace dl
 } // namespace dlvhex
 
@@ -37,9 +37,14 @@
 
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <cctype>   // tolower(), isalpha()
+#include <cstring>  // strchr(), strlen()
 
 #include <raptor.h>
 
+#include <boost/thread/mutex.hpp>
+
 using namespace dlvhex::dl;
 
 
@@ -48,6 +53,7 @@ const std::string OWLParser::rdfType  = "http://www.w3.org/1999/02/22-rdf-syntax
 const std::string OWLParser::rdfsNspace = "http://www.w3.org/2000/01/rdf-schema";
 const std::string OWLParser::rdfNspace = "http://www.w3.org/1999/02/22-rdf-syntax-ns";
 const std::string OWLParser::owlNspace = "http://www.w3.org/2002/07/owl";
+const std::string OWLParser::owlImports = "http://www.w3.org/2002/07/owl#imports";
 
 const std::string OWLParser::owlClass = "http://www.w3.org/2002/07/owl#Class";
 const std::string OWLParser::owlObjectProperty = "http://www.w3.org/2002/07/owl#ObjectProperty";
@@ -74,37 +80,127 @@ OWLParser::open(const URI& uri)
 
 
 
+namespace {
+
+  /**
+   * @brief Keeps libraptor initialized while any thread parses or
+   * downloads a document.
+   *
+   * raptor_finish() and raptor_www_finish() tear down global state,
+   * so only the last user may call them.
+   */
+  class RaptorLibrary
+  {
+  private:
+    /// protects #users and #wwwUsers
+    static boost::mutex mutex;
+    /// number of living RaptorLibrary objects
+    static unsigned users;
+    /// number of living RaptorLibrary objects which use raptor_www
+    static unsigned wwwUsers;
+
+    /// true if this object uses raptor_www
+    bool www;
+
+  public:
+    explicit
+    RaptorLibrary(bool w = false)
+      : www(w)
+    {
+      boost::mutex::scoped_lock lock(mutex);
+
+      if (users++ == 0)
+	{
+	  raptor_init();
+	}
+
+      if (www && wwwUsers++ == 0)
+	{
+	  raptor_www_init();
+	}
+    }
+
+    ~RaptorLibrary()
+    {
+      boost::mutex::scoped_lock lock(mutex);
+
+      if (www && --wwwUsers == 0)
+	{
+	  raptor_www_finish();
+	}
+
+      if (--users == 0)
+	{
+	  raptor_finish();
+	}
+    }
+  };
+
+  boost::mutex RaptorLibrary::mutex;
+  unsigned RaptorLibrary::users = 0;
+  unsigned RaptorLibrary::wwwUsers = 0;
+
+} // anonymous namespace
+
+
 namespace dlvhex {
   namespace dl {
 
 
+    /**
+     * What a pass over the OWL document collects, a 0 member is
+     * skipped.
+     */
+    struct OWLDocument
+    {
+      /// the parser, so we can stop early
+      raptor_parser* parser;
+      /// default namespace
+      std::string* nspace;
+      /// true if #nspace has been found
+      bool found;
+      /// concept and role names
+      TBox* tbox;
+      /// individuals
+      ABox* abox;
+      /// URIs of the imported documents
+      std::vector<std::string>* imports;
+      /// reused for the names of the individuals
+      ComfortTerm individual;
+
+      OWLDocument()
+	: parser(0), nspace(0), found(false), tbox(0), abox(0), imports(0),
+	  individual(ComfortTerm::createConstant(""))
+      { }
+    };
+
+
     /**
      * The namespace callback handler for libraptor.
      */
     void
     namespaceHandler(void* userData, raptor_namespace* nspace)
     {
-      std::string* nsData = (std::string*) userData;
+      OWLDocument* doc = (OWLDocument*) userData;
       
       const char* nsPrefix = (const char*) raptor_namespace_get_prefix(nspace);
       
-      if (nsPrefix == 0) // default namespace
+      // the default namespace of the root element counts
+      if (nsPrefix == 0 && doc->nspace && !doc->found)
 	{
 	  raptor_uri* ns = raptor_namespace_get_uri(nspace);
-	  nsData->assign((const char*) raptor_uri_as_string(ns));
+	  doc->nspace->assign((const char*) raptor_uri_as_string(ns));
+	  doc->found = true;
 	}
     }
 
 
     /**
-     * The concept and role name handler for libraptor.
+     * Adds the concept or role name of an rdf:type statement.
      */
     void
-    tboxHandler(void* userData, const raptor_statement* statement)
+    addTBox(TBox& tbox, const raptor_statement* statement)
     {
-      TBox* tbox = (TBox*) userData;
-      
-      const char* pred = (const char*) statement->predicate;
       const char* obj  = (const char*) statement->object;
 
       //
@@ -113,54 +209,61 @@ namespace dlvhex {
       // we can dispatch O being one of owl:Class, owl:ObjectProperty,
       // ...
       //
-      if (OWLParser::rdfType.compare(pred) == 0 &&
-	  statement->subject_type == RAPTOR_IDENTIFIER_TYPE_RESOURCE) 
+      if (statement->subject_type == RAPTOR_IDENTIFIER_TYPE_RESOURCE) 
 	{
 	  if (OWLParser::owlObjectProperty.compare(obj) == 0)
 	    {
-	      tbox->addRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlTransitiveProperty.compare(obj) == 0)
 	    {
-	      tbox->addRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlSymmetricProperty.compare(obj) == 0)
 	    {
-	      tbox->addRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlFunctionalProperty.compare(obj) == 0)
 	    {
-	      tbox->addRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlInverseFunctionalProperty.compare(obj) == 0)
 	    {
-	      tbox->addRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlDatatypeProperty.compare(obj) == 0)
 	    {
-	      tbox->addDatatypeRole(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addDatatypeRole(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	  else if (OWLParser::owlClass.compare(obj) == 0)
 	    {
-	      tbox->addConcept(ComfortTerm::createConstant((const char*) statement->subject));
+	      tbox.addConcept(ComfortTerm::createConstant((const char*) statement->subject));
 	    }
 	}
     }
 
     
     /**
-     * The individual handler for libraptor.
+     * @return true if the namespace of @a obj, which has @a n
+     * characters, is @a ns
      */
-    void
-    aboxHandler(void* userData, const raptor_statement* statement)
+    inline bool
+    inNamespace(const std::string& ns, const char* obj, std::size_t n)
     {
-      ABox* abox = (ABox*) userData;
+      return ns.size() == n && ns.compare(0, n, obj, n) == 0;
+    }
+
 
-      const char* pred = (const char*) statement->predicate;
-      const std::string obj = (const char*) statement->object;
+    /**
+     * Adds the individual of an rdf:type statement.
+     */
+    void
+    addABox(ABox& abox, ComfortTerm& individual, const raptor_statement* statement)
+    {
+      const char* obj = (const char*) statement->object;
       
-      std::string::size_type pos = obj.find_first_of('#'); ///@todo using # as delimiter is kind of foo?
-      std::string objNspace = obj.substr(0, pos);
+      const char* pos = std::strchr(obj, '#'); ///@todo using # as delimiter is kind of foo?
+      std::size_t n = pos ? pos - obj : std::strlen(obj);
       
       //???
       // A triple with an individual S has one of following forms
@@ -169,21 +272,170 @@ namespace dlvhex {
       // where namespace of O must not equal to rdf, rdfs or owl.
       //
       ///@todo what about individual equality?
-      if ((OWLParser::rdfType.compare(pred) == 0 &&
-	   OWLParser::owlThing.compare(obj) == 0) ||
-	  (OWLParser::rdfType.compare(pred) == 0 &&
-	   OWLParser::rdfNspace  != objNspace &&
-	   OWLParser::rdfsNspace != objNspace &&
-	   OWLParser::owlNspace  != objNspace
+      if (OWLParser::owlThing.compare(obj) == 0 ||
+	  (!inNamespace(OWLParser::rdfNspace, obj, n) &&
+	   !inNamespace(OWLParser::rdfsNspace, obj, n) &&
+	   !inNamespace(OWLParser::owlNspace, obj, n)
 	   )
 	  )
 	{
-	  std::string subj = (const char*) statement->subject;
-	  abox->addIndividual(ComfortTerm::createConstant("\"<" + subj + ">\""));
+	  // the buffer keeps its capacity, so only the first triple of
+	  // an individual allocates its name
+	  individual.strval.assign("\"<").append((const char*) statement->subject).append(">\"");
+
+	  if (abox.getIndividuals()->count(individual) == 0)
+	    {
+	      abox.addIndividual(individual);
+	    }
 	}
     }
 
 
+    /**
+     * The statement handler for libraptor, which dispatches the
+     * rdf:type statements to the TBox and the ABox.
+     */
+    void
+    statementHandler(void* userData, const raptor_statement* statement)
+    {
+      OWLDocument* doc = (OWLDocument*) userData;
+
+      if (!doc->tbox && !doc->abox && !doc->imports) // only the namespace is asked for
+	{
+	  // namespaces are declared before the statements they scope
+	  if (doc->found)
+	    {
+	      raptor_parse_abort(doc->parser);
+	    }
+
+	  return;
+	}
+
+      if (OWLParser::rdfType.compare((const char*) statement->predicate) != 0)
+	{
+	  if (doc->imports &&
+	      statement->object_type == RAPTOR_IDENTIFIER_TYPE_RESOURCE &&
+	      OWLParser::owlImports.compare((const char*) statement->predicate) == 0)
+	    {
+	      doc->imports->push_back((const char*) statement->object);
+	    }
+
+	  return;
+	}
+
+      if (doc->tbox)
+	{
+	  addTBox(*doc->tbox, statement);
+	}
+
+      if (doc->abox)
+	{
+	  addABox(*doc->abox, doc->individual, statement);
+	}
+    }
+
+
+    /**
+     * @param p the first character after a '<'
+     * @param end
+     *
+     * @return true if [p, end) starts with an XML tag like rdf:RDF,
+     * and false if it starts with an IRI like http://... of N-Triples
+     * or Turtle
+     */
+    bool
+    isElement(const char* p, const char* end)
+    {
+      const char* q = p;
+
+      if (q == end || !(std::isalpha(static_cast<unsigned char>(*q)) || *q == '_'))
+	{
+	  return false;
+	}
+
+      // an XML name has no '/' or '#', unlike the IRI of a triple
+      while (q < end && (std::isalnum(static_cast<unsigned char>(*q)) ||
+			 *q == '_' || *q == '-' || *q == '.' || *q == ':'))
+	{
+	  ++q;
+	}
+
+      return q == end || *q == '>' || std::isspace(static_cast<unsigned char>(*q))
+	|| (*q == '/' && q + 1 < end && q[1] == '>');
+    }
+
+
+    /**
+     * Selects the raptor parser for the document at @a uri by its
+     * extension, or by sniffing its first bytes.
+     *
+     * @param uri
+     *
+     * @return the name of the raptor parser
+     */
+    const char*
+    syntaxOf(const URI& uri)
+    {
+      if (!uri.isLocal()) // we cannot look into it
+	{
+	  return "rdfxml";
+	}
+
+      const std::string path = uri.getPath();
+      std::string::size_type dot = path.find_last_of("./");
+
+      if (dot != std::string::npos && path[dot] == '.')
+	{
+	  std::string ext = path.substr(dot + 1);
+
+	  for (std::string::iterator it = ext.begin(); it != ext.end(); ++it)
+	    {
+	      *it = std::tolower(*it);
+	    }
+
+	  if (ext == "nt")
+	    {
+	      return "ntriples";
+	    }
+	  else if (ext == "ttl" || ext == "n3")
+	    {
+	      return "turtle";
+	    }
+	  else if (ext == "rdf" || ext == "owl" || ext == "xml")
+	    {
+	      return "rdfxml";
+	    }
+	}
+
+      // sniff the document, e.g., a downloaded temporary file
+      std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+      char buf[256];
+      in.read(buf, sizeof(buf));
+
+      const char* p = buf;
+      const char* end = buf + in.gcount();
+
+      if (end - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) // UTF-8 BOM
+	{
+	  p += 3;
+	}
+
+      while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+	{
+	  ++p;
+	}
+
+      // XML starts with a declaration, a comment, or an element,
+      // N-Triples and Turtle are parsed by the Turtle parser
+      if (p == end || (*p == '<' && p + 1 < end && (p[1] == '?' || p[1] == '!')))
+	{
+	  return "rdfxml";
+	}
+
+      return *p == '<' && isElement(p + 1, end) ? "rdfxml" : "turtle";
+    }
+
+
     /** 
      * Download callback.
      */
@@ -228,20 +480,15 @@ namespace dlvhex {
 } // namespace dlvhex
 
 
-/// Helper struct
-struct OWLParser::HandlerFuns
-{
-  raptor_statement_handler stmHandler;
-  raptor_namespace_handler nsHandler;
-};
-
-
 void
-OWLParser::parse(void* userData, const HandlerFuns* handler) throw (DLParsingError)
+OWLParser::parse(OWLDocument& doc) throw (DLParsingError)
 {
-  raptor_init();
+  RaptorLibrary raptor;
+
+  raptor_parser* parser = raptor_new_parser(syntaxOf(uri));
 
-  raptor_parser* parser = raptor_new_parser("rdfxml");
+  doc.parser = parser;
+  doc.found = false;
 
   std::string error;
 
@@ -251,14 +498,11 @@ OWLParser::parse(void* userData, const HandlerFuns* handler) throw (DLParsingErr
 
   raptor_uri* parseURI  = raptor_new_uri((const unsigned char*) uri.getString().c_str());
 
-  if (handler->stmHandler)
-    {
-      raptor_set_statement_handler(parser, userData, handler->stmHandler);
-    }
+  raptor_set_statement_handler(parser, &doc, statementHandler);
 
-  if (handler->nsHandler)
+  if (doc.nspace)
     {
-      raptor_set_namespace_handler(parser, userData, handler->nsHandler);
+      raptor_set_namespace_handler(parser, &doc, namespaceHandler);
     }
 
   raptor_parse_uri(parser, parseURI, 0);
@@ -270,32 +514,67 @@ OWLParser::parse(void* userData, const HandlerFuns* handler) throw (DLParsingErr
     {
       throw DLParsingError(error);
     }
-
-  raptor_finish();
 }
 
 
 void
 OWLParser::parseABox(ABox& abox) throw (DLParsingError)
 {
-  HandlerFuns funs = { aboxHandler, 0 };
-  parse(&abox, &funs);
+  OWLDocument doc;
+  doc.nspace = 0;
+  doc.tbox = 0;
+  doc.abox = &abox;
+  doc.imports = 0;
+  parse(doc);
 }
 
 
 void
 OWLParser::parseTBox(TBox& tbox) throw (DLParsingError)
 {
-  HandlerFuns funs = { tboxHandler, 0 };
-  parse(&tbox, &funs);
+  OWLDocument doc;
+  doc.nspace = 0;
+  doc.tbox = &tbox;
+  doc.abox = 0;
+  doc.imports = 0;
+  parse(doc);
 }
 
 
 void
 OWLParser::parseNamespace(std::string& ns) throw (DLParsingError)
 {
-  HandlerFuns funs = { 0, namespaceHandler };
-  parse(&ns, &funs);
+  OWLDocument doc;
+  doc.nspace = &ns;
+  doc.tbox = 0;
+  doc.abox = 0;
+  doc.imports = 0;
+  parse(doc);
+}
+
+
+void
+OWLParser::parseOntology(std::string& ns, TBox& tbox, ABox& abox) throw (DLParsingError)
+{
+  OWLDocument doc;
+  doc.nspace = &ns;
+  doc.tbox = &tbox;
+  doc.abox = &abox;
+  doc.imports = 0;
+  parse(doc);
+}
+
+
+void
+OWLParser::parseOntology(std::string& ns, TBox& tbox, ABox& abox,
+			 std::vector<std::string>& imports) throw (DLParsingError)
+{
+  OWLDocument doc;
+  doc.nspace = &ns;
+  doc.tbox = &tbox;
+  doc.abox = &abox;
+  doc.imports = &imports;
+  parse(doc);
 }
 
 
@@ -303,16 +582,12 @@ void
 OWLParser::fetchURI(const std::string& file)
   throw (DLParsingError)
 {
-  raptor_init();
-
-  raptor_www_init();
+  RaptorLibrary raptor(true);
 
   raptor_uri* fetchURI = raptor_new_uri((const unsigned char*) uri.getString().c_str());
 
   raptor_iostream* io = raptor_new_iostream_to_filename(file.c_str());
 
-  raptor_www_init();
-
   raptor_www* rw3 = raptor_www_new();
 
   raptor_www_set_write_bytes_handler(rw3, writeBytesHandler, io);
@@ -326,10 +601,6 @@ OWLParser::fetchURI(const std::string& file)
   raptor_free_uri(fetchURI);
   raptor_free_iostream(io);
 
-  raptor_www_finish();
-  
-  raptor_finish();
-
   if (!error.empty())
     {
       throw DLParsingError(error);
@@ -31,19 +31,57 @@
  */
 
 #include "Ontology.h"
+#include "OntologySnapshot.h"
 #include "OWLParser.h"
+#include "Registry.h"
 #include "URI.h"
 
 #include <string>
+#include <sstream>
+#include <fstream>
 #include <map>
 #include <iterator>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 #include <cstdio>   // tempnam(), remove()
 #include <cstdlib>  // free()
+#include <sys/types.h>
+#include <sys/stat.h> // stat()
 
 using namespace dlvhex::dl;
 
 
+namespace {
+
+  /// adds @a n bytes at @a p to the 64-bit FNV-1a hash @a h
+  unsigned long long
+  fnv1a(unsigned long long h, const char* p, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	h = (h ^ static_cast<unsigned char>(p[i])) * 0x100000001b3ULL;
+      }
+
+    return h;
+  }
+
+  /// the FNV-1a offset basis
+  const unsigned long long fnvBasis = 0xcbf29ce484222325ULL;
+
+  /// protects the ontologies of Ontology::createOntology()
+  boost::mutex ontologyMutex;
+
+  /// signals that an ontology has been opened or failed to open
+  boost::condition_variable ontologyOpened;
+
+} // anonymous namespace
+
+
+std::string Ontology::snapshotDirectory;
+
+
 Ontology::~Ontology()
 {
   if (!realuri.isLocal()) // remove downloaded temporary file
@@ -61,7 +99,12 @@ Ontology::Ontology(const URI& u, const std::string& tempfile)
     realuri(u),
     nspace(),
     tbox(0),
-    abox(0)
+    abox(0),
+    imports(),
+    hashedFingerprint(),
+    contentHash(),
+    snapshot(),
+    mutex()
 {
   OWLParser p(uri);
 
@@ -72,7 +115,24 @@ Ontology::Ontology(const URI& u, const std::string& tempfile)
       p.open(uri);
     }
 
-  p.parseNamespace(nspace);
+  if (realuri.isLocal() && !snapshotDirectory.empty())
+    {
+      snapshot.reset(new OntologySnapshot(getSnapshotFile()));
+
+      if (!isSnapshotValid())
+	{
+	  snapshot.reset();
+	}
+    }
+
+  if (snapshot)
+    {
+      nspace = snapshot->getNamespace();
+    }
+  else
+    {
+      p.parseNamespace(nspace);
+    }
 }
 
 
@@ -81,7 +141,12 @@ Ontology::Ontology(const Ontology& o)
     realuri(o.realuri),
     nspace(o.nspace),
     tbox(o.tbox ? new TBox(*o.tbox) : 0),
-    abox(o.abox ? new ABox(*o.abox) : 0)
+    abox(o.abox ? new ABox(*o.abox) : 0),
+    imports(o.imports),
+    hashedFingerprint(o.hashedFingerprint),
+    contentHash(o.contentHash),
+    snapshot(o.snapshot),
+    mutex()
 { }
 
 
@@ -95,23 +160,37 @@ Ontology::operator= (const Ontology&)
 Ontology::shared_pointer
 Ontology::createOntology(const std::string& uri)
 {
-  // we only want one Ontology instance per uri
+  // we only want one Ontology instance per uri, an empty entry is
+  // being opened by another thread
   typedef std::map<URI, Ontology::shared_pointer> OntologyMap;
   static OntologyMap ontomap;
 
   URI finduri(uri, true); // we want absolute pathnames
 
-  OntologyMap::const_iterator o = ontomap.find(finduri);
+  boost::mutex::scoped_lock lock(ontologyMutex);
+
+  OntologyMap::iterator o = ontomap.find(finduri);
+
+  while (o != ontomap.end() && !o->second)
+    {
+      ontologyOpened.wait(lock);
+      o = ontomap.find(finduri);
+    }
 
   if (o != ontomap.end())
     {
       return o->second;
     }
 
+  o = ontomap.insert(std::make_pair(finduri, Ontology::shared_pointer())).first;
+
+  // open the document without blocking the other documents
+  lock.unlock();
+
+  Ontology::shared_pointer osp;
+
   try
     {
-      Ontology::shared_pointer osp;
-
       if (finduri.isLocal())
 	{
 	  osp = Ontology::shared_pointer(new Ontology(finduri));
@@ -125,16 +204,31 @@ Ontology::createOntology(const std::string& uri)
 
 	  osp = Ontology::shared_pointer(new Ontology(finduri, tmpstr));
 	}
-
-      // identify finduri with osp
-      ontomap[finduri] = osp;
-
-      return osp;
     }
-  catch (DLParsingError& e)
+  catch (...)
     {
-      throw DLParsingError("Couldn't parse document " + uri + ": " + e.what());
+      // let the next caller try again
+      lock.lock();
+      ontomap.erase(o);
+      ontologyOpened.notify_all();
+
+      try
+	{
+	  throw;
+	}
+      catch (DLParsingError& e)
+	{
+	  throw DLParsingError("Couldn't parse document " + uri + ": " + e.what());
+	}
     }
+
+  lock.lock();
+
+  // identify finduri with osp
+  o->second = osp;
+  ontologyOpened.notify_all();
+
+  return osp;
 }
 
 
@@ -159,22 +253,152 @@ Ontology::getNamespace() const
 }
 
 
-const TBox&
-Ontology::getTBox() const
+std::string
+Ontology::getFingerprint() const
 {
-  if (!tbox)
+  // size and modification time of the (downloaded) OWL document are
+  // sufficient to detect a modified document
+  std::ostringstream oss;
+  struct stat stbuf;
+
+  if (::stat(uri.getPath().c_str(), &stbuf) == 0)
+    {
+      oss << stbuf.st_size << '-' << stbuf.st_mtime;
+    }
+
+  return oss.str();
+}
+
+
+const std::string&
+Ontology::getContentHash() const
+{
+  boost::recursive_mutex::scoped_lock lock(mutex);
+
+  std::string fp = getFingerprint();
+
+  if (contentHash.empty() || fp != hashedFingerprint)
+    {
+      std::ifstream in(uri.getPath().c_str(), std::ios::in | std::ios::binary);
+      char buf[8192];
+
+      // 64-bit FNV-1a, which does not depend on the build like
+      // boost::hash does, so persistent keys stay valid
+      unsigned long long h = fnvBasis;
+
+      while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+	{
+	  h = fnv1a(h, buf, in.gcount());
+	}
+
+      std::ostringstream oss;
+      oss << std::hex << h;
+
+      contentHash = oss.str();
+      hashedFingerprint = fp;
+    }
+
+  return contentHash;
+}
+
+
+void
+Ontology::setSnapshotDirectory(const std::string& dir)
+{
+  snapshotDirectory = dir;
+}
+
+
+std::string
+Ontology::getSnapshotFile() const
+{
+  // one snapshot per document
+  const std::string& path = uri.getPath();
+
+  std::ostringstream oss;
+  oss << snapshotDirectory << '/' << std::hex
+      << fnv1a(fnvBasis, path.data(), path.size()) << ".snapshot";
+
+  return oss.str();
+}
+
+
+bool
+Ontology::isSnapshotValid() const
+{
+  if (!snapshot->isValid() || snapshot->getPath() != uri.getPath())
+    {
+      return false;
+    }
+
+  std::string fp = getFingerprint();
+
+  if (snapshot->getFingerprint() == fp) // the document is untouched
+    {
+      // so we don't have to read it for the content hash either
+      contentHash = snapshot->getContentHash();
+      hashedFingerprint = fp;
+      return true;
+    }
+
+  // the document has been touched, but may be the same
+  return getContentHash() == snapshot->getContentHash();
+}
+
+
+void
+Ontology::parse() const
+{
+  tbox = new TBox;
+  abox = new ABox;
+
+  if (snapshot)
+    {
+      snapshot->getTBox(*tbox);
+      snapshot->getABox(*abox);
+      snapshot->getImports(imports);
+      return;
+    }
+
+  try
+    {
+      // the TBox and the ABox come from a single pass over the document
+      std::string ns;
+      OWLParser p(uri);
+      p.parseOntology(ns, *tbox, *abox, imports);
+    }
+  catch (DLParsingError& e)
+    {
+      throw DLParsingError("Couldn't parse document " + uri.getString() + ": " + e.what());
+    }
+
+  if (realuri.isLocal() && !snapshotDirectory.empty())
     {
       try
 	{
-	  tbox = new TBox;
-	  OWLParser p(uri);
-	  p.parseTBox(*tbox);
+	  OntologySnapshot::write(getSnapshotFile(), *this, *tbox, *abox, imports);
 	}
-      catch (DLParsingError& e)
+      catch (DLError& e)
 	{
-	  throw DLParsingError("Couldn't parse document " + uri.getString() + ": " + e.what());
+	  // the next run just parses the document again
+	  if (Registry::getVerbose() > 0)
+	    {
+	      std::cerr << "Warning: " << e.what() << std::endl;
+	    }
 	}
     }
+}
+
+
+const TBox&
+Ontology::getTBox() const
+{
+  boost::recursive_mutex::scoped_lock lock(mutex);
+
+  if (!tbox)
+    {
+      parse();
+    }
 
   return *tbox;
 }
@@ -183,24 +407,31 @@ Ontology::getTBox() const
 const ABox&
 Ontology::getABox() const
 {
+  boost::recursive_mutex::scoped_lock lock(mutex);
+
   if (!abox)
     {
-      try
-	{
-	  abox = new ABox;
-	  OWLParser p(uri);
-	  p.parseABox(*abox);
-	}
-      catch (DLParsingError& e)
-	{
-	  throw DLParsingError("Couldn't parse document " + uri.getString() + ": " + e.what());
-	}
+      parse();
     }
 
   return *abox;
 }
 
 
+const std::vector<std::string>&
+Ontology::getImports() const
+{
+  boost::recursive_mutex::scoped_lock lock(mutex);
+
+  if (!tbox)
+    {
+      parse();
+    }
+
+  return imports;
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
@@ -0,0 +1,162 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   OntologyLoader.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 23:05:18 2026
+ *
+ * @brief  Loads ontologies and their imports concurrently.
+ *
+ *
+ */
+
+
+#include "OntologyLoader.h"
+#include "DLError.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace dlvhex::dl;
+
+
+OntologyLoader::OntologyLoader()
+  : pending(),
+    seen(),
+    loaded(),
+    errors(),
+    busy(0),
+    mutex(),
+    changed()
+{ }
+
+
+void
+OntologyLoader::push(const std::string& uri)
+{
+  if (seen.insert(URI(uri, true)).second)
+    {
+      pending.push_back(uri);
+      changed.notify_one();
+    }
+}
+
+
+void
+OntologyLoader::add(const std::string& uri)
+{
+  boost::mutex::scoped_lock lock(mutex);
+  push(uri);
+}
+
+
+void
+OntologyLoader::work()
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  for (;;)
+    {
+      // a busy thread may still queue imports
+      while (pending.empty() && busy > 0)
+	{
+	  changed.wait(lock);
+	}
+
+      if (pending.empty()) // nothing left to do
+	{
+	  changed.notify_all();
+	  return;
+	}
+
+      std::string uri = pending.front();
+      pending.pop_front();
+      ++busy;
+
+      lock.unlock();
+
+      Ontology::shared_pointer onto;
+      std::string error;
+
+      try
+	{
+	  onto = Ontology::createOntology(uri);
+	  onto->getTBox(); // parses the names and the imports
+	}
+      catch (std::exception& e) // the thread must not die
+	{
+	  error = e.what();
+	}
+
+      lock.lock();
+
+      --busy;
+
+      if (onto)
+	{
+	  loaded.push_back(onto);
+
+	  const std::vector<std::string>& imports = onto->getImports();
+	  std::for_each(imports.begin(), imports.end(),
+			boost::bind(&OntologyLoader::push, this, _1));
+	}
+      else
+	{
+	  errors.push_back(error);
+	}
+
+      if (pending.empty() && busy == 0)
+	{
+	  changed.notify_all();
+	}
+    }
+}
+
+
+const OntologyLoader::Ontologies&
+OntologyLoader::load(unsigned threads)
+{
+  if (threads == 0)
+    {
+      threads = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+
+  // idle threads wait for the imports the busy ones find
+  boost::thread_group pool;
+
+  for (unsigned i = 0; i < threads; ++i)
+    {
+      pool.create_thread(boost::bind(&OntologyLoader::work, this));
+    }
+
+  pool.join_all();
+
+  return loaded;
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -0,0 +1,425 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   OntologySnapshot.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 21:12:40 2026
+ *
+ * @brief  A binary snapshot of the names of an ontology.
+ *
+ *
+ */
+
+
+#include "OntologySnapshot.h"
+
+#include <map>
+#include <fstream>
+#include <cstdio>       // rename(), remove()
+#include <cstdlib>      // mkstemp()
+#include <cstring>      // memcpy(), memcmp()
+#include <cstddef>      // ptrdiff_t
+
+#include <fcntl.h>      // open()
+#include <unistd.h>     // close()
+#include <sys/types.h>
+#include <sys/stat.h>   // fstat()
+#include <sys/mman.h>   // mmap(), munmap()
+#include <stdint.h>     // uint32_t
+
+using namespace dlvhex::dl;
+
+
+namespace {
+
+  /// the start of a snapshot, bump the version if the format changes
+  const char magic[16] = { 'd','l','v','h','e','x',' ','o','n','t','o',' ','s','n','p','2' };
+
+  /**
+   * @brief Reads the numbers and strings of a mapped snapshot.
+   */
+  struct Reader
+  {
+    const char* p;
+    const char* end;
+
+    /// @return false if there is no number at #p
+    bool
+    number(uint32_t& n)
+    {
+      if (end - p < static_cast<std::ptrdiff_t>(sizeof(n)))
+	{
+	  return false;
+	}
+
+      std::memcpy(&n, p, sizeof(n)); // p may be unaligned
+      p += sizeof(n);
+      return true;
+    }
+
+    /// @return false if there is no string at #p
+    bool
+    string(std::pair<const char*, std::size_t>& s)
+    {
+      uint32_t n;
+
+      if (!number(n) || static_cast<std::size_t>(end - p) < n)
+	{
+	  return false;
+	}
+
+      s = std::make_pair(p, static_cast<std::size_t>(n));
+      p += n;
+      return true;
+    }
+
+    /// @return false if there is no array of @a max IDs at most at #p
+    bool
+    skipArray(uint32_t max)
+    {
+      uint32_t n;
+
+      if (!number(n) || static_cast<std::size_t>(end - p) / sizeof(n) < n)
+	{
+	  return false;
+	}
+
+      for (uint32_t i = 0; i < n; ++i)
+	{
+	  uint32_t id;
+	  number(id);
+
+	  if (id >= max)
+	    {
+	      return false;
+	    }
+	}
+
+      return true;
+    }
+  };
+
+
+  void
+  putNumber(std::ostream& os, uint32_t n)
+  {
+    os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  }
+
+
+  void
+  putString(std::ostream& os, const std::string& s)
+  {
+    putNumber(os, s.size());
+    os.write(s.data(), s.size());
+  }
+
+
+  /// maps names to their IDs
+  typedef std::map<std::string, uint32_t> NameMap;
+
+
+  /// interns the names of @a objs
+  void
+  intern(const TBox::Objects& objs, NameMap& ids, std::vector<const std::string*>& names)
+  {
+    for (TBox::Objects::const_iterator it = objs.begin(); it != objs.end(); ++it)
+      {
+	NameMap::iterator i = ids.lower_bound(it->strval);
+
+	if (i == ids.end() || i->first != it->strval)
+	  {
+	    i = ids.insert(i, std::make_pair(it->strval, static_cast<uint32_t>(names.size())));
+	    names.push_back(&i->first);
+	  }
+      }
+  }
+
+
+  void
+  putArray(std::ostream& os, const TBox::Objects& objs, const NameMap& ids)
+  {
+    putNumber(os, objs.size());
+
+    for (TBox::Objects::const_iterator it = objs.begin(); it != objs.end(); ++it)
+      {
+	putNumber(os, ids.find(it->strval)->second);
+      }
+  }
+
+} // anonymous namespace
+
+
+
+OntologySnapshot::OntologySnapshot(const std::string& file)
+  : base(0),
+    length(0),
+    path(),
+    fingerprint(),
+    hash(),
+    nspace(),
+    imports(),
+    names()
+{
+  int fd = ::open(file.c_str(), O_RDONLY);
+
+  if (fd == -1)
+    {
+      return;
+    }
+
+  struct stat stbuf;
+
+  if (::fstat(fd, &stbuf) == 0 && stbuf.st_size > 0)
+    {
+      length = stbuf.st_size;
+      base = ::mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (base == MAP_FAILED)
+	{
+	  base = 0;
+	}
+    }
+
+  // the mapping stays valid after closing the file
+  ::close(fd);
+
+  if (base && !index())
+    {
+      ::munmap(base, length);
+      base = 0;
+    }
+}
+
+
+OntologySnapshot::~OntologySnapshot()
+{
+  if (base)
+    {
+      ::munmap(base, length);
+    }
+}
+
+
+bool
+OntologySnapshot::index()
+{
+  Reader r = { static_cast<const char*>(base), static_cast<const char*>(base) + length };
+
+  if (length < sizeof(magic) || std::memcmp(r.p, magic, sizeof(magic)) != 0)
+    {
+      return false;
+    }
+
+  r.p += sizeof(magic);
+
+  uint32_t n;
+
+  if (!r.string(path) || !r.string(fingerprint) || !r.string(hash) ||
+      !r.string(nspace) || !r.number(n) || static_cast<std::size_t>(r.end - r.p) / sizeof(n) < n)
+    {
+      return false;
+    }
+
+  imports.resize(n);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (!r.string(imports[i]))
+	{
+	  return false;
+	}
+    }
+
+  if (!r.number(n))
+    {
+      return false;
+    }
+
+  names.resize(n);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (!r.string(names[i]))
+	{
+	  return false;
+	}
+    }
+
+  // check the IDs once, so reading them needs no checks
+  for (unsigned s = 0; s < SECTIONS; ++s)
+    {
+      sections[s] = r.p;
+
+      if (!r.skipArray(n))
+	{
+	  return false;
+	}
+    }
+
+  return r.p == r.end;
+}
+
+
+void
+OntologySnapshot::read(Section s, TBox::Objects& objs) const
+{
+  Reader r = { sections[s], static_cast<const char*>(base) + length };
+  uint32_t n;
+  r.number(n);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t id;
+      r.number(id);
+
+      // the IDs come in the order of the written set, so each insert
+      // at the end takes amortized constant time
+      objs.insert(objs.end(), ComfortTerm::createConstant(std::string(names[id].first, names[id].second)));
+    }
+}
+
+
+std::string
+OntologySnapshot::getPath() const
+{
+  return std::string(path.first, path.second);
+}
+
+
+std::string
+OntologySnapshot::getFingerprint() const
+{
+  return std::string(fingerprint.first, fingerprint.second);
+}
+
+
+std::string
+OntologySnapshot::getContentHash() const
+{
+  return std::string(hash.first, hash.second);
+}
+
+
+std::string
+OntologySnapshot::getNamespace() const
+{
+  return std::string(nspace.first, nspace.second);
+}
+
+
+void
+OntologySnapshot::getImports(std::vector<std::string>& uris) const
+{
+  for (std::vector<String>::const_iterator it = imports.begin(); it != imports.end(); ++it)
+    {
+      uris.push_back(std::string(it->first, it->second));
+    }
+}
+
+
+void
+OntologySnapshot::getTBox(TBox& tbox) const
+{
+  read(CONCEPTS, *tbox.getConcepts());
+  read(ROLES, *tbox.getRoles());
+  read(DATATYPEROLES, *tbox.getDatatypeRoles());
+}
+
+
+void
+OntologySnapshot::getABox(ABox& abox) const
+{
+  read(INDIVIDUALS, *abox.getIndividuals());
+}
+
+
+void
+OntologySnapshot::write(const std::string& file, const Ontology& o,
+			const TBox& tbox, const ABox& abox,
+			const std::vector<std::string>& imports) throw (DLError)
+{
+  NameMap ids;
+  std::vector<const std::string*> names;
+
+  intern(*tbox.getConcepts(), ids, names);
+  intern(*tbox.getRoles(), ids, names);
+  intern(*tbox.getDatatypeRoles(), ids, names);
+  intern(*abox.getIndividuals(), ids, names);
+
+  // write to a temporary file of our own, so a concurrent run never
+  // maps a half-written snapshot or writes into ours
+  std::vector<char> name(file.begin(), file.end());
+  const char suffix[] = ".XXXXXX";
+  name.insert(name.end(), suffix, suffix + sizeof(suffix));
+
+  int fd = ::mkstemp(&name[0]);
+
+  if (fd == -1)
+    {
+      throw DLError("Could not write ontology snapshot " + file + '.');
+    }
+
+  ::close(fd);
+
+  std::string tmp(&name[0]);
+  std::ofstream out(tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+  out.write(magic, sizeof(magic));
+  putString(out, o.getURI().getPath());
+  putString(out, o.getFingerprint());
+  putString(out, o.getContentHash());
+  putString(out, o.getNamespace());
+
+  putNumber(out, imports.size());
+
+  for (std::vector<std::string>::const_iterator it = imports.begin(); it != imports.end(); ++it)
+    {
+      putString(out, *it);
+    }
+
+  putNumber(out, names.size());
+
+  for (std::vector<const std::string*>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+      putString(out, **it);
+    }
+
+  putArray(out, *tbox.getConcepts(), ids);
+  putArray(out, *tbox.getRoles(), ids);
+  putArray(out, *tbox.getDatatypeRoles(), ids);
+  putArray(out, *abox.getIndividuals(), ids);
+
+  out.close();
+
+  if (!out || std::rename(tmp.c_str(), file.c_str()) != 0)
+    {
+      std::remove(tmp.c_str());
+      throw DLError("Could not write ontology snapshot " + file + '.');
+    }
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -0,0 +1,165 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   PreloadConverter.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 23:41:07 2026
+ *
+ * @brief  Finds the ontologies of the dl-atoms in a program.
+ *
+ *
+ */
+
+
+#include "PreloadConverter.h"
+#include "RacerInterface.h"
+
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <cctype>   // isalnum(), isspace()
+
+using namespace dlvhex::dl::racer;
+
+
+namespace {
+
+  /// @return the position after the string starting at @a p
+  std::string::size_type
+  skipString(const std::string& s, std::string::size_type p)
+  {
+    for (++p; p < s.size() && s[p] != '"'; ++p)
+      {
+	if (s[p] == '\\') // skip the escaped character
+	  {
+	    ++p;
+	  }
+      }
+
+    return p + 1;
+  }
+
+  /// @return the first position at or after @a p which is no blank
+  std::string::size_type
+  skipBlanks(const std::string& s, std::string::size_type p)
+  {
+    while (p < s.size() && std::isspace(static_cast<unsigned char>(s[p])))
+      {
+	++p;
+      }
+
+    return p;
+  }
+
+} // anonymous namespace
+
+
+
+PreloadConverter::PreloadConverter(RacerInterface& ri)
+  : plugin(ri)
+{ }
+
+
+PreloadConverter::~PreloadConverter()
+{ }
+
+
+void
+PreloadConverter::convert(std::istream& i, std::ostream& o)
+{
+  std::string program((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>());
+
+  o << program;
+
+  std::vector<std::string> uris;
+  scan(program, uris);
+
+  plugin.preload(uris);
+}
+
+
+void
+PreloadConverter::scan(const std::string& program, std::vector<std::string>& uris)
+{
+  std::string::size_type p = 0;
+
+  while (p < program.size())
+    {
+      switch (program[p])
+	{
+	case '%': // a comment runs to the end of the line
+	  p = program.find('\n', p);
+	  break;
+
+	case '"':
+	  p = skipString(program, p);
+	  break;
+
+	case '&':
+	  if (program.compare(p + 1, 2, "dl") == 0)
+	    {
+	      // &dlC, &dlR, &dlDR, &dlConsistent, &dlCQn, &dlUCQn
+	      std::string::size_type q = p + 3;
+
+	      while (q < program.size() && std::isalnum(static_cast<unsigned char>(program[q])))
+		{
+		  ++q;
+		}
+
+	      q = skipBlanks(program, q);
+
+	      if (q < program.size() && program[q] == '[')
+		{
+		  q = skipBlanks(program, q + 1);
+
+		  if (q < program.size() && program[q] == '"')
+		    {
+		      std::string::size_type e = skipString(program, q);
+		      std::string uri = program.substr(q + 1, e - q - 2);
+
+		      if (!uri.empty() && std::find(uris.begin(), uris.end(), uri) == uris.end())
+			{
+			  uris.push_back(uri);
+			}
+		    }
+		}
+
+	      p = q;
+	    }
+	  else
+	    {
+	      ++p;
+	    }
+	  break;
+
+	default:
+	  ++p;
+	  break;
+	}
+    }
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
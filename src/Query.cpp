@@ -51,12 +51,33 @@ Query::Query(KBManager& kb,
 	     const ComfortInterpretation& i)
   : kbManager(kb),
     proj(),
-    query(q)
+    keys(),
+    lambda(),
+    query(q),
+    candidates(),
+    bounded(false)
 {
+  lambda.push_back(pc);
+  lambda.push_back(mc);
+  lambda.push_back(pr);
+  lambda.push_back(mr);
+
   setInterpretation(i, pc, mc, pr, mr);
 }
 
 
+Query::Query(const DLQuery::shared_pointer& q,
+	     const Query& sibling)
+  : kbManager(sibling.kbManager),
+    proj(sibling.proj),
+    keys(sibling.keys),
+    lambda(sibling.lambda),
+    query(q),
+    candidates(),
+    bounded(false)
+{ }
+
+
 KBManager&
 Query::getKBManager() const
 {
@@ -75,6 +96,44 @@ Query::getProjectedInterpretation() const
   return this->proj;
 }
 
+const std::vector<SymbolTable::AtomKey>&
+Query::getProjectedKeys() const
+{
+  return this->keys;
+}
+
+const ComfortTuple&
+Query::getInputPredicates() const
+{
+  return this->lambda;
+}
+
+void
+Query::setCandidates(const std::set<ComfortTuple>& c)
+{
+  this->candidates = c;
+  this->bounded = true;
+}
+
+void
+Query::clearCandidates()
+{
+  this->candidates.clear();
+  this->bounded = false;
+}
+
+bool
+Query::hasCandidates() const
+{
+  return this->bounded;
+}
+
+const std::set<ComfortTuple>&
+Query::getCandidates() const
+{
+  return this->candidates;
+}
+
 
 void
 Query::setInterpretation(const ComfortInterpretation& ints,
@@ -105,6 +164,9 @@ Query::setInterpretation(const ComfortInterpretation& ints,
 		proj.insert(ca);
 	}
     }
+
+  // the cache compares the projected atoms by their term IDs
+  SymbolTable::intern(proj, keys);
 }
 
 } // namespace dl
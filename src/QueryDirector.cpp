@@ -37,11 +37,19 @@
 #include "Query.h"
 #include "Answer.h"
 #include "Cache.h"
+#include "KBManager.h"
+#include "Registry.h"
+#include "TCPStream.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 
+#include <algorithm>
 #include <iterator>
+#include <set>
+#include <vector>
+
+#include <ctime>        // clock_gettime()
 
 using namespace dlvhex::dl;
 
@@ -66,16 +74,41 @@ QueryCompositeDirector::add(QueryBaseDirector* d)
 QueryCtx::shared_pointer
 QueryCompositeDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
 {
-  for (boost::ptr_vector<QueryBaseDirector>::iterator it = dirs.begin();
-       it != dirs.end(); ++it)
+  const bool pipelining = Registry::getFlags() & Registry::PIPELINE;
+
+  boost::ptr_vector<QueryBaseDirector>::iterator it = dirs.begin();
+
+  while (it != dirs.end())
     {
-      qctx = it->query(qctx);
+      if (pipelining && it->isPipelined())
+	{
+	  // send the longest run of pipelined directors in one go
+	  boost::ptr_vector<QueryBaseDirector>::iterator end = it;
 
-      ///@todo decouple inconsistency handling from QueryCompositeDirector
+	  while (end != dirs.end() && end->isPipelined())
+	    {
+	      ++end;
+	    }
 
-      if (qctx->getAnswer().getIncoherent())
+	  if (pipeline(qctx, it, end))
+	    {
+	      return handleInconsistency(qctx);
+	    }
+
+	  it = end;
+	}
+      else
 	{
-	  return handleInconsistency(qctx);
+	  qctx = it->query(qctx);
+
+	  ///@todo decouple inconsistency handling from QueryCompositeDirector
+
+	  if (qctx->getAnswer().getIncoherent())
+	    {
+	      return handleInconsistency(qctx);
+	    }
+
+	  ++it;
 	}
     }
 
@@ -83,6 +116,122 @@ QueryCompositeDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
 }
 
 
+namespace {
+
+  /**
+   * @brief Corks the TCPStreamBuf of a stream during its lifetime.
+   */
+  class StreamCork
+  {
+  private:
+    dlvhex::util::TCPStreamBuf* sb;
+
+  public:
+    explicit
+    StreamCork(std::iostream& s)
+      : sb(dynamic_cast<dlvhex::util::TCPStreamBuf*>(s.rdbuf()))
+    {
+      if (sb)
+	{
+	  sb->cork(true);
+	}
+    }
+
+    ~StreamCork()
+    {
+      if (sb)
+	{
+	  sb->cork(false);
+	}
+    }
+  };
+
+
+  /**
+   * Skip the answers of the commands in [@a beg, @a end) s.t. the
+   * next query finds the stream in sync.
+   */
+  void
+  drain(QueryCtx::shared_pointer qctx,
+	std::vector<QueryBaseDirector*>::iterator beg,
+	std::vector<QueryBaseDirector*>::iterator end)
+  {
+    for (; beg != end; ++beg)
+      {
+	try
+	  {
+	    (*beg)->receive(qctx);
+	  }
+	catch (DLError&)
+	  {
+	    // commands after a failing command may fail as well
+	  }
+      }
+  }
+
+} // anonymous namespace
+
+
+bool
+QueryCompositeDirector::pipeline(QueryCtx::shared_pointer qctx,
+				 boost::ptr_vector<QueryBaseDirector>::iterator beg,
+				 boost::ptr_vector<QueryBaseDirector>::iterator end)
+{
+  std::vector<QueryBaseDirector*> pending;
+
+  try
+    {
+      StreamCork cork(stream);
+
+      for (; beg != end; ++beg)
+	{
+	  if (beg->send(qctx))
+	    {
+	      pending.push_back(&*beg);
+	    }
+	}
+    }
+  catch (DLError&)
+    {
+      // the commands built so far are already on their way
+      stream.flush();
+      drain(qctx, pending.begin(), pending.end());
+      throw;
+    }
+
+  // send all commands at once
+  stream.flush();
+
+  for (std::vector<QueryBaseDirector*>::iterator it = pending.begin();
+       it != pending.end(); ++it)
+    {
+      try
+	{
+	  (*it)->receive(qctx);
+	}
+      catch (DLError&)
+	{
+	  drain(qctx, it + 1, pending.end());
+	  throw;
+	}
+
+      if (qctx->getAnswer().getIncoherent())
+	{
+	  // RACER already processed the remaining commands, so we
+	  // have to skip their answers, but keep the incoherent answer
+	  Answer incoherent(qctx->getAnswer());
+	  drain(qctx, it + 1, pending.end());
+	  qctx->getAnswer() = incoherent;
+	  return true;
+	}
+    }
+
+  return false;
+}
+
+
+
+
 namespace dlvhex {
   namespace dl {
 
@@ -167,6 +316,17 @@ namespace dlvhex {
 
 QueryCtx::shared_pointer
 QueryCompositeDirector::handleInconsistency(QueryCtx::shared_pointer qctx)
+{
+  // RACER may have mixed up its KBs after seeing an inconsistent
+  // ABox, so we start over with a full reset in the next query
+  qctx->getQuery().getKBManager().invalidateSession();
+
+  return inconsistentAnswer(qctx);
+}
+
+
+QueryCtx::shared_pointer
+QueryCompositeDirector::inconsistentAnswer(QueryCtx::shared_pointer qctx)
 {
   const DLQuery::shared_pointer& dlq = qctx->getQuery().getDLQuery();
 
@@ -219,6 +379,134 @@ QueryCompositeDirector::handleInconsistency(QueryCtx::shared_pointer qctx)
 
 
 
+namespace {
+
+  using dlvhex::ComfortTuple;
+
+  /// @return the monotonic clock in microseconds
+  unsigned long
+  now()
+  {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+  }
+
+  /// do not restrict queries to more candidates, nRQL would choke on the filter
+  const std::size_t maxCandidates = 64;
+
+  /**
+   * Restricts the retrieval query @a qctx to the tuples between the
+   * bounds of @a cache.
+   *
+   * @param cache
+   * @param qctx
+   * @param lower gets the lower bound of the answer of @a qctx
+   *
+   * @return true if @a qctx is restricted, i.e., its answer misses
+   * @a lower.
+   */
+  bool
+  restrictQuery(const BaseCache& cache, const QueryCtx::shared_pointer& qctx,
+	   std::set<ComfortTuple>& lower)
+  {
+    std::set<ComfortTuple> upper;
+
+    if (!cache.bounds(qctx, lower, upper))
+      {
+	return false;
+      }
+
+    std::set<ComfortTuple> candidates;
+    std::set_difference(upper.begin(), upper.end(), lower.begin(), lower.end(),
+			std::inserter(candidates, candidates.begin()));
+
+    if (candidates.empty() || candidates.size() > maxCandidates)
+      {
+	return false;
+      }
+
+    qctx->getQuery().setCandidates(candidates);
+
+    return true;
+  }
+
+  /**
+   * Answers @a qctx like an inconsistent ABox would if @a cache
+   * knows that the input of @a qctx makes the ABox inconsistent.
+   *
+   * @param cache
+   * @param qctx
+   *
+   * @return true if @a qctx has been answered
+   */
+  bool
+  knownInconsistent(const BaseCache& cache, const QueryCtx::shared_pointer& qctx)
+  {
+    bool consistent;
+
+    if (cache.consistency(qctx, consistent) && !consistent)
+      {
+	qctx->getAnswer().setIncoherent(true);
+	QueryCompositeDirector::inconsistentAnswer(qctx);
+	return true;
+      }
+
+    return false;
+  }
+
+  /**
+   * @param dlq
+   *
+   * @return true if the interpretation of a query with @a dlq is
+   * added to the ABox, and false if it is only a premise of the query
+   */
+  bool
+  extendsABox(const DLQuery& dlq)
+  {
+    // the cq-, ucq- and datatype-atoms always retrieve under premise
+    return !(Registry::getFlags() & Registry::PREMISE)
+      && !dlq.isConjQuery() && !dlq.isUnionConjQuery() && !dlq.isDatatype();
+  }
+
+  /// records the consistency of the ABox which answered @a qctx
+  void
+  learnConsistency(BaseCache& cache, const QueryCtx::shared_pointer& qctx)
+  {
+    const Answer& a = qctx->getAnswer();
+
+    if (a.getIncoherent())
+      {
+	cache.insertConsistency(qctx, false);
+      }
+    else if (a.getErrorMessage().empty() && extendsABox(*qctx->getQuery().getDLQuery()))
+      {
+	// RACER refuses to query an inconsistent ABox, but a premise
+	// is not part of the ABox
+	cache.insertConsistency(qctx, true);
+      }
+  }
+
+  /// adds @a lower to the answer of the restricted query @a qctx
+  void
+  completeQuery(const QueryCtx::shared_pointer& qctx, const std::set<ComfortTuple>& lower)
+  {
+    qctx->getQuery().clearCandidates();
+
+    Answer& a = qctx->getAnswer();
+
+    if (!a.getIncoherent() && a.getErrorMessage().empty())
+      {
+	for (std::set<ComfortTuple>::const_iterator it = lower.begin(); it != lower.end(); ++it)
+	  {
+	    a.insert(*it);
+	  }
+      }
+  }
+
+} // anonymous namespace
+
+
 QueryCachingDirector::QueryCachingDirector(BaseCache& c,
 					   QueryBaseDirector::shared_pointer d)
   : QueryBaseDirector(),
@@ -239,11 +527,23 @@ QueryCachingDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
 	  // delete qctx pointer and overwrite with found pointer
 	  qctx = found;
 	}
-      else
+      else if (!knownInconsistent(cache, qctx))
 	{
+	  // only ask for the tuples which the cache cannot decide
+	  std::set<ComfortTuple> lower;
+	  bool restricted = restrictQuery(cache, qctx, lower);
+
 	  // ask the director and add qctx pointer to the cache
+	  unsigned long start = now();
 	  qctx = director->query(qctx);
-	  cache.insert(qctx);
+
+	  if (restricted)
+	    {
+	      completeQuery(qctx, lower);
+	    }
+
+	  learnConsistency(cache, qctx);
+	  cache.insert(qctx, now() - start);
 	}
     }
 
@@ -251,6 +551,294 @@ QueryCachingDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
 }
 
 
+
+namespace {
+
+  /**
+   * @brief Poses a sibling query on behalf of the director chain of
+   * another query.
+   *
+   * A failing sibling keeps its error message in its answer and
+   * leaves the query alone. Only a failing send() is passed on, as
+   * the stream may hold a partial command.
+   */
+  class SiblingDirector : public QueryBaseDirector
+  {
+  private:
+    QueryCtx::shared_pointer sibling;
+    QueryBaseDirector::shared_pointer director;
+
+  public:
+    SiblingDirector(QueryCtx::shared_pointer s, QueryBaseDirector::shared_pointer d)
+      : QueryBaseDirector(), sibling(s), director(d)
+    { }
+
+    virtual QueryCtx::shared_pointer
+    query(QueryCtx::shared_pointer qctx) throw(DLError)
+    {
+      try
+	{
+	  director->query(sibling);
+	}
+      catch (DLError& e)
+	{
+	  sibling->getAnswer().setErrorMessage(e.what());
+	}
+
+      return qctx;
+    }
+
+    virtual bool
+    isPipelined() const
+    {
+      return director->isPipelined();
+    }
+
+    virtual bool
+    send(QueryCtx::shared_pointer /* qctx */) throw(DLError)
+    {
+      try
+	{
+	  return director->send(sibling);
+	}
+      catch (DLError& e)
+	{
+	  sibling->getAnswer().setErrorMessage(e.what());
+	  throw;
+	}
+    }
+
+    virtual void
+    receive(QueryCtx::shared_pointer /* qctx */) throw(DLError)
+    {
+      try
+	{
+	  director->receive(sibling);
+	}
+      catch (DLError& e)
+	{
+	  sibling->getAnswer().setErrorMessage(e.what());
+	}
+    }
+  };
+
+} // anonymous namespace
+
+
+QueryConsistencyDirector::QueryConsistencyDirector(BaseCache& c,
+						   QueryBaseDirector::shared_pointer d)
+  : QueryBaseDirector(),
+    director(d),
+    cache(c)
+{ }
+
+
+QueryCtx::shared_pointer
+QueryConsistencyDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
+{
+  if (!director)
+    {
+      return qctx;
+    }
+
+  bool consistent;
+
+  if (cache.consistency(qctx, consistent))
+    {
+      Answer& a = qctx->getAnswer();
+      a.setAnswer(consistent);
+
+      if (consistent)
+	{
+	  a.insert(ComfortTuple());
+	}
+
+      return qctx;
+    }
+
+  qctx = director->query(qctx);
+
+  const Answer& a = qctx->getAnswer();
+
+  // an incoherent ABox is inconsistent, whatever the boolean answer says
+  if (a.getIncoherent() || a.getErrorMessage().empty())
+    {
+      cache.insertConsistency(qctx, a.getAnswer() && !a.getIncoherent());
+    }
+
+  return qctx;
+}
+
+
+QueryPromotingDirector::QueryPromotingDirector(BaseCache& c,
+					       QueryBaseDirector::shared_pointer d,
+					       QueryBaseDirector::shared_pointer r)
+  : QueryBaseDirector(),
+    director(d),
+    retrieval(r),
+    cache(c)
+{ }
+
+
+QueryCtx::shared_pointer
+QueryPromotingDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
+{
+  if (!director)
+    {
+      return qctx;
+    }
+
+  if (retrieval && !cache.contains(qctx))
+    {
+      DLQuery::shared_pointer rf = cache.promote(qctx);
+
+      if (rf)
+	{
+	  // the retrieval shares the input of qctx
+	  Query* q = new Query(rf, qctx->getQuery());
+	  QueryCtx::shared_pointer rctx(new QueryCtx(q, new Answer(q)));
+
+	  retrieval->query(rctx);
+	}
+    }
+
+  // a cache hit now, unless the retrieval answer was not cached, or
+  // the consistency cache answers qctx if the ABox was inconsistent
+  return director->query(qctx);
+}
+
+
+QueryCoalescingDirector::QueryCoalescingDirector(BaseCache& c,
+						 QueryCompositeDirector::shared_pointer d,
+						 DLQuerySet& k,
+						 boost::mutex& m)
+  : QueryBaseDirector(),
+    director(d),
+    cache(c),
+    siblings(),
+    known(k),
+    knownMutex(m)
+{ }
+
+
+void
+QueryCoalescingDirector::remember(const QueryCtx::shared_pointer& qctx, bool answered)
+{
+  const DLQuery::shared_pointer& dlq = qctx->getQuery().getDLQuery();
+
+  boost::mutex::scoped_lock lock(knownMutex);
+
+  if (answered)
+    {
+      known.insert(dlq);
+    }
+  else
+    {
+      known.erase(dlq);
+    }
+}
+
+
+void
+QueryCoalescingDirector::add(QueryCtx::shared_pointer qctx,
+			     QueryBaseDirector::shared_pointer d)
+{
+  siblings.push_back(Sibling(qctx, d));
+}
+
+
+QueryCtx::shared_pointer
+QueryCoalescingDirector::query(QueryCtx::shared_pointer qctx) throw(DLError)
+{
+  if (!director)
+    {
+      return qctx;
+    }
+
+  QueryCtx::shared_pointer found = cache.cacheHit(qctx);
+
+  if (found)
+    {
+      return found;
+    }
+
+  if (knownInconsistent(cache, qctx))
+    {
+      return qctx;
+    }
+
+  std::vector<QueryCtx::shared_pointer> pending;
+
+  for (std::vector<Sibling>::const_iterator it = siblings.begin();
+       it != siblings.end(); ++it)
+    {
+      if (!cache.contains(it->first))
+	{
+	  director->add(new SiblingDirector(it->first, it->second));
+	  pending.push_back(it->first);
+	}
+    }
+
+  std::set<ComfortTuple> lower;
+  bool restricted = restrictQuery(cache, qctx, lower);
+
+  unsigned long start = now();
+
+  try
+    {
+      qctx = director->query(qctx);
+    }
+  catch (DLError&)
+    {
+      // neither the query nor its failed siblings are candidates anymore
+      remember(qctx, false);
+
+      for (std::vector<QueryCtx::shared_pointer>::const_iterator it = pending.begin();
+	   it != pending.end(); ++it)
+	{
+	  if (!(*it)->getAnswer().getErrorMessage().empty())
+	    {
+	      remember(*it, false);
+	    }
+	}
+
+      throw;
+    }
+
+  remember(qctx, true);
+
+  if (restricted)
+    {
+      completeQuery(qctx, lower);
+    }
+
+  // the siblings share the cost of the round trip
+  unsigned long cost = (now() - start) / (pending.size() + 1);
+
+  learnConsistency(cache, qctx);
+
+  cache.insert(qctx, cost);
+
+  // an incoherent answer skips the commands of the siblings
+  if (!qctx->getAnswer().getIncoherent())
+    {
+      for (std::vector<QueryCtx::shared_pointer>::const_iterator it = pending.begin();
+	   it != pending.end(); ++it)
+	{
+	  if (!(*it)->getAnswer().getErrorMessage().empty())
+	    {
+	      remember(*it, false);
+	    }
+	  else if (!(*it)->getAnswer().getIncoherent())
+	    {
+	      cache.insert(*it, cost);
+	    }
+	}
+    }
+
+  return qctx;
+}
+
 // Local Variables:
 // mode: C++
 // End:
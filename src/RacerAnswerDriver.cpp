@@ -48,6 +48,7 @@
 #include "Answer.h"
 #include "DLError.h"
 #include "Registry.h"
+#include "TCPStream.h"
 
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/phoenix_core.hpp>
@@ -55,9 +56,11 @@
 #include <boost/spirit/include/phoenix_object.hpp>
 #include <boost/spirit/include/phoenix_fusion.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <iostream>
 #include <sstream>
+#include <iterator>
 
 using namespace dlvhex::dl::racer;
 
@@ -116,12 +119,13 @@ struct handle_dbg
 };
 #endif
 
+/// the grammar outlives a single parse, so the answer gets rebound
 struct AnswerState
 {
-  AnswerState(dlvhex::dl::Answer& answer):
-    answer(answer) {}
+  AnswerState():
+    answer(0) {}
 
-  dlvhex::dl::Answer& answer;
+  dlvhex::dl::Answer* answer;
 };
 
 struct handle_error
@@ -130,7 +134,7 @@ struct handle_error
 
   void operator()(fusion::vector2<std::vector<char>, std::vector<char> >& messages, qi::unused_type, qi::unused_type) const
   {
-    dlvhex::dl::Answer& answer = state.answer;
+    dlvhex::dl::Answer& answer = *state.answer;
 
     std::string error(fusion::at_c<0>(messages).begin(), fusion::at_c<0>(messages).end());
     std::string warning(fusion::at_c<1>(messages).begin(), fusion::at_c<1>(messages).end());
@@ -165,7 +169,7 @@ struct handle_answer
 
   void operator()(std::vector<char>& warning, qi::unused_type, qi::unused_type) const
   {
-    dlvhex::dl::Answer& answer = state.answer;
+    dlvhex::dl::Answer& answer = *state.answer;
 
     std::string wrn(warning.begin(), warning.end());
     answer.setWarningMessage(wrn);
@@ -181,7 +185,7 @@ struct handle_individuals
 
   void operator()(std::vector<dlvhex::ComfortTerm>& terms, qi::unused_type, qi::unused_type) const
   {
-    dlvhex::dl::Answer& answer = state.answer;
+    dlvhex::dl::Answer& answer = *state.answer;
 
     //std::cerr << "creating individuals" << std::endl;
     BOOST_FOREACH(dlvhex::ComfortTerm& t, terms)
@@ -200,7 +204,7 @@ struct handle_tuples
 
   void operator()(std::vector<dlvhex::ComfortTuple>& tuples, qi::unused_type, qi::unused_type) const
   {
-    dlvhex::dl::Answer& answer = state.answer;
+    dlvhex::dl::Answer& answer = *state.answer;
 
     BOOST_FOREACH(dlvhex::ComfortTuple& t, tuples)
     {
@@ -218,7 +222,7 @@ struct handle_boolean
 
   void operator()(qi::unused_type, qi::unused_type, qi::unused_type) const
   {
-    dlvhex::dl::Answer& answer = state.answer;
+    dlvhex::dl::Answer& answer = *state.answer;
 
     //std::cerr << "created boolean " << val << std::endl;
     answer.setAnswer(val);
@@ -237,7 +241,12 @@ struct handle_uri
   {
     dlvhex::ComfortTerm& ruleAttr = fusion::at_c<0>(ctx.attributes);
 
-    ruleAttr = dlvhex::ComfortTerm::createConstant("\"<" + s + ">\"");
+    // one allocation instead of a temporary per concatenation
+    std::string c;
+    c.reserve(s.size() + 4);
+    c.append("\"<").append(s).append(">\"");
+
+    ruleAttr = dlvhex::ComfortTerm::createConstant(c);
     //std::cerr << "created uri '<" << s << ">'" << std::endl;
   }
 };
@@ -245,8 +254,8 @@ struct handle_uri
 template<typename Iterator>
 struct RacerAnswerGrammar: qi::grammar<Iterator, ascii::space_type>
 {
-  RacerAnswerGrammar(AnswerState& state):
-    RacerAnswerGrammar::base_type(answer), state(state)
+  RacerAnswerGrammar():
+    RacerAnswerGrammar::base_type(answer), state()
   {
     using ascii::no_case;
     using spirit::int_;
@@ -335,6 +344,46 @@ struct RacerAnswerGrammar: qi::grammar<Iterator, ascii::space_type>
   AnswerState state;
 };
 
+
+/// we parse the answers in place
+typedef RacerAnswerGrammar<const char*> InPlaceGrammar;
+
+/// constructing the grammar is expensive, so each thread builds it once
+boost::thread_specific_ptr<InPlaceGrammar> grammars;
+
+
+/**
+ * Parses the RACER answer [b,e) into @a a with the grammar of the
+ * current thread.
+ */
+void
+parseAnswer(const char* b, const char* e, dlvhex::dl::Answer& a)
+{
+  #ifdef BOOST_SPIRIT_DEBUG
+  std::cerr <<
+    "$$$Parsing Racer Input$$$" << std::endl <<
+    std::string(b, e) << std::endl <<
+    "$$$" << std::endl;
+  #endif
+
+  if (grammars.get() == 0)
+    {
+      grammars.reset(new InPlaceGrammar);
+    }
+
+  InPlaceGrammar& grammar = *grammars;
+
+  grammar.state.answer = &a;
+  bool r = qi::phrase_parse(b, e, grammar, ascii::space);
+  grammar.state.answer = 0;
+
+  //std::cerr << "parsing ended with " << !r << " and " << (b != e) << std::endl;
+  if (!r || b != e)
+    {
+      throw dlvhex::dl::DLParsingError("failed parsing!");
+    }
+}
+
 }
 
 RacerBaseAnswerDriver::RacerBaseAnswerDriver(std::istream& i)
@@ -381,37 +430,62 @@ RacerAnswerDriver::parse(Answer &a) throw (DLParsingError)
 {
   try
   {
-    #warning TODO use stream iterator and create better error messages!
-    std::ostringstream buf;
-    buf << stream.rdbuf();
-    std::string input = buf.str();
-
-    #ifdef BOOST_SPIRIT_DEBUG
-    std::cerr <<
-      "$$$Parsing Racer Input$$$" << std::endl <<
-      input << std::endl <<
-      "$$$" << std::endl;
-    #endif
-
-    AnswerState state(a);
-    RacerAnswerGrammar<std::string::const_iterator> grammar(state);
-
-    std::string::const_iterator iter = input.begin();
-    std::string::const_iterator end = input.end();
-    bool r = qi::phrase_parse(iter, end, grammar, ascii::space);
-
-    //std::cerr << "parsing ended with " << !r << " and " << (iter != end) << std::endl;
-    if (!r || iter != end)
-    {
-      throw DLParsingError("failed parsing!");
-    }
+    #warning TODO create better error messages!
+    dlvhex::util::TCPStreamBuf* sb =
+      dynamic_cast<dlvhex::util::TCPStreamBuf*>(stream.rdbuf());
+
+    if (sb != 0)
+      {
+	// parse the answer right out of the receive buffer; the range
+	// stays valid until the next read, so we can move the stream
+	// to the next answer before parsing, which keeps it in sync
+	// even if the answer is malformed
+	const char* b;
+	const char* e;
+	sb->answer(b, e);
+	sb->nextAnswer();
+	parseAnswer(b, e, a);
+      }
+    else
+      {
+	// other streams (e.g. std::stringstream in the testsuite) get
+	// copied; read with a stream iterator, so transport errors are
+	// not swallowed by operator<<(std::streambuf*)
+	std::string input((std::istreambuf_iterator<char>(stream)),
+			  std::istreambuf_iterator<char>());
+	parseAnswer(input.data(), input.data() + input.size(), a);
+      }
   }
   catch (std::ios_base::failure& f)
   {
     throw DLParsingError(f.what());
   }
+  catch (DLTimeoutError& e)
+  {
+    throw DLParsingError(e.what());
+  }
+}
+
+
+RacerConsistencyAnswerDriver::RacerConsistencyAnswerDriver(std::istream& i)
+  : RacerAnswerDriver(i)
+{ }
+
+
+void
+RacerConsistencyAnswerDriver::parse(Answer &a) throw (DLParsingError)
+{
+  RacerAnswerDriver::parse(a);
+
+  if (a.getIncoherent())
+    {
+      a.setIncoherent(false);
+      a.setErrorMessage("");
+      a.setAnswer(false);
+    }
 }
 
+
 RacerIgnoreAnswer::RacerIgnoreAnswer(std::istream& s)
   : RacerBaseAnswerDriver(s)
 { }
@@ -445,7 +519,10 @@ RacerIgnoreAnswer::parse(Answer&) throw (DLParsingError)
     {
       throw DLParsingError(f.what());
     }
-
+  catch (DLTimeoutError& e)
+    {
+      throw DLParsingError(e.what());
+    }
 }
 
 
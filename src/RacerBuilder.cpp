@@ -35,6 +35,8 @@
 #include "RacerNRQL.h"
 #include "RacerNRQLBuilder.h"
 #include "Query.h"
+#include "KBManager.h"
+#include "Registry.h"
 
 #include <dlvhex2/ComfortPluginInterface.h>
 
@@ -45,6 +47,19 @@
 
 using namespace dlvhex::dl::racer;
 
+namespace {
+
+  /// @return the name of the KB for the ontology of @a query as
+  /// reported by (all-tboxes)
+  inline std::string
+  openKBName(const dlvhex::dl::Query& query)
+  {
+    return "<" + query.getDLQuery()->getOntology()->getRealURI().getString() + ">";
+  }
+
+} // anonymous namespace
+
+
 
 RacerStateBuilder::RacerStateBuilder(std::ostream& s)
   : QueryBaseBuilder(s)
@@ -61,13 +76,33 @@ RacerStateBuilder::buildCommand(Query& query) throw (DLBuildingError)
   // inconsistent ABox.
   //
 
+  KBManager& kb = query.getKBManager();
+  const std::string source = openKBName(query);
+  const ComfortInterpretation& ints = query.getProjectedInterpretation();
+  const bool cloned = kb.hasWorkingABox(source);
+
+  // the working ABox is already extended by the interpretation
+  if (cloned && kb.getWorkingABox() == ints)
+    {
+      return false;
+    }
+
   try
     {
       std::ostringstream oss;
 
-      if (!NRQLStateBuilder().createPremise(oss, query))
+      if (ints.empty())
+	{
+	  // RacerCloneABoxBuilder has just cloned the ABox, and we
+	  // add the workaround assertion for the abox-cloning bug
+	  NRQLStateBuilder().createPremise(oss, query);
+	}
+      else
 	{
-	  return false; // nothing to sent, ignore this command
+	  // the working ABox is either a fresh clone or holds the
+	  // interpretation of a previous query -> send the delta
+	  NRQLStateBuilder().createDelta(oss, query,
+					 cloned ? kb.getWorkingABox() : ComfortInterpretation());
 	}
 
       stream << "(state " << oss.str() << ')' << std::endl;
@@ -77,6 +112,57 @@ RacerStateBuilder::buildCommand(Query& query) throw (DLBuildingError)
       throw DLBuildingError(e.what());
     }
 
+  kb.setWorkingABox(source, ints);
+
+  return true;
+}
+
+
+RacerCloneABoxBuilder::RacerCloneABoxBuilder(std::ostream& s)
+  : QueryBaseBuilder(s)
+{ }
+
+bool
+RacerCloneABoxBuilder::buildCommand(Query& query) throw (DLBuildingError)
+{
+  KBManager& kb = query.getKBManager();
+  const std::string source = openKBName(query);
+  const ComfortInterpretation& ints = query.getProjectedInterpretation();
+
+  // a pooled working ABox holds exactly what we need
+  if (kb.selectWorkingABox(source, ints))
+    {
+      return false;
+    }
+
+  // an empty working ABox may hold the workaround assertion of
+  // RacerStateBuilder, so only extended clones are updated
+  if ((Registry::getFlags() & Registry::ABOXDELTA) &&
+      !ints.empty() && kb.hasWorkingABox(source) && !kb.getWorkingABox().empty())
+    {
+      const ComfortInterpretation& current = kb.getWorkingABox();
+
+      // keep the working ABox unless the delta is larger than the
+      // interpretation we would send after a fresh clone
+      if (current.difference(ints).size() + ints.difference(current).size() <= ints.size())
+	{
+	  return false;
+	}
+    }
+
+  try
+    {
+      stream << RacerCloneABoxCmd()(query) << std::endl;
+    }
+  catch (std::exception& e)
+    {
+      throw DLBuildingError(e.what());
+    }
+
+  // the clone holds none of our assertions, RacerStateBuilder
+  // makes it usable
+  kb.setWorkingABox("", ComfortInterpretation());
+
   return true;
 }
 
@@ -195,6 +281,12 @@ RacerIndividualFillersBuilder::buildCommand(Query& query)
       throw DLBuildingError("Incompatible pattern supplied.");
     }
 
+  if (query.hasCandidates()) // only check the candidates
+    {
+      stream << NRQLRetrieve<NRQLConceptRoleBuilder>(query) << std::endl;
+      return true;
+    }
+
   try
     {
       std::auto_ptr<ABoxQueryIndividual> i;
@@ -247,6 +339,12 @@ RacerConceptInstancesBuilder::buildCommand(Query& query) throw (DLBuildingError)
   const std::string concept = q.getUnquotedString();
   const std::string& nspace = dlq->getOntology()->getNamespace();
 
+  if (query.hasCandidates()) // only check the candidates
+    {
+      stream << NRQLRetrieve<NRQLConceptRoleBuilder>(query) << std::endl;
+      return true;
+    }
+
   try
     {
       std::auto_ptr<ABoxConceptDescrExpr> c;
@@ -289,6 +387,12 @@ RacerRoleIndividualsBuilder::buildCommand(Query& query) throw (DLBuildingError)
   const ComfortTerm& q = dlq->getQuery();
   const std::string& nspace = dlq->getOntology()->getNamespace();
 
+  if (query.hasCandidates()) // only check the candidates
+    {
+      stream << NRQLRetrieve<NRQLConceptRoleBuilder>(query) << std::endl;
+      return true;
+    }
+
   try
     {
       ///@todo no negated role?
@@ -316,8 +420,15 @@ RacerOpenOWLBuilder::RacerOpenOWLBuilder(std::ostream& s)
 bool
 RacerOpenOWLBuilder::buildCommand(Query& query) throw (DLBuildingError)
 {
-  const URI& realuri = query.getDLQuery()->getOntology()->getRealURI();
-  const URI& uri = query.getDLQuery()->getOntology()->getURI();
+  const Ontology::shared_pointer& onto = query.getDLQuery()->getOntology();
+  const URI& realuri = onto->getRealURI();
+  const URI& uri = onto->getURI();
+
+  // RACER already holds the current version of the document
+  if (query.getKBManager().isOpenKB(openKBName(query), onto->getFingerprint()))
+    {
+      return false;
+    }
 
   // we read the owl document uri into kb-name uri
 
@@ -351,6 +462,128 @@ RacerOpenOWLBuilder::buildCommand(Query& query) throw (DLBuildingError)
 }
 
 
+RacerImportOntologiesBuilder::RacerImportOntologiesBuilder(std::ostream& s)
+  : QueryBaseBuilder(s)
+{ }
+
+bool
+RacerImportOntologiesBuilder::buildCommand(Query& query) throw (DLBuildingError)
+{
+  const Ontology::shared_pointer& onto = query.getDLQuery()->getOntology();
+  KBManager& kb = query.getKBManager();
+  const std::string kbname = openKBName(query);
+  const std::string fingerprint = onto->getFingerprint();
+
+  if (kb.isOpenKB(kbname, fingerprint))
+    {
+      return false;
+    }
+
+  try
+    {
+      stream << RacerImportOntologiesCmd()(query) << std::endl;
+    }
+  catch (std::exception& e)
+    {
+      throw DLBuildingError(e.what());
+    }
+
+  // RACER has now loaded the document and all its imports
+  kb.addOpenKB(kbname, fingerprint);
+
+  return true;
+}
+
+
+RacerFullResetBuilder::RacerFullResetBuilder(std::ostream& s)
+  : QueryBaseBuilder(s)
+{ }
+
+bool
+RacerFullResetBuilder::buildCommand(Query& query) throw (DLBuildingError)
+{
+  KBManager& kb = query.getKBManager();
+
+  if (kb.isSession(KBManager::SESSION))
+    {
+      return false;
+    }
+
+  try
+    {
+      stream << RacerFullResetCmd()() << std::endl;
+    }
+  catch (std::exception& e)
+    {
+      throw DLBuildingError(e.what());
+    }
+
+  // RACER forgets about all KBs and settings
+  kb.invalidateSession();
+  kb.addSession(KBManager::SESSION);
+
+  return true;
+}
+
+
+RacerUNABuilder::RacerUNABuilder(std::ostream& s)
+  : QueryBaseBuilder(s)
+{ }
+
+bool
+RacerUNABuilder::buildCommand(Query& query) throw (DLBuildingError)
+{
+  KBManager& kb = query.getKBManager();
+
+  if (!(Registry::getFlags() & Registry::UNA) || kb.isSession(KBManager::UNA))
+    {
+      return false;
+    }
+
+  try
+    {
+      stream << RacerUNACmd()() << std::endl;
+    }
+  catch (std::exception& e)
+    {
+      throw DLBuildingError(e.what());
+    }
+
+  kb.addSession(KBManager::UNA);
+
+  return true;
+}
+
+
+RacerDataSubstrateMirroringBuilder::RacerDataSubstrateMirroringBuilder(std::ostream& s)
+  : QueryBaseBuilder(s)
+{ }
+
+bool
+RacerDataSubstrateMirroringBuilder::buildCommand(Query& query) throw (DLBuildingError)
+{
+  KBManager& kb = query.getKBManager();
+
+  if (kb.isSession(KBManager::DATASUBSTRATE))
+    {
+      return false;
+    }
+
+  try
+    {
+      stream << RacerDataSubstrateMirroringCmd()() << std::endl;
+    }
+  catch (std::exception& e)
+    {
+      throw DLBuildingError(e.what());
+    }
+
+  kb.addSession(KBManager::DATASUBSTRATE);
+
+  return true;
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
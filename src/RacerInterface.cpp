@@ -46,17 +46,22 @@
 #include "Registry.h"
 #include "TCPStream.h"
 #include "Cache.h"
+#include "CacheStore.h"
 #include "DLError.h"
 #include "RacerBuilder.h"
 #include "RacerAnswerDriver.h"
 #include "Answer.h"
 #include "RacerKBManager.h"
+#include "RacerPool.h"
+#include "OntologyLoader.h"
+#include "PreloadConverter.h"
 
 #include <iosfwd>
 #include <algorithm>
 #include <iterator>
 
 #include <boost/tokenizer.hpp>
+#include <boost/bind.hpp>
 
 namespace dlvhex {
   namespace dl {
@@ -64,29 +69,38 @@ namespace dlvhex {
 
 
 RacerInterface::RacerInterface()
-  : stream(new dlvhex::util::TCPIOStream("localhost", 8088)),
+  : pool(new RacerPool),
     stats(new CacheStats),
     cache(new Cache(*stats)),
+    cacheBudget(0),
+    cacheAdmission(true),
+    store(0),
 // @TODO
     dlconverter(0),
     dfconverter(0),
     dfoutputbuilder(new dlvhex::df::DFOutputBuilder),
 // @TODO
 //    dloptimizer(new DLOptimizer),
-    kbManager(new RacerKBManager(*stream))
-{ }
+    preloading(0)
+{
+  // default RACER server
+  pool->addBackend("localhost", 8088);
+}
 
 
 RacerInterface::RacerInterface(const RacerInterface&)
   : PluginInterface(),
-    stream(0),
+    pool(0),
     stats(0),
     cache(0),
+    cacheBudget(0),
+    cacheAdmission(true),
+    store(0),
     dlconverter(0),
     dfconverter(0),
     dfoutputbuilder(0),
     dloptimizer(0),
-   kbManager(0)
+    preloading(0)
 { /* ignore */ }
 
 
@@ -105,16 +119,6 @@ RacerInterface::~RacerInterface()
 	{
 	  std::cerr << *stats;
 	}
-
-      if (stream->isOpen())
-	{
-	  kbManager->removeKB(); // remove temporary abox
-	}
-    }
-  catch (std::exception& e)
-    {
-      // we ignore this error since dtors must not throw exceptions
-      std::cerr << "Couldn't remove temporary KB: " << e.what() << std::endl;
     }
   catch (...)
     {
@@ -122,15 +126,21 @@ RacerInterface::~RacerInterface()
       std::cerr << "~RacerInterface: Caught unknown exception." << std::endl;
     }
 
-  delete kbManager;
+  if (preloading) // the loader still uses the pool
+    {
+      preloading->join();
+      delete preloading;
+    }
+
+  delete pool; // removes temporary aboxen
 // @TODO
 //  delete dloptimizer;
   if (dlconverter) delete dlconverter;
   if (dfconverter) delete dfconverter;
   delete dfoutputbuilder;
   delete cache;
+  delete store; // compacts the dl-cache file
   delete stats;
-  delete stream;
 }
 
 
@@ -151,6 +161,9 @@ std::vector<PluginConverterPtr> RacerInterface::createConverters(ProgramCtx& ctx
 
   std::vector<PluginConverterPtr> cvts;
 
+  // sees the program first and starts loading its ontologies
+  cvts.push_back(PluginConverterPtr(new PreloadConverter(*this)));
+
   // always push the dfconverter since default rules
   // and dl-/HEX-rules are now can live in the same input
 //  cvts.push_back(PluginConverterPtr(dfconverter));
@@ -197,14 +210,14 @@ struct GetCacheFun
  * We cannot rely on dlvhex calling RacerInterface::setOptions
  * before RacerInterface::getAtoms so we provide this class as
  * template parameter for the external atoms in order to get the
- * current KBManager.
+ * current RacerPool.
  */
-struct GetKBManagerFun
+struct GetRacerPoolFun
 {
-  dlvhex::dl::KBManager&
+  RacerPool&
   operator() () const
   {
-    return *(RacerInterface::instance()->getKBManager());
+    return *(RacerInterface::instance()->getRacerPool());
   }
 };
 
@@ -212,13 +225,10 @@ std::vector<PluginAtomPtr> RacerInterface::createAtoms(ProgramCtx& ctx) const
 {
 	std::vector<PluginAtomPtr> ret;
 
-	// maybe we should provide the stream and the kbmanager as template
-	// parameters similar to GetCache
-
-	PluginAtomPtr dlC(new RacerConceptAtom<GetKBManagerFun,GetCacheFun>("dlC", *stream));
-	PluginAtomPtr dlR(new RacerRoleAtom<GetKBManagerFun,GetCacheFun>("dlR", *stream));
-	PluginAtomPtr dlConsistent(new RacerConsistentAtom<GetKBManagerFun>("dlConsistent", *stream));
-	PluginAtomPtr dlDR(new RacerDatatypeRoleAtom<GetKBManagerFun,GetCacheFun>("dlDR", *stream));
+	PluginAtomPtr dlC(new RacerConceptAtom<GetRacerPoolFun,GetCacheFun>("dlC"));
+	PluginAtomPtr dlR(new RacerRoleAtom<GetRacerPoolFun,GetCacheFun>("dlR"));
+	PluginAtomPtr dlConsistent(new RacerConsistentAtom<GetRacerPoolFun,GetCacheFun>("dlConsistent"));
+	PluginAtomPtr dlDR(new RacerDatatypeRoleAtom<GetRacerPoolFun,GetCacheFun>("dlDR"));
 
 	ret.push_back(dlC);
 	ret.push_back(dlR);
@@ -234,7 +244,7 @@ std::vector<PluginAtomPtr> RacerInterface::createAtoms(ProgramCtx& ctx) const
 	for (unsigned n = 0; n <= 32; ++n)
 	{
 		oss << "dlCQ" << n;
-		PluginAtomPtr dlCQ(new RacerCQAtom<GetKBManagerFun,GetCacheFun>(oss.str(), *stream, n));
+		PluginAtomPtr dlCQ(new RacerCQAtom<GetRacerPoolFun,GetCacheFun>(oss.str(), n));
 		ret.push_back(dlCQ);
 		oss.str("");
 	}
@@ -245,7 +255,7 @@ std::vector<PluginAtomPtr> RacerInterface::createAtoms(ProgramCtx& ctx) const
 	for (unsigned n = 0; n <= 32; ++n)
 	{
 		oss << "dlUCQ" << n;
-		PluginAtomPtr dlUCQ(new RacerUCQAtom<GetKBManagerFun,GetCacheFun>(oss.str(), *stream, n));
+		PluginAtomPtr dlUCQ(new RacerUCQAtom<GetRacerPoolFun,GetCacheFun>(oss.str(), n));
 		ret.push_back(dlUCQ);
 		oss.str("");
 	}
@@ -261,11 +271,28 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
       out << "DL-plugin: " << std::endl << std::endl;
       out << " --ontology=URI        Use URI as ontology for dl-atoms." << std::endl;
       out << " --kb-reload           Force reloading of previously loaded ontologies." << std::endl;
+      out << " --dlservers=HOST:PORT[,HOST:PORT]*" << std::endl;
+      out << "                       Dispatch dl-atoms to a pool of RACER servers" << std::endl;
+      out << "                       (default: localhost:8088)." << std::endl;
+      out << " --dltimeout=SECONDS   Give up on RACER commands after SECONDS (default: 0, no deadline)." << std::endl;
+      out << " --dlaboxes=N          Keep N temporary ABoxes per RACER server (default: 4)." << std::endl;
+      out << " --dlrecord=FILE       Record the conversation with RACER into FILE." << std::endl;
+      out << " --dlreplay=FILE       Replay a recorded conversation from FILE instead of asking RACER." << std::endl;
+      out << " --dlcachefile=FILE    Keep the answers of dl-atoms in FILE across runs." << std::endl;
+      out << " --dlsnapshots=DIR     Keep binary snapshots of the parsed ontologies in DIR." << std::endl;
       out << " --dlsetup=ARG[,ARG]*  Set DL-reasoner options, where ARG may be" << std::endl;
       out << "                       -una ... turn off unique name assumption (default: on)" << std::endl;
       out << " --dlopt=MOD[,MOD]*    Set optimization modifiers, where MOD may be" << std::endl;
       out << "                       -push    ... turn off pushing" << std::endl;
       out << "                       -dlcache ... turn off dl-cache" << std::endl;
+      out << "                       dlcache=SIZE ... limit the dl-cache to SIZE bytes, SIZE may end in K, M, or G" << std::endl;
+      out << "                       -admit   ... cache every query in a limited dl-cache, not only popular ones" << std::endl;
+      out << "                       -pipeline ... turn off command pipelining" << std::endl;
+      out << "                       -delta   ... clone the ABox for each dl-atom instead of updating it" << std::endl;
+      out << "                       premise  ... evaluate each dl-atom with a single retrieve-under-premise" << std::endl;
+      out << "                       coalesce ... evaluate dl-atoms with the same input in one go" << std::endl;
+      out << "                       -promote ... never answer repeated boolean dl-atoms with a single retrieval" << std::endl;
+      out << "                       -preload ... load each ontology only when the first dl-atom needs it" << std::endl;
       out << " --dldebug=LEVEL       Set debug level to LEVEL." << std::endl << std::endl;
       out << "Default rewriter:" << std::endl << std::endl;
       out << " --dftrans=TRANS       Choose transformation from defaults to dl-rules. TRANS can be" << std::endl;
@@ -281,6 +308,13 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
 
   const char *ontology     = "--ontology=";
   const char *reload       = "--kb-reload";
+  const char *servers      = "--dlservers=";
+  const char *timeout      = "--dltimeout=";
+  const char *aboxes       = "--dlaboxes=";
+  const char *record       = "--dlrecord=";
+  const char *replay       = "--dlreplay=";
+  const char *cachefile    = "--dlcachefile=";
+  const char *snapshots    = "--dlsnapshots=";
   const char *setup        = "--dlsetup=";
   const char *optimization = "--dlopt=";
   const char *dldebug      = "--dldebug=";
@@ -308,8 +342,8 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
 	      throw PluginError(e.what());
 	    }
 
-	  dlconverter->setOntology(this->ontology);
-	  dfconverter->setOntology(this->ontology);
+	  if (dlconverter) dlconverter->setOntology(this->ontology);
+	  if (dfconverter) dfconverter->setOntology(this->ontology);
 
 	  it = argv.erase(it);
 	  continue;
@@ -319,10 +353,132 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
 
       if (o != std::string::npos)
 	{
-	  ///@todo we ignore the fact that we could have multiple
-	  ///occurrences of --kb-reload on the command line
-	  KBManager *tmp = new NullKBManager(kbManager);
-	  kbManager = tmp;
+	  pool->setReload();
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(servers);
+
+      if (o != std::string::npos) // setup the RACER pool
+	{
+	  std::string args = it->substr(o + strlen(servers)); // get list of HOST:PORT
+
+	  pool->clear();
+
+	  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+	  boost::char_separator<char> sep(",");
+	  tokenizer tokens(args, sep);
+	  for (tokenizer::iterator tok_iter = tokens.begin();
+	       tok_iter != tokens.end(); ++tok_iter)
+	    {
+	      std::string::size_type c = tok_iter->rfind(':');
+	      unsigned port = 8088;
+
+	      if (c != std::string::npos)
+		{
+		  std::istringstream iss(tok_iter->substr(c + 1));
+
+		  if (!(iss >> port))
+		    {
+		      throw PluginError("Invalid RACER port in " + *tok_iter);
+		    }
+		}
+
+	      pool->addBackend(tok_iter->substr(0, c), port);
+	    }
+
+	  if (pool->size() == 0)
+	    {
+	      throw PluginError("--dlservers needs at least one RACER server");
+	    }
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(timeout);
+
+      if (o != std::string::npos) // set per-command deadline
+	{
+	  unsigned seconds;
+	  std::istringstream iss(it->substr(o + strlen(timeout))); // get SECONDS
+
+	  if (!(iss >> seconds))
+	    {
+	      throw PluginError("Invalid timeout in " + *it);
+	    }
+
+	  pool->setTimeout(seconds * 1000);
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(aboxes);
+
+      if (o != std::string::npos) // set size of the ABox pool
+	{
+	  unsigned n;
+	  std::istringstream iss(it->substr(o + strlen(aboxes))); // get N
+
+	  if (!(iss >> n) || n == 0)
+	    {
+	      throw PluginError("Invalid number of ABoxes in " + *it);
+	    }
+
+	  pool->setWorkingABoxes(n);
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(record);
+
+      if (o != std::string::npos) // record the RACER sessions
+	{
+	  pool->setSession(it->substr(o + strlen(record)), dlvhex::util::TCPIOStream::RECORD);
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(replay);
+
+      if (o != std::string::npos) // replay the RACER sessions
+	{
+	  pool->setSession(it->substr(o + strlen(replay)), dlvhex::util::TCPIOStream::REPLAY);
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(cachefile);
+
+      if (o != std::string::npos) // persistent dl-cache
+	{
+	  delete store;
+	  store = 0; // CacheStore may throw()
+
+	  try
+	    {
+	      store = new CacheStore(it->substr(o + strlen(cachefile)));
+	    }
+	  catch (DLError& e)
+	    {
+	      throw PluginError(e.what());
+	    }
+
+	  it = argv.erase(it);
+	  continue;
+	}
+
+      o = it->find(snapshots);
+
+      if (o != std::string::npos) // ontology snapshots
+	{
+	  Ontology::setSnapshotDirectory(it->substr(o + strlen(snapshots)));
 
 	  it = argv.erase(it);
 	  continue;
@@ -373,6 +529,72 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
 		  delete cache;
 		  cache = new NullCache(*stats);
 		}
+	      else if (tok_iter->compare(0, 8, "dlcache=") == 0) // memory budget
+		{
+		  std::istringstream iss(tok_iter->substr(8));
+		  unsigned long size;
+		  char unit = 0;
+
+		  if (!(iss >> size))
+		    {
+		      throw PluginError("Invalid dl-cache size in " + *tok_iter);
+		    }
+
+		  iss >> unit;
+
+		  switch (unit)
+		    {
+		    case 'G': case 'g':
+		      size *= 1024 * 1024 * 1024;
+		      break;
+		    case 'M': case 'm':
+		      size *= 1024 * 1024;
+		      break;
+		    case 'K': case 'k':
+		      size *= 1024;
+		      break;
+		    case 0:
+		      break;
+		    default:
+		      throw PluginError("Invalid dl-cache size in " + *tok_iter);
+		    }
+
+		  cacheBudget = size;
+		}
+	      else if (*tok_iter == "-admit") // cache one-off queries, too
+		{
+		  cacheAdmission = false;
+		}
+	      else if (*tok_iter == "-pipeline") // one round trip per command
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags & ~Registry::PIPELINE); // remove PIPELINE flag
+		}
+	      else if (*tok_iter == "-delta") // fresh ABox clone for each query
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags & ~Registry::ABOXDELTA); // remove ABOXDELTA flag
+		}
+	      else if (*tok_iter == "premise") // one nRQL query per dl-atom
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags | Registry::PREMISE); // add PREMISE flag
+		}
+	      else if (*tok_iter == "coalesce") // batch sibling dl-atoms
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags | Registry::COALESCE); // add COALESCE flag
+		}
+	      else if (*tok_iter == "-promote") // one round trip per boolean dl-atom
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags & ~Registry::PROMOTE); // remove PROMOTE flag
+		}
+	      else if (*tok_iter == "-preload") // lazy loading of ontologies
+		{
+		  unsigned flags = Registry::getFlags();
+		  Registry::setFlags(flags & ~Registry::PRELOAD); // remove PRELOAD flag
+		}
 	    }
 
 	  it = argv.erase(it);
@@ -445,6 +667,70 @@ RacerInterface::setOptions(bool doHelp, std::vector<std::string>& argv, std::ost
 
       ++it; // nothing found, check next position
     }
+
+  // --dldebug may have replaced the cache, so configure it last
+  cache->setBudget(cacheBudget);
+  cache->setAdmission(cacheAdmission);
+  cache->setStore(store);
+}
+
+
+/**
+ * Orders ontologies by their real URI.
+ */
+struct RealURILess
+{
+  bool
+  operator() (const Ontology::shared_pointer& o1, const Ontology::shared_pointer& o2) const
+  {
+    return o1->getRealURI() < o2->getRealURI();
+  }
+};
+
+
+void
+RacerInterface::preload(const std::vector<std::string>& uris)
+{
+  if (!(Registry::getFlags() & Registry::PRELOAD) || preloading)
+    {
+      return;
+    }
+
+  preloading = new boost::thread(boost::bind(&RacerInterface::loadOntologies, this, uris));
+}
+
+
+void
+RacerInterface::loadOntologies(const std::vector<std::string>& uris)
+{
+  OntologyLoader loader;
+
+  for (std::vector<std::string>::const_iterator it = uris.begin(); it != uris.end(); ++it)
+    {
+      loader.add(*it);
+    }
+
+  if (ontology)
+    {
+      loader.add(ontology->getRealURI().getString());
+    }
+
+  std::vector<Ontology::shared_pointer> ontos = loader.load();
+
+  if (Registry::getVerbose() > 0)
+    {
+      const std::vector<std::string>& errors = loader.getErrors();
+
+      for (std::vector<std::string>::const_iterator it = errors.begin(); it != errors.end(); ++it)
+	{
+	  std::cerr << "Warning: Couldn't preload ontology: " << *it << std::endl;
+	}
+    }
+
+  // the threads finish in any order, open the ontologies in a stable one
+  std::sort(ontos.begin(), ontos.end(), RealURILess());
+
+  pool->preload(ontos);
 }
 
 
@@ -41,6 +41,7 @@
 #include <string>
 #include <sstream>
 #include <iterator>
+#include <vector>
 
 #include <cstdio>
 #include <unistd.h>
@@ -84,12 +85,31 @@ RacerKBManager::removeKB() throw (DLError)
 {
   try
     {
-      // send the (forget-abox) command to RACER
+      // send a (forget-abox) command for each working ABox to RACER
+      std::vector<std::string> names;
+
+      if (aboxes.empty())
+	{
+	  names.push_back(kbName);
+	}
+
+      for (ABoxPool::const_iterator it = aboxes.begin(); it != aboxes.end(); ++it)
+	{
+	  names.push_back(it->name);
+	}
+
       RacerForgetABoxCmd cmd;
-      stream << cmd(*this) << std::endl;
-      RacerIgnoreAnswer p(stream);
-      Answer a(0);
-      p.parse(a);
+
+      for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+	{
+	  stream << cmd(*it) << std::endl;
+	  RacerIgnoreAnswer p(stream);
+	  Answer a(0);
+	  p.parse(a);
+	}
+
+      // there are no working ABoxes anymore
+      aboxes.clear();
     }
   catch (std::exception& e)
     {
@@ -124,6 +144,19 @@ RacerKBManager::updateOpenKB() throw (DLError)
 	      *ii = it2->getUnquotedString();
 	    }
 	}
+
+      // forget the fingerprints of KBs which are not loaded anymore
+      for (FingerprintMap::iterator it = fingerprints.begin(); it != fingerprints.end(); )
+	{
+	  if (openKBs.find(it->first) == openKBs.end())
+	    {
+	      fingerprints.erase(it++);
+	    }
+	  else
+	    {
+	      ++it;
+	    }
+	}
     }
   catch (std::exception& e)
     {
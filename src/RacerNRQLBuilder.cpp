@@ -42,10 +42,58 @@
 #include <iostream>
 #include <sstream>
 #include <limits>
+#include <memory>
 
 using namespace dlvhex::dl::racer;
 
 
+namespace {
+
+  /** 
+   * Collects the variables of the (in)equalities in the conjunctive
+   * query @a dlq, they are injective in the head.
+   *
+   * @todo injective variable calculation is incorrect, see file header
+   * 
+   * @param dlq 
+   * @param injectiveVars
+   */
+  void
+  injectiveVariables(const dlvhex::dl::DLQuery& dlq, std::set<dlvhex::ComfortTerm>& injectiveVars)
+  {
+    if (dlq.isConjQuery())
+      {
+	// get all inequalities
+	const dlvhex::ComfortInterpretation& as = dlq.getConjQuery();
+	dlvhex::ComfortInterpretation injCandidates;
+
+	as.matchPredicate("!=", injCandidates);
+
+	for (dlvhex::ComfortInterpretation::const_iterator it = injCandidates.begin(); it != injCandidates.end(); ++it)
+	  {
+	    if (it->getArity() == 2) // ignore malformed (in)equalities
+	      {
+		const dlvhex::ComfortTuple& t = it->getArguments();
+		const dlvhex::ComfortTerm& t0 = t[0];
+		const dlvhex::ComfortTerm& t1 = t[1];
+
+		if (t0.isVariable())
+		  injectiveVars.insert(t0);
+
+		if (t1.isVariable())
+		  injectiveVars.insert(t1);
+	      }
+	  }
+      }
+    else if (dlq.isUnionConjQuery())
+      {
+	///@todo UCQ ignores inequalities here
+      }
+  }
+
+} // namespace
+
+
 bool
 NRQLBaseBuilder::createBody(std::ostream& /* stream */, const Query& /* query */) const
   throw(DLBuildingError)
@@ -62,38 +110,8 @@ NRQLBaseBuilder::createHead(std::ostream& stream, const Query& query) const
   const ComfortTuple& pat = dlq->getPatternTuple();
   bool isEmpty = true;
 
-  ///@todo injective variable calculation is incorrect, see file header
-
   std::set<ComfortTerm> injectiveVars;
-
-  if (dlq->isConjQuery())
-    {
-      // get all inequalities
-      const ComfortInterpretation& as = dlq->getConjQuery();
-      ComfortInterpretation injCandidates;
-
-      as.matchPredicate("!=", injCandidates);
-
-      for (ComfortInterpretation::const_iterator it = injCandidates.begin(); it != injCandidates.end(); ++it)
-	{
-	  if (it->getArity() == 2) // ignore malformed (in)equalities
-	    {
-	      const ComfortTuple& t = it->getArguments();
-	      const ComfortTerm& t0 = t[0];
-	      const ComfortTerm& t1 = t[1];
-	      
-	      if (t0.isVariable())
-		injectiveVars.insert(t0);
-	      
-	      if (t1.isVariable())
-		injectiveVars.insert(t1);
-	    }
-	}
-    }
-  else if (dlq->isUnionConjQuery())
-    {
-      ///@todo UCQ ignores inequalities here
-    }
+  injectiveVariables(*dlq, injectiveVars);
 
   // Iterate through the output list and build a nRQL head. Anonymous
   // variables are ignored, they are going to be taken care of when we
@@ -130,6 +148,75 @@ NRQLBaseBuilder::createHead(std::ostream& stream, const Query& query) const
 }
 
 
+bool
+NRQLBaseBuilder::createFilter(std::ostream& stream, const Query& query) const
+  throw(DLBuildingError)
+{
+  const std::set<ComfortTuple>& cands = query.getCandidates();
+
+  if (!query.hasCandidates() || cands.empty())
+    {
+      return false;
+    }
+
+  const DLQuery::shared_pointer& dlq = query.getDLQuery();
+  const ComfortTuple& pat = dlq->getPatternTuple();
+  const std::string& nspace = dlq->getOntology()->getNamespace();
+
+  std::set<ComfortTerm> injectiveVars;
+  injectiveVariables(*dlq, injectiveVars);
+
+  // (union (and (same-as $?X a) (same-as $?Y b)) ...)
+  NRQLUnion filter;
+
+  for (std::set<ComfortTuple>::const_iterator it = cands.begin(); it != cands.end(); ++it)
+    {
+      if (it->size() != pat.size())
+	{
+	  throw DLBuildingError("Candidate does not match the output list.");
+	}
+
+      std::auto_ptr<NRQLConjunction> body(new NRQLConjunction);
+      bool isEmpty = true;
+
+      for (unsigned i = 0; i < pat.size(); ++i)
+	{
+	  // anonymous variables are not in the head, so we cannot bind them
+	  if (!pat[i].isAnon() && pat[i].isVariable())
+	    {
+	      isEmpty = false;
+
+	      ABoxQueryObject* v = 0;
+
+	      if (injectiveVars.find(pat[i]) == injectiveVars.end())
+		{
+		  v = new ABoxQueryVariable(pat[i], ABoxQueryVariable::VariableType::noninjective);
+		}
+	      else // injective
+		{
+		  v = new ABoxQueryVariable(pat[i]);
+		}
+
+	      body->addAtom(new NRQLQueryAtom
+			    (new SameAsQuery(v, new ABoxQueryIndividual((*it)[i], nspace)))
+			    );
+	    }
+	}
+
+      if (isEmpty) // nothing to filter
+	{
+	  return false;
+	}
+
+      filter.addBody(body.release());
+    }
+
+  stream << filter;
+
+  return true;
+}
+
+
 namespace dlvhex {
   namespace dl {
     namespace racer {
@@ -142,13 +229,15 @@ namespace dlvhex {
 	const Query& query;
 	mutable bool* empty;
 	bool abox;
+	bool retract;
 	
 	InterToAssertion(std::ostream& s,
 			 unsigned c,
 			 const Query& q,
 			 bool& isEmpty,
-			 bool withABox = false)
-	  : pstream(&s), count(c), query(q), empty(&isEmpty), abox(withABox)
+			 bool withABox = false,
+			 bool withRetract = false)
+	  : pstream(&s), count(c), query(q), empty(&isEmpty), abox(withABox), retract(withRetract)
 	{ }
 
 	void
@@ -157,7 +246,7 @@ namespace dlvhex {
 	  *(this->empty) = false;
     std::ostream& stream = *pstream;
 	  
-	  std::string nspace = query.getDLQuery()->getOntology()->getNamespace();
+	  const std::string& nspace = query.getDLQuery()->getOntology()->getNamespace();
 
 	  if (a.getArity() == 1) // concept assertion
 	    {
@@ -166,7 +255,15 @@ namespace dlvhex {
 	      ABoxQueryIndividual::const_pointer i =
 		new ABoxQueryIndividual(a.getArgument(1), nspace);
 	      
-	      if (abox)
+	      if (abox && retract)
+		{
+		  stream << ABoxForgetConceptAssertion(a.isStrongNegated() ?
+						       new ABoxNegatedConcept(c) : c,
+						       i,
+						       query.getKBManager().getKBName()
+						       );
+		}
+	      else if (abox)
 		{
 		  stream << ABoxAddConceptAssertion(a.isStrongNegated() ?
 						    new ABoxNegatedConcept(c) : c,
@@ -196,7 +293,17 @@ namespace dlvhex {
 	      
 	      // -R(a,b) -> (instance a (not (some R (one-of b))))
 	      // does not work? seems like there is a bug in Racer
-	      if (abox)
+	      if (abox && retract)
+		{
+		  stream << ABoxForgetConceptAssertion(new ABoxNegatedConcept
+						       (new ABoxSomeConcept
+							(r, new ABoxOneOfConcept(iv))
+							),
+						       i1,
+						       query.getKBManager().getKBName()
+						       );
+		}
+	      else if (abox)
 		{
 		  stream << ABoxAddConceptAssertion(new ABoxNegatedConcept
 						    (new ABoxSomeConcept
@@ -226,7 +333,11 @@ namespace dlvhex {
 	      ABoxQueryIndividual::const_pointer i2 =
 		new ABoxQueryIndividual(a.getArgument(2), nspace);
 	      
-	      if (abox)
+	      if (abox && retract)
+		{
+		  stream << ABoxForgetRoleAssertion(r, i1, i2, query.getKBManager().getKBName());
+		}
+	      else if (abox)
 		{
 		  stream << ABoxAddRoleAssertion(r, i1, i2, query.getKBManager().getKBName());
 		}
@@ -322,6 +433,41 @@ NRQLStateBuilder::createPremise(std::ostream& stream, const Query& query) const
 }
 
 
+bool
+NRQLStateBuilder::createDelta(std::ostream& stream,
+			      const Query& query,
+			      const ComfortInterpretation& current) const
+  throw(DLBuildingError)
+{
+  bool isEmpty = true;
+
+  const ComfortInterpretation& ints = query.getProjectedInterpretation();
+  const ComfortInterpretation retractions = current.difference(ints);
+  const ComfortInterpretation additions = ints.difference(current);
+
+  if (!retractions.empty())
+    {
+      std::for_each(retractions.begin(), retractions.end(),
+		    InterToAssertion(stream, retractions.size(), query, isEmpty, true, true)
+		    );
+    }
+
+  if (!additions.empty())
+    {
+      if (!isEmpty)
+	{
+	  stream.put(' ');
+	}
+
+      std::for_each(additions.begin(), additions.end(),
+		    InterToAssertion(stream, additions.size(), query, isEmpty, true)
+		    );
+    }
+
+  return !isEmpty;
+}
+
+
 bool
 NRQLConjunctionBuilder::createBody(std::ostream& stream, const Query& query) const
   throw(DLBuildingError)
@@ -680,6 +826,14 @@ NRQLDatatypeBuilder::createHead(std::ostream& stream, const Query& query) const
 }
 
 
+bool
+NRQLDatatypeBuilder::createFilter(std::ostream& /* stream */, const Query& /* query */) const
+  throw(DLBuildingError)
+{
+  return false;
+}
+
+
 bool
 NRQLDatatypeBuilder::createBody(std::ostream& stream, const Query& query) const
   throw(DLBuildingError)
@@ -745,6 +899,132 @@ NRQLDatatypeBuilder::createBody(std::ostream& stream, const Query& query) const
 }
 
 
+namespace {
+
+  // Anonymous variables of the output list get a name according to
+  // their position, otherwise Answer::addTuple() would not be able to
+  // match the tuples of a full retrieval against the output list.
+  ABoxQueryObject*
+  patternObject(const dlvhex::ComfortTuple& pat, unsigned i, const std::string& nspace)
+  {
+    if (pat[i].isAnon())
+      {
+	std::ostringstream oss;
+	oss << "ANON" << i;
+	return new ABoxQueryVariable(dlvhex::ComfortTerm::createVariable(oss.str()),
+				     ABoxQueryVariable::VariableType::noninjective);
+      }
+    else if (pat[i].isVariable())
+      {
+	return new ABoxQueryVariable(pat[i], ABoxQueryVariable::VariableType::noninjective);
+      }
+
+    return new ABoxQueryIndividual(pat[i], nspace);
+  }
+
+} // namespace
+
+
+bool
+NRQLConceptRoleBuilder::createHead(std::ostream& stream, const Query& query) const
+  throw(DLBuildingError)
+{
+  const DLQuery::shared_pointer& dlq = query.getDLQuery();
+  const ComfortTuple& pat = dlq->getPatternTuple();
+  const std::string& nspace = dlq->getOntology()->getNamespace();
+  bool isEmpty = true;
+
+  // individuals of the output list are added by Answer::addTuple(),
+  // and a boolean query yields T or NIL
+  for (unsigned i = 0; i < pat.size(); ++i)
+    {
+      if (pat[i].isVariable() || pat[i].isAnon())
+	{
+	  if (!isEmpty)
+	    {
+	      stream << ' ';
+	    }
+
+	  isEmpty = false;
+
+	  std::auto_ptr<ABoxQueryObject> o(patternObject(pat, i, nspace));
+	  stream << *o;
+	}
+    }
+
+  return !isEmpty;
+}
+
+
+bool
+NRQLConceptRoleBuilder::createBody(std::ostream& stream, const Query& query) const
+  throw(DLBuildingError)
+{
+  const DLQuery::shared_pointer& dlq = query.getDLQuery();
+  const ComfortTerm& q = dlq->getQuery();
+  const ComfortTuple& pat = dlq->getPatternTuple();
+  const std::string& nspace = dlq->getOntology()->getNamespace();
+
+  if (pat.size() == 1) // concept query
+    {
+      const std::string& concept = q.getUnquotedString();
+
+      if (!concept.empty() && concept[0] == '-') // negated concept query
+	{
+	  stream << NRQLQueryAtom
+	    (new ConceptQuery
+	     (new ABoxNegatedConcept
+	      (new ABoxQueryConcept(ComfortTerm::createConstant(concept.substr(1)), nspace)),
+	      patternObject(pat, 0, nspace)
+	      )
+	     );
+	}
+      else
+	{
+	  stream << NRQLQueryAtom
+	    (new ConceptQuery
+	     (new ABoxQueryConcept(q, nspace),
+	      patternObject(pat, 0, nspace)
+	      )
+	     );
+	}
+    }
+  else if (pat.size() == 2) // role query
+    {
+      stream << NRQLQueryAtom
+	(new RoleQuery
+	 (new ABoxQueryRole(q, nspace),
+	  patternObject(pat, 0, nspace),
+	  patternObject(pat, 1, nspace)
+	  )
+	 );
+    }
+  else
+    {
+      throw DLBuildingError("Incompatible pattern supplied.");
+    }
+
+  return true;
+}
+
+
+bool
+NRQLConsistencyBuilder::createHead(std::ostream& /* stream */, const Query& /* query */) const
+  throw(DLBuildingError)
+{
+  return false;
+}
+
+
+bool
+NRQLConsistencyBuilder::createBody(std::ostream& stream, const Query& /* query */) const
+  throw(DLBuildingError)
+{
+  stream << "(true-query)";
+  return true;
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
@@ -0,0 +1,388 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ * 
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+
+/**
+ * @file   RacerPool.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 10:12:31 2026
+ * 
+ * @brief  A pool of RACER backends.
+ * 
+ * 
+ */
+
+#include "RacerPool.h"
+#include "RacerKBManager.h"
+#include "KBManager.h"
+#include "TCPStream.h"
+#include "URI.h"
+#include "Registry.h"
+#include "DLQuery.h"
+#include "Query.h"
+#include "QueryCtx.h"
+#include "Answer.h"
+#include "QueryDirector.h"
+#include "RacerBuilder.h"
+#include "RacerAnswerDriver.h"
+
+#include <iostream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace dlvhex::dl::racer;
+
+
+RacerPool::Lease::Lease(RacerPool& p, const Ontology::shared_pointer& onto) throw (DLError)
+  : pool(p), backend(p.acquire(onto))
+{ }
+
+
+RacerPool::Lease::~Lease()
+{
+  pool.release(backend);
+}
+
+
+std::iostream&
+RacerPool::Lease::getStream() const
+{
+  return *backend.stream;
+}
+
+
+dlvhex::dl::KBManager&
+RacerPool::Lease::getKBManager() const
+{
+  return *backend.kbManager;
+}
+
+
+RacerPool::RacerPool()
+  : backends(), reload(false), timeout(0), aboxes(4),
+    session(), mode(dlvhex::util::TCPIOStream::LIVE), mutex(), released()
+{ }
+
+
+RacerPool::~RacerPool()
+{
+  for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+       it != backends.end(); ++it)
+    {
+      try
+	{
+	  if (it->stream->isOpen())
+	    {
+	      it->kbManager->removeKB(); // remove temporary abox
+	    }
+	}
+      catch (std::exception& e)
+	{
+	  // we ignore this error since dtors must not throw exceptions
+	  std::cerr << "Couldn't remove temporary KB: " << e.what() << std::endl;
+	}
+    }
+
+  clear();
+}
+
+
+void
+RacerPool::addBackend(const std::string& host, unsigned port)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  Backend* b = new Backend;
+  b->stream = new dlvhex::util::TCPIOStream(host, port);
+  b->stream->setTimeout(timeout);
+
+  if (mode != dlvhex::util::TCPIOStream::LIVE)
+    {
+      b->stream->setSession(sessionFile(backends.size()), mode);
+    }
+
+  // each backend gets its own unique temporary ABox
+  b->kbManager = new RacerKBManager(*b->stream);
+  b->kbManager->setMaxWorkingABoxes(aboxes);
+  b->busy = false;
+
+  if (reload)
+    {
+      b->kbManager = new NullKBManager(b->kbManager);
+    }
+
+  backends.push_back(b);
+  released.notify_all();
+}
+
+
+void
+RacerPool::clear()
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+       it != backends.end(); ++it)
+    {
+      delete it->kbManager;
+      delete it->stream;
+    }
+
+  backends.clear();
+}
+
+
+void
+RacerPool::setReload()
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  if (!reload)
+    {
+      for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+	   it != backends.end(); ++it)
+	{
+	  it->kbManager = new NullKBManager(it->kbManager);
+	}
+
+      reload = true;
+    }
+}
+
+
+void
+RacerPool::setTimeout(unsigned ms)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  timeout = ms;
+
+  for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+       it != backends.end(); ++it)
+    {
+      it->stream->setTimeout(ms);
+    }
+}
+
+
+void
+RacerPool::setWorkingABoxes(unsigned n)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  aboxes = n;
+
+  for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+       it != backends.end(); ++it)
+    {
+      it->kbManager->setMaxWorkingABoxes(n);
+    }
+}
+
+
+std::string
+RacerPool::sessionFile(std::size_t i) const
+{
+  std::ostringstream oss;
+  oss << session;
+
+  if (i > 0)
+    {
+      oss << '.' << i;
+    }
+
+  return oss.str();
+}
+
+
+void
+RacerPool::setSession(const std::string& file, dlvhex::util::TCPIOStream::SessionMode m)
+{
+  boost::mutex::scoped_lock lock(mutex);
+
+  session = file;
+  mode = m;
+
+  for (std::size_t i = 0; i < backends.size(); ++i)
+    {
+      backends[i].stream->setSession(sessionFile(i), m);
+    }
+}
+
+
+std::size_t
+RacerPool::size() const
+{
+  boost::mutex::scoped_lock lock(mutex);
+  return backends.size();
+}
+
+
+RacerPool::Backend&
+RacerPool::acquire(const Ontology::shared_pointer& onto) throw (DLError)
+{
+  std::string kbname;
+  std::string fingerprint;
+
+  if (onto)
+    {
+      kbname = "<" + onto->getRealURI().getString() + ">";
+      fingerprint = onto->getFingerprint();
+    }
+
+  boost::mutex::scoped_lock lock(mutex);
+
+  if (backends.empty())
+    {
+      throw DLError("No RACER backend available.");
+    }
+
+  for (;;)
+    {
+      boost::ptr_vector<Backend>::iterator free = backends.end();
+
+      for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+	   it != backends.end(); ++it)
+	{
+	  if (!it->busy)
+	    {
+	      // ontology affinity: this backend saves us loading the KB
+	      if (onto && it->kbManager->isOpenKB(kbname, fingerprint))
+		{
+		  free = it;
+		  break;
+		}
+
+	      if (free == backends.end())
+		{
+		  free = it;
+		}
+	    }
+	}
+
+      if (free != backends.end())
+	{
+	  free->busy = true;
+	  return *free;
+	}
+
+      released.wait(lock);
+    }
+}
+
+
+void
+RacerPool::release(Backend& b)
+{
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    b.busy = false;
+  }
+
+  // acquire() waits for any backend, preloadBackend() for b
+  released.notify_all();
+}
+
+
+void
+RacerPool::preloadBackend(Backend& b, const std::vector<Ontology::shared_pointer>& ontos)
+{
+  {
+    boost::mutex::scoped_lock lock(mutex);
+
+    while (b.busy)
+      {
+	released.wait(lock);
+      }
+
+    b.busy = true;
+  }
+
+  const ComfortTerm none = ComfortTerm::createConstant(" ");
+
+  try
+    {
+      for (std::vector<Ontology::shared_pointer>::const_iterator it = ontos.begin();
+	   it != ontos.end(); ++it)
+	{
+	  // the commands a dl-atom sends before it touches the ABox
+	  QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(*b.stream));
+
+	  comp->add(new QueryDirector<RacerFullResetBuilder, RacerIgnoreAnswer>(*b.stream));
+	  comp->add(new QueryDirector<RacerUNABuilder, RacerIgnoreAnswer>(*b.stream));
+	  comp->add(new QueryDirector<RacerOpenOWLBuilder, RacerAnswerDriver>(*b.stream));
+	  comp->add(new QueryDirector<RacerImportOntologiesBuilder, RacerIgnoreAnswer>(*b.stream));
+
+	  DLQuery::shared_pointer dlq(new DLQuery(*it, none, ComfortTuple()));
+	  Query* q = new Query(*b.kbManager, dlq, none, none, none, none, ComfortInterpretation());
+	  QueryCtx::shared_pointer qctx(new QueryCtx(q, new Answer(q)));
+
+	  comp->query(qctx);
+	}
+    }
+  catch (std::exception& e)
+    {
+      // the first dl-atom opens the ontology again in a fresh session
+      b.kbManager->invalidateSession();
+
+      if (Registry::getVerbose() > 0)
+	{
+	  std::cerr << "Warning: Couldn't preload ontologies: " << e.what() << std::endl;
+	}
+    }
+
+  release(b);
+}
+
+
+void
+RacerPool::preload(const std::vector<Ontology::shared_pointer>& ontos)
+{
+  if (reload || ontos.empty()) // each query loads its ontology anyway
+    {
+      return;
+    }
+
+  // the preloading races the first dl-atoms for the backends, so
+  // the commands of a session would depend on the timing
+  if (mode != dlvhex::util::TCPIOStream::LIVE)
+    {
+      return;
+    }
+
+  boost::thread_group loaders;
+
+  for (boost::ptr_vector<Backend>::iterator it = backends.begin();
+       it != backends.end(); ++it)
+    {
+      loaders.create_thread(boost::bind(&RacerPool::preloadBackend, this, boost::ref(*it), boost::cref(ontos)));
+    }
+
+  loaders.join_all();
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
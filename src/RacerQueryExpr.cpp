@@ -207,6 +207,34 @@ ABoxAddRoleAssertion::output(std::ostream& s) const
 }
 
 
+std::ostream&
+ABoxForgetConceptAssertion::output(std::ostream& s) const
+{
+  return s << "(forget-concept-assertion "
+	   << abox
+	   << ' '
+	   << *iExpr
+	   << ' '
+	   << *cExpr
+	   << ')';
+}
+
+
+std::ostream&
+ABoxForgetRoleAssertion::output(std::ostream& s) const
+{
+  return s << "(forget-role-assertion "
+	   << abox
+	   << ' '
+	   << *i1Expr
+	   << ' '
+	   << *i2Expr
+	   << ' '
+	   << *rExpr
+	   << ')';
+}
+
+
 std::ostream&
 NegationQuery::output(std::ostream& s) const
 {
@@ -37,10 +37,8 @@ using namespace dlvhex::dl;
 //
 // default values for the registry
 //
-unsigned Registry::flags(Registry::UNA);
+unsigned Registry::flags(Registry::UNA | Registry::PIPELINE | Registry::ABOXDELTA | Registry::PROMOTE | Registry::PRELOAD);
 unsigned Registry::verbose(1);
-bool Registry::una(false);
-bool Registry::datasubstrate(false);
 
 
 
@@ -70,30 +68,6 @@ Registry::setVerbose(unsigned v)
   Registry::verbose = v;
 }
 
-bool
-Registry::getUNA()
-{
-  return Registry::una;
-}
-
-void
-Registry::setUNA(bool u)
-{
-  Registry::una = u;
-}
-
-bool
-Registry::getDataSubstrateMirroring()
-{
-  return Registry::datasubstrate;
-}
-
-void
-Registry::setDataSubstrateMirroring(bool d)
-{
-  Registry::datasubstrate = d;
-}
-
 
 // Local Variables:
 // mode: C++
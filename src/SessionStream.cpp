@@ -0,0 +1,256 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SessionStream.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 10:12:40 2026
+ *
+ * @brief  Record and replay the conversation of a TCPStreamBuf.
+ *
+ *
+ */
+
+
+#include "SessionStream.h"
+
+#include <ios>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+
+#include <ctime>        // clock_gettime()
+
+using namespace dlvhex::util;
+
+
+namespace {
+
+  /// @return the monotonic clock in milliseconds
+  long long
+  now()
+  {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+  }
+
+  /// @return the line of @a s which contains position @a pos
+  std::string
+  lineAt(const std::string& s, std::string::size_type pos)
+  {
+    std::string::size_type b = s.rfind('\n', pos > 0 ? pos - 1 : 0);
+    b = (b == std::string::npos || pos == 0) ? 0 : b + 1;
+    std::string::size_type e = s.find('\n', pos);
+    return s.substr(b, e == std::string::npos ? std::string::npos : e - b);
+  }
+
+} // anonymous namespace
+
+
+
+RecordingStreamBuf::RecordingStreamBuf(const std::string& host,
+				       unsigned port,
+				       const std::string& file)
+  : TCPStreamBuf(host, port),
+    session(file.c_str(), std::ios::out | std::ios::trunc | std::ios::binary),
+    start(now())
+{
+  if (!session)
+    {
+      throw std::ios_base::failure("Could not write session file " + file + '.');
+    }
+}
+
+
+void
+RecordingStreamBuf::record(char dir, const std::streambuf::char_type* s, std::streamsize n)
+{
+  session << dir << ' ' << now() - start << ' ' << n << '\n';
+  session.write(s, n);
+  session << '\n' << std::flush; // keep the session if we crash
+}
+
+
+void
+RecordingStreamBuf::transmit(const std::streambuf::char_type* s, std::streamsize n)
+{
+  TCPStreamBuf::transmit(s, n);
+  record('>', s, n);
+}
+
+
+std::streamsize
+RecordingStreamBuf::fetch(std::streambuf::char_type* s, std::streamsize n)
+{
+  std::streamsize ret = TCPStreamBuf::fetch(s, n);
+  record('<', s, ret);
+  return ret;
+}
+
+
+
+ReplayStreamBuf::ReplayStreamBuf(const std::string& host,
+				 unsigned port,
+				 const std::string& file)
+  : TCPStreamBuf(host, port),
+    file(file),
+    commands(),
+    answers(),
+    sent(0),
+    served(0),
+    available(0),
+    recorded(0),
+    replayed(0)
+{
+  load();
+}
+
+
+ReplayStreamBuf::~ReplayStreamBuf()
+{
+  // the dtor must not throw, so just tell what differs
+  if (replayed != recorded || sent != commands.size())
+    {
+      std::cerr << "Replay of " << file << ": "
+		<< replayed << " round trips (recorded " << recorded << "), "
+		<< commands.size() - sent << " bytes of commands not sent." << std::endl;
+    }
+}
+
+
+void
+ReplayStreamBuf::load()
+{
+  std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+
+  if (!in)
+    {
+      throw std::ios_base::failure("Could not read session file " + file + '.');
+    }
+
+  char dir;
+  long long ms;
+  std::streamsize len;
+
+  while (in >> dir >> ms >> len && in.get() == '\n')
+    {
+      std::string bytes(len, '\0');
+
+      if (!in.read(&bytes[0], len) || in.get() != '\n' || (dir != '>' && dir != '<'))
+	{
+	  break;
+	}
+
+      if (dir == '>')
+	{
+	  commands += bytes;
+	  ++recorded;
+	}
+      else
+	{
+	  answers += bytes;
+	}
+    }
+
+  if (!in.eof())
+    {
+      throw std::ios_base::failure("Corrupt session file " + file + '.');
+    }
+}
+
+
+bool
+ReplayStreamBuf::open()
+{
+  return true;
+}
+
+
+bool
+ReplayStreamBuf::isOpen() const
+{
+  return true;
+}
+
+
+void
+ReplayStreamBuf::transmit(const std::streambuf::char_type* s, std::streamsize n)
+{
+  ++replayed;
+
+  std::string cmd(s, n);
+
+  if (commands.compare(sent, n, cmd) != 0)
+    {
+      // find the first diverging command
+      std::string::size_type len = std::min(cmd.size(), commands.size() - sent);
+      std::string::size_type i =
+	std::mismatch(cmd.begin(), cmd.begin() + len, commands.begin() + sent).first - cmd.begin();
+
+      std::ostringstream oss;
+      oss << "Replay of " << file << " diverged at command "
+	  << std::count(commands.begin(), commands.begin() + sent + i, '\n') + 1
+	  << ": expected `" << lineAt(commands, sent + i)
+	  << "', got `" << lineAt(cmd, i) << "'.";
+
+      setp(pbase(), epptr()); // drop the diverging commands
+      throw std::ios_base::failure(oss.str());
+    }
+
+  sent += n;
+
+  // each sent command line releases the next recorded answer line
+  for (std::streamsize lines = std::count(cmd.begin(), cmd.end(), '\n');
+       lines > 0 && available < answers.size(); --lines)
+    {
+      std::string::size_type nl = answers.find('\n', available);
+      available = nl == std::string::npos ? answers.size() : nl + 1;
+    }
+}
+
+
+std::streamsize
+ReplayStreamBuf::fetch(std::streambuf::char_type* s, std::streamsize n)
+{
+  if (served >= available)
+    {
+      close();
+
+      std::ostringstream oss;
+      oss << "Replay of " << file << " has no answer for command "
+	  << std::count(commands.begin(), commands.begin() + sent, '\n') << '.';
+      throw std::ios_base::failure(oss.str());
+    }
+
+  std::streamsize len = std::min<std::streamsize>(n, available - served);
+  std::copy(answers.begin() + served, answers.begin() + served + len, s);
+  served += len;
+
+  return len;
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
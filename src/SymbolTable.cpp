@@ -0,0 +1,221 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ *
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/**
+ * @file   SymbolTable.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 22:05:31 2026
+ *
+ * @brief  Process-wide interning of terms.
+ *
+ *
+ */
+
+
+#include "SymbolTable.h"
+
+#include <map>
+#include <vector>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+using namespace dlvhex::dl;
+
+
+namespace {
+
+  using dlvhex::ComfortTerm;
+
+  /// maps strings to their IDs
+  typedef std::map<std::string, unsigned> StringMap;
+
+  /// maps integers to their IDs
+  typedef std::map<int, unsigned> IntegerMap;
+
+  StringMap strings;
+  IntegerMap integers;
+
+  /// the terms by their IDs
+  std::vector<ComfortTerm> terms;
+
+  /// protects the tables, lookups share it
+  boost::shared_mutex mutex;
+
+  typedef boost::shared_lock<boost::shared_mutex> ReadLock;
+  typedef boost::unique_lock<boost::shared_mutex> WriteLock;
+
+  /// like SymbolTable::find(), #mutex must be locked
+  bool
+  findTerm(const ComfortTerm& t, unsigned& id)
+  {
+    if (t.isInteger())
+      {
+	IntegerMap::const_iterator it = integers.find(t.intval);
+
+	if (it == integers.end())
+	  {
+	    return false;
+	  }
+
+	id = it->second;
+	return true;
+      }
+
+    StringMap::const_iterator it = strings.find(t.strval);
+
+    if (it == strings.end())
+      {
+	return false;
+      }
+
+    id = it->second;
+    return true;
+  }
+
+  /// like SymbolTable::intern(), #mutex must be locked exclusively
+  unsigned
+  internTerm(const ComfortTerm& t)
+  {
+    if (t.isInteger())
+      {
+	IntegerMap::iterator it = integers.lower_bound(t.intval);
+
+	if (it == integers.end() || it->first != t.intval) // fresh integer
+	  {
+	    it = integers.insert(it, std::make_pair(t.intval, static_cast<unsigned>(terms.size())));
+	    terms.push_back(t);
+	  }
+
+	return it->second;
+      }
+
+    StringMap::iterator it = strings.lower_bound(t.strval);
+
+    if (it == strings.end() || it->first != t.strval) // fresh string
+      {
+	it = strings.insert(it, std::make_pair(t.strval, static_cast<unsigned>(terms.size())));
+	terms.push_back(t);
+      }
+
+    return it->second;
+  }
+
+} // anonymous namespace
+
+
+SymbolTable::~SymbolTable()
+{ }
+
+
+unsigned
+SymbolTable::intern(const ComfortTerm& t)
+{
+  unsigned id;
+
+  {
+    ReadLock lock(mutex);
+
+    if (findTerm(t, id))
+      {
+	return id;
+      }
+  }
+
+  WriteLock lock(mutex);
+  return internTerm(t);
+}
+
+
+void
+SymbolTable::intern(const ComfortInterpretation& i, std::vector<AtomKey>& keys)
+{
+  keys.assign(i.size(), AtomKey());
+
+  {
+    // mostly, all terms are known, and the threads look them up side by side
+    ReadLock lock(mutex);
+    bool known = true;
+    std::vector<AtomKey>::iterator k = keys.begin();
+
+    for (ComfortInterpretation::const_iterator it = i.begin(); known && it != i.end(); ++it, ++k)
+      {
+	k->reserve(it->tuple.size() + 1);
+	k->push_back(it->isStrongNegated());
+
+	for (ComfortTuple::const_iterator t = it->tuple.begin(); known && t != it->tuple.end(); ++t)
+	  {
+	    unsigned id;
+	    known = findTerm(*t, id);
+	    k->push_back(id);
+	  }
+      }
+
+    if (known)
+      {
+	return;
+      }
+  }
+
+  WriteLock lock(mutex);
+  std::vector<AtomKey>::iterator k = keys.begin();
+
+  for (ComfortInterpretation::const_iterator it = i.begin(); it != i.end(); ++it, ++k)
+    {
+      k->clear();
+      k->push_back(it->isStrongNegated());
+
+      for (ComfortTuple::const_iterator t = it->tuple.begin(); t != it->tuple.end(); ++t)
+	{
+	  k->push_back(internTerm(*t));
+	}
+    }
+}
+
+
+bool
+SymbolTable::find(const ComfortTerm& t, unsigned& id)
+{
+  ReadLock lock(mutex);
+  return findTerm(t, id);
+}
+
+
+ComfortTerm
+SymbolTable::getTerm(unsigned id)
+{
+  ReadLock lock(mutex);
+  return terms.at(id);
+}
+
+
+std::size_t
+SymbolTable::size()
+{
+  ReadLock lock(mutex);
+  return terms.size();
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
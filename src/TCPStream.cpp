@@ -32,7 +32,9 @@
 
 
 #include "TCPStream.h"
+#include "SessionStream.h"
 #include "LogBuf.h"
+#include "DLError.h"
 
 #include <ios>
 #include <sstream>
@@ -42,34 +44,100 @@
 #include <csignal>      // sigaction()
 #include <cerrno>       // errno & co.
 #include <cstring>      // memset()
+#include <ctime>        // clock_gettime()
 #include <sys/types.h>  // 
 #include <sys/socket.h> // socket()
-#include <unistd.h>     // close()
-#include <netdb.h>      // gethostbyname()
+#include <sys/epoll.h>  // epoll_create() & co.
 #include <sys/select.h> // select()
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <unistd.h>     // close()
+#include <fcntl.h>      // fcntl()
+#include <netdb.h>      // getaddrinfo()
 
 using namespace dlvhex::util;
 
 
+namespace {
+
+  /// @return the monotonic clock in milliseconds
+  long long
+  now()
+  {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+  }
+
+} // anonymous namespace
+
+
 
 TCPIOStream::TCPIOStream(const std::string& host, unsigned port)
-  : std::iostream(new TCPStreamBuf(host, port))
+  : std::iostream(0),
+    connections(),
+    timeout(0),
+    session(),
+    mode(LIVE)
 {
+  setConnection(host, port);
   exceptions(std::ios_base::badbit); // let TCPStreamBuf throw std::ios_base::failure
 }
 
 
 TCPIOStream::~TCPIOStream()
 {
-  delete rdbuf();
+  for (ConnectionMap::iterator it = connections.begin();
+       it != connections.end(); ++it)
+    {
+      delete it->second;
+    }
 }
 
 
 void
 TCPIOStream::setConnection(const std::string& host, unsigned port)
 {
-  delete rdbuf();		       // delete old streambuf
-  rdbuf(new TCPStreamBuf(host, port)); // set new streambuf
+  // flush pending commands to the old peer
+  if (rdbuf())
+    {
+      rdbuf()->pubsync();
+    }
+
+  TCPStreamBuf*& sb = connections[std::make_pair(host, port)];
+
+  if (sb == 0) // first connection to host:port
+    {
+      sb = createStreamBuf(host, port);
+      sb->setTimeout(timeout);
+    }
+
+  rdbuf(sb); // set new streambuf
+}
+
+
+TCPStreamBuf*
+TCPIOStream::createStreamBuf(const std::string& host, unsigned port) const
+{
+  if (mode == LIVE)
+    {
+      return new TCPStreamBuf(host, port);
+    }
+
+  // the new connection is already in the map
+  std::ostringstream file;
+  file << session;
+
+  if (connections.size() > 1)
+    {
+      file << '.' << connections.size() - 1;
+    }
+
+  if (mode == RECORD)
+    {
+      return new RecordingStreamBuf(host, port, file.str());
+    }
+
+  return new ReplayStreamBuf(host, port, file.str());
 }
 
 
@@ -80,6 +148,48 @@ TCPIOStream::isOpen() const
 }
 
 
+void
+TCPIOStream::setTimeout(unsigned ms)
+{
+  timeout = ms;
+
+  for (ConnectionMap::iterator it = connections.begin();
+       it != connections.end(); ++it)
+    {
+      it->second->setTimeout(ms);
+    }
+}
+
+
+void
+TCPIOStream::setSession(const std::string& file, SessionMode m)
+{
+  ConnectionMap old;
+  old.swap(connections);
+
+  session = file;
+  mode = m;
+
+  // reconnect to the current peer, then drop the old connections
+  // along with their pending commands
+  for (ConnectionMap::iterator it = old.begin(); it != old.end(); ++it)
+    {
+      if (it->second == rdbuf())
+	{
+	  TCPStreamBuf*& sb = connections[it->first];
+	  sb = createStreamBuf(it->first.first, it->first.second);
+	  sb->setTimeout(timeout);
+	  rdbuf(sb);
+	}
+    }
+
+  for (ConnectionMap::iterator it = old.begin(); it != old.end(); ++it)
+    {
+      delete it->second;
+    }
+}
+
+
 TCPStreamBuf::TCPStreamBuf(const std::string& host,
 			   unsigned port,
 			   std::streamsize bufsize)
@@ -87,9 +197,17 @@ TCPStreamBuf::TCPStreamBuf(const std::string& host,
     host(host),
     port(port),
     sockfd(-1),
-    bufsize(bufsize),
+    epfd(-1),
+    addr(),
+    resolved(false),
+    obufsize(bufsize > 0 ? bufsize : 1),
+    ibufsize(bufsize > 0 ? bufsize : 1),
     obuf(0),
-    ibuf(0)
+    ibuf(0),
+    iend(0),
+    corked(false),
+    timeout(0),
+    deadline(0)
 {
   // ignore SIGPIPE
   struct sigaction sa;
@@ -111,10 +229,18 @@ TCPStreamBuf::TCPStreamBuf(const TCPStreamBuf& sb)
   : std::streambuf(),
     host(sb.host),
     port(sb.port),
-    sockfd(sb.sockfd),
-    bufsize(sb.bufsize),
+    sockfd(-1),
+    epfd(-1),
+    addr(sb.addr),
+    resolved(sb.resolved),
+    obufsize(sb.obufsize),
+    ibufsize(sb.ibufsize),
     obuf(0),
-    ibuf(0)
+    ibuf(0),
+    iend(0),
+    corked(false),
+    timeout(sb.timeout),
+    deadline(0)
 {
   initBuffers(); // don't call virtual methods in the ctor
 }
@@ -128,6 +254,8 @@ TCPStreamBuf::operator= (const TCPStreamBuf&)
 
 TCPStreamBuf::~TCPStreamBuf()
 {
+  close();
+
   if (ibuf)
     {
       delete[] ibuf;
@@ -139,20 +267,17 @@ TCPStreamBuf::~TCPStreamBuf()
       delete[] obuf;
       obuf = 0;
     }
-
-  close();
 }
 
 
 void
 TCPStreamBuf::initBuffers()
 {
-  obuf = new std::streambuf::char_type[bufsize];
-  ibuf = new std::streambuf::char_type[bufsize];
-  std::memset(obuf, 0, bufsize);
-  std::memset(ibuf, 0, bufsize);
-  setp(obuf, obuf + bufsize);
+  obuf = new std::streambuf::char_type[obufsize];
+  ibuf = new std::streambuf::char_type[ibufsize];
+  setp(obuf, obuf + obufsize);
   setg(ibuf, ibuf, ibuf);
+  iend = ibuf;
 }
 
 
@@ -163,33 +288,60 @@ TCPStreamBuf::isOpen() const
 }
 
 
-bool
-TCPStreamBuf::open()
+void
+TCPStreamBuf::cork(bool c)
 {
-  if (!isOpen())
+  corked = c;
+}
+
+
+void
+TCPStreamBuf::setTimeout(unsigned ms)
+{
+  timeout = ms;
+}
+
+
+void
+TCPStreamBuf::resolve()
+{
+  if (!resolved)
     {
-      //
-      // resolve hostname
-      //
+      struct addrinfo hints;
+      struct addrinfo* res = 0;
 
-      struct hostent* he = ::gethostbyname(host.c_str());
-      if (he == 0)
+      std::memset(&hints, 0, sizeof hints);
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+
+      int err = ::getaddrinfo(host.c_str(), 0, &hints, &res);
+
+      if (err != 0 || res == 0)
 	{
 	  std::ostringstream oss;
-	  oss << "Could not resolve host " << host << ": " << ::hstrerror(h_errno);
+	  oss << "Could not resolve host " << host << ": " << ::gai_strerror(err);
 	  throw std::ios_base::failure(oss.str());
 	}
 
+      std::memcpy(&addr, res->ai_addr, sizeof addr);
+      addr.sin_port = htons(port);
+      ::freeaddrinfo(res);
+
+      resolved = true;
+    }
+}
+
+
+bool
+TCPStreamBuf::open()
+{
+  if (!isOpen())
+    {
       //
-      // setup connection parameters      
+      // resolve hostname only once
       //
 
-      struct sockaddr_in sa;
-      std::memset (&sa, 0, sizeof (struct sockaddr_in));
-
-      sa.sin_family = AF_INET;
-      sa.sin_port   = htons(port);
-      std::memcpy(&sa.sin_addr, he->h_addr, he->h_length);
+      resolve();
 
       //
       // retry to connect to peer for at most 3 seconds (approx. 10 rounds)
@@ -201,20 +353,51 @@ TCPStreamBuf::open()
 	  close();
 
 	  //
-	  // setup socket
+	  // setup non-blocking socket and its epoll instance
 	  //
 
 	  sockfd = ::socket(PF_INET, SOCK_STREAM, 0);
+	  epfd = ::epoll_create(1);
 
-	  if (sockfd < 0)
+	  if (sockfd < 0 || epfd < 0)
 	    {
 	      ::perror("socket");
 	      ::exit(1);
 	    }
 
+	  ::fcntl(sockfd, F_SETFL, ::fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK);
+
+	  // we send small commands and wait for the answer, so don't
+	  // let Nagle's algorithm delay them
+	  int one = 1;
+	  ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+	  struct epoll_event ev;
+	  std::memset(&ev, 0, sizeof ev);
+	  ev.data.fd = sockfd;
+	  ::epoll_ctl(epfd, EPOLL_CTL_ADD, sockfd, &ev);
+
 	  // connect to the TCP server at host:port
 
-	  if (::connect(sockfd, reinterpret_cast<const struct sockaddr *>(&sa), sizeof sa) == 0)
+	  int ret = ::connect(sockfd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof addr);
+
+	  if (ret != 0 && errno == EINPROGRESS)
+	    {
+	      // wait at most 300ms for the connection
+	      struct epoll_event evs;
+	      ev.events = EPOLLOUT;
+	      ::epoll_ctl(epfd, EPOLL_CTL_MOD, sockfd, &ev);
+
+	      if (::epoll_wait(epfd, &evs, 1, 300) == 1)
+		{
+		  int err = 0;
+		  socklen_t len = sizeof err;
+		  ::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len);
+		  ret = err == 0 ? 0 : -1;
+		}
+	    }
+
+	  if (ret == 0)
 	    {
 	      return true; // connection established
 	    }
@@ -246,14 +429,78 @@ TCPStreamBuf::close()
 
   if (sockfd != -1)
     {
-      ::close(sockfd);
+      ret = ::close(sockfd);
       sockfd = -1;
     }
+
+  if (epfd != -1)
+    {
+      ::close(epfd);
+      epfd = -1;
+    }
+
+  // pending answers are lost with the connection
+  iend = ibuf;
+  setg(ibuf, ibuf, ibuf);
      
   return ret == 0;
 }
 
 
+void
+TCPStreamBuf::arm()
+{
+  deadline = timeout ? now() + timeout : 0;
+}
+
+
+void
+TCPStreamBuf::wait(unsigned events)
+{
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof ev);
+  ev.events = events;
+  ev.data.fd = sockfd;
+  ::epoll_ctl(epfd, EPOLL_CTL_MOD, sockfd, &ev);
+
+  for (;;)
+    {
+      int ms = -1; // wait forever
+
+      if (deadline)
+	{
+	  long long left = deadline - now();
+	  ms = left > 0 ? static_cast<int>(left) : 0;
+	}
+
+      int n = ::epoll_wait(epfd, &ev, 1, ms);
+
+      if (n > 0) // ready, or an error which recv()/send() will report
+	{
+	  return;
+	}
+      else if (n == 0) // missed the deadline
+	{
+	  // the answer may still arrive, so this connection is out
+	  // of sync and we have to start over
+	  setp(obuf, obuf + obufsize);
+	  close();
+
+	  std::ostringstream oss;
+	  oss << "No answer from " << host << ':' << port
+	      << " within " << timeout << "ms.";
+	  throw dlvhex::dl::DLTimeoutError(oss.str());
+	}
+      else if (errno != EINTR)
+	{
+	  std::ostringstream oss;
+	  oss << "Could not wait for peer (errno = " << errno << ").";
+	  throw std::ios_base::failure(oss.str());
+	}
+    }
+}
+
+
 std::streambuf::int_type
 TCPStreamBuf::overflow(std::streambuf::int_type c)
 {
@@ -262,9 +509,20 @@ TCPStreamBuf::overflow(std::streambuf::int_type c)
       return traits_type::eof();
     }
 
-  if (pptr() >= epptr()) // full obuf -> write buffer
+  if (pptr() >= epptr()) // full obuf
     {
-      if (sync() == -1)
+      if (corked) // keep the commands together -> grow obuf
+	{
+	  std::streamsize len = pptr() - pbase();
+	  std::streambuf::char_type* nbuf = new std::streambuf::char_type[2 * obufsize];
+	  std::memcpy(nbuf, obuf, len);
+	  delete[] obuf;
+	  obuf = nbuf;
+	  obufsize *= 2;
+	  setp(obuf, obuf + obufsize);
+	  pbump(len);
+	}
+      else if (sendOutput() == -1) // write buffer
 	{
 	  return traits_type::eof();
 	}
@@ -282,6 +540,117 @@ TCPStreamBuf::overflow(std::streambuf::int_type c)
 }
 
 
+std::streambuf::char_type*
+TCPStreamBuf::answerEnd(std::streambuf::char_type* b) const
+{
+  std::streambuf::char_type* nl = static_cast<std::streambuf::char_type*>
+    (std::memchr(b, '\n', iend - b));
+
+  return nl ? nl + 1 : iend;
+}
+
+
+void
+TCPStreamBuf::receive()
+{
+  // we are about to wait, so the peer must have all our commands,
+  // even if the stream is corked
+  sendOutput();
+
+  std::streamsize keep = iend - gptr();
+
+  if (keep >= ibufsize / 2) // large answer -> grow ibuf
+    {
+      std::streambuf::char_type* nbuf = new std::streambuf::char_type[2 * ibufsize];
+      std::memcpy(nbuf, gptr(), keep);
+      delete[] ibuf;
+      ibuf = nbuf;
+      ibufsize *= 2;
+    }
+  else if (keep > 0)
+    {
+      std::memmove(ibuf, gptr(), keep);
+    }
+
+  iend = ibuf + keep;
+  setg(ibuf, ibuf, iend);
+
+  // try to receive as much as fits into ibuf
+  std::streamsize n = fetch(iend, ibufsize - keep);
+
+  log << "Received: " << std::string(iend, n) << std::flush;
+
+  iend += n;
+  setg(ibuf, ibuf, answerEnd(ibuf)); // set new input buffer boundaries
+}
+
+
+std::streamsize
+TCPStreamBuf::fetch(std::streambuf::char_type* s, std::streamsize n)
+{
+  ssize_t ret;
+
+  while ((ret = ::recv(sockfd, s, n, 0)) < 0
+	 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+      wait(EPOLLIN);
+    }
+
+  // Nothing is received (ret = 0) when RACER query handling
+  // timeouts. In this case RACERs only answer is empty and we
+  // cannot use the stream any more, so just bail out. Otherwise
+  // (ret < 0), a failure occured while receiving from the stream
+  if (ret <= 0)
+    {
+      close();
+      throw std::ios_base::failure("Peer prematurely closed connection.");
+    }
+
+  return ret;
+}
+
+
+void
+TCPStreamBuf::nextAnswer()
+{
+  if (egptr() < iend)
+    {
+      setg(egptr(), egptr(), answerEnd(egptr()));
+    }
+  else
+    {
+      iend = ibuf;
+      setg(ibuf, ibuf, ibuf);
+    }
+
+  // the next answer gets its own deadline
+  arm();
+}
+
+
+void
+TCPStreamBuf::answer(const std::streambuf::char_type*& b,
+		     const std::streambuf::char_type*& e)
+{
+  open();
+
+  // the current answer was consumed without hitting its end
+  if (gptr() >= egptr() && egptr() > eback() && traits_type::eq(*(egptr() - 1), '\n'))
+    {
+      nextAnswer();
+    }
+
+  // wait until the whole answer is in ibuf
+  while (gptr() >= egptr() || !traits_type::eq(*(egptr() - 1), '\n'))
+    {
+      receive();
+    }
+
+  b = gptr();
+  e = egptr();
+}
+
+
 std::streambuf::int_type
 TCPStreamBuf::underflow()
 {
@@ -290,30 +659,17 @@ TCPStreamBuf::underflow()
       return traits_type::eof();
     }
 
-  if (gptr() >= egptr()) // empty ibuf -> get data
+  if (gptr() >= egptr()) // current answer consumed -> get data
     {
-      if ((egptr() > ibuf) && traits_type::eq(*(egptr() - 1), '\n'))
+      if ((egptr() > eback()) && traits_type::eq(*(egptr() - 1), '\n'))
 	{
-	  // if last character was a '\n' we are done -> reset buffers
-	  sync();
+	  // if last character was a '\n' we are done with this
+	  // answer, the next read starts with the pending answers
+	  nextAnswer();
 	  return traits_type::eof();
 	}
 
-      // try to receive at most bufsize bytes
-      ssize_t n = ::recv(sockfd, ibuf, bufsize, 0);
-
-      // Nothing is received (n = 0) when RACER query handling
-      // timeouts. In this case RACERs only answer is empty and we
-      // cannot use the stream any more, so just bail out. Otherwise
-      // (n < 0), a failure occured while receiving from the stream
-      if (n <= 0)
-	{
-	  throw std::ios_base::failure("Peer prematurely closed connection.");
-	}
-
-      log << "Received: " << std::string(ibuf, n) << std::flush;
-
-      setg(ibuf, ibuf, ibuf + n); // set new input buffer boundaries
+      receive();
     }
 
   return traits_type::to_int_type(*gptr());
@@ -329,46 +685,67 @@ TCPStreamBuf::sync()
       return -1;
     }
 
-  // reset input buffer
-  std::memset(ibuf, 0, bufsize);
-  setg(ibuf, ibuf, ibuf);
+  return corked ? 0 : sendOutput();
+}
 
-  if (pptr() != pbase()) // non-empty obuf -> send data
+
+void
+TCPStreamBuf::transmit(const std::streambuf::char_type* s, std::streamsize n)
+{
+  // loops until the whole sequence is sent
+  //
+  // Warning: when peer disconnects during the sending we receive
+  // a SIGPIPE and the default signal handler exits the program.
+  // Therefore we have to ignore SIGPIPE (in ctor) and reset the
+  // obuf followed by an error return value. See chapter 5.13 of
+  // W.R. Stevens: Unix Network Programming Vol.1. FYI: Linux has
+  // a MSG_NOSIGNAL flag which does the same, but isn't portable
+  // enough...
+  std::streamsize written = 0;
+
+  while (written < n)
     {
-      errno = 0;
+      ssize_t ret = ::send(sockfd, s + written, n - written, 0);
 
-      // loops until whole obuf is sent
-      //
-      // Warning: when peer disconnects during the sending we receive
-      // a SIGPIPE and the default signal handler exits the program.
-      // Therefore we have to ignore SIGPIPE (in ctor) and reset the
-      // obuf followed by an error return value. See chapter 5.13 of
-      // W.R. Stevens: Unix Network Programming Vol.1. FYI: Linux has
-      // a MSG_NOSIGNAL flag which does the same, but isn't portable
-      // enough...
-      ssize_t len = pptr() - pbase();
-      ssize_t ret = 0;
-
-      for (ssize_t written = 0;
-	   (written < len) || (ret <= 0);
-	   written += ret)
+      if (ret > 0)
 	{
-	  ret = ::send (sockfd, pbase() + written, len - written, 0);
+	  written += ret;
 	}
+      else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+	{
+	  wait(EPOLLOUT);
+	}
+      else // EOF or failure
+	{
+	  int err = errno;
 
-      log << "Sent: " << std::string(pbase(), pptr() - pbase()) << std::flush;
-
-      // reset output buffer right after sending to the stream
-      std::memset(obuf, 0, bufsize);
-      setp(obuf, obuf + bufsize);
+	  // reset output buffer, the connection is unusable
+	  setp(obuf, obuf + obufsize);
+	  close();
 
-      if (ret <= 0 || errno == EPIPE) // EOF or failure
-	{
 	  std::ostringstream oss;
-	  oss << "Could not send to peer (errno = " << errno << ").";
+	  oss << "Could not send to peer (errno = " << err << ").";
 	  throw std::ios_base::failure(oss.str());
 	}
     }
+}
+
+
+std::streambuf::int_type
+TCPStreamBuf::sendOutput()
+{
+  if (pptr() != pbase()) // non-empty obuf -> send data
+    {
+      // the answers to these commands are due by now + timeout
+      arm();
+
+      transmit(pbase(), pptr() - pbase());
+
+      log << "Sent: " << std::string(pbase(), pptr() - pbase()) << std::flush;
+
+      // reset output buffer right after sending to the stream
+      setp(obuf, obuf + obufsize);
+    }
   
   return 0;
 }
@@ -23,7 +23,10 @@
 
 import SocketServer, socket, sys, time
 
-if len(sys.argv) < 3: print "Usage:", sys.argv[0], "FROMPORT TOPORT", sys.exit(1)
+if len(sys.argv) < 3: print "Usage:", sys.argv[0], "FROMPORT TOPORT [TRANSCRIPT]", sys.exit(1)
+
+# record the exchanged lines for RacerMock.py -t TRANSCRIPT
+transcript = len(sys.argv) > 3 and open(sys.argv[3], 'a') or None
 
 class LineGateway(SocketServer.BaseRequestHandler):
 
@@ -45,6 +48,7 @@ class LineGateway(SocketServer.BaseRequestHandler):
       line = sock1.readline()
       if line is '': raise StopIteration # nothing received, sock1 closed connection
       sock2.write(line), sock2.flush()
+      if transcript: transcript.write(line), transcript.flush()
 
    def handle(self): # do the actual echoing
       try:
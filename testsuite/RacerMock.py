@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+
+# dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+#
+# Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+#
+# This file is part of dlvhex-dlplugin.
+#
+# dlvhex-dlplugin is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# dlvhex-dlplugin is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+# Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+
+#
+# A stand-in for RacerPro which speaks its line protocol, i.e., it
+# reads one command per line and replies with
+#
+#   :answer N "RESULT" "WARNING"   or   :error N MESSAGE ""
+#
+# The replies are taken from
+#
+#  - a transcript (-t FILE) of alternating command and answer lines,
+#    e.g. recorded with LineScoop.py, which is replayed for commands
+#    matching a recorded command exactly,
+#
+#  - scripts (-s FILE) with lines "REGEX<TAB>RESULT", the first rule
+#    whose REGEX is found in the command wins, RESULT may refer to
+#    groups of REGEX (\1, \g<name>), and a RESULT starting with '!' is
+#    sent as error message,
+#
+#  - and built-in defaults: boolean queries are true, retrievals are
+#    empty, and all other commands are acknowledged.
+#
+# Each reply is delayed by LATENCY milliseconds (-l) plus a random
+# jitter of at most JITTER milliseconds (-j).
+#
+
+import getopt, random, re, sys, time
+
+try: import socketserver # python 3
+except ImportError: import SocketServer as socketserver
+
+def usage():
+   sys.stderr.write("Usage: %s [-p PORT] [-l LATENCY] [-j JITTER] [-t TRANSCRIPT] [-s SCRIPT]*\n" % sys.argv[0])
+   sys.exit(1)
+
+try: opts, args = getopt.getopt(sys.argv[1:], 'p:l:j:t:s:h')
+except getopt.GetoptError: usage()
+
+port, latency, jitter, transcript, rules = 8088, 0.0, 0.0, {}, []
+
+defaults = [ # the built-in rules, tried after the scripted rules
+   (re.compile(r'^\((individual-instance\?|individuals-related\?|abox-consistent\?|abox-consistent-p)[\s)]'), 'T'),
+   (re.compile(r'\(true-query\)'), 'T'),
+   (re.compile(r'^\(retrieve-under-premise \(.*\) \(\) '), 'T'), # empty head -> boolean query
+   (re.compile(r'^\((concept-instances|retrieve|retrieve-under-premise|related-individuals|individual-fillers|all-individuals)[\s)-]'), 'NIL'),
+   (re.compile(r''), ':OKAY')
+   ]
+
+for o, a in opts:
+   if o == '-p': port = int(a)
+   elif o == '-l': latency = float(a) / 1000
+   elif o == '-j': jitter = float(a) / 1000
+   elif o == '-t':
+      lines = [l.rstrip('\r\n') for l in open(a)]
+      for cmd, ans in zip(lines[0::2], lines[1::2]): transcript[cmd] = ans
+   elif o == '-s':
+      for l in open(a):
+         l = l.rstrip('\r\n')
+         if l == '' or l.startswith('#'): continue
+         regex, result = l.split('\t', 1)
+         rules.append((re.compile(regex), result))
+   else: usage()
+
+def reply(n, cmd): # build the reply to the n-th command cmd
+   if cmd in transcript: # recorded answers get the current answer number
+      return re.sub(r'^(:\w+) \d+', r'\g<1> %d' % n, transcript[cmd], 1)
+   for regex, result in rules + defaults:
+      m = regex.search(cmd)
+      if m:
+         result = m.expand(result)
+         if result.startswith('!'): return ':error %d %s ""' % (n, result[1:])
+         return ':answer %d "%s" ""' % (n, result)
+
+class RacerMock(socketserver.StreamRequestHandler):
+
+   def handle(self): # answer the commands of a connection in order
+      n = 0
+      while True:
+         cmd = self.rfile.readline()
+         if not cmd: break # peer closed connection
+         cmd = cmd.decode('latin-1').strip()
+         if cmd == '': continue
+         n += 1
+         if latency or jitter: time.sleep(latency + random.uniform(0, jitter))
+         self.wfile.write((reply(n, cmd) + '\n').encode('latin-1'))
+         self.wfile.flush()
+
+# start a threading TCPServer, each connection of a RacerPool gets its own thread
+class ThreadingTCPServer(socketserver.ThreadingMixIn, socketserver.TCPServer):
+   allow_reuse_address = True
+   daemon_threads = True
+
+try: ThreadingTCPServer(('', port), RacerMock).serve_forever()
+except KeyboardInterrupt: pass
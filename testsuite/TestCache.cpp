@@ -32,11 +32,17 @@
 
 
 #include "Cache.h"
+#include "SymbolTable.h"
+#include "CacheStore.h"
 #include "KBManager.h"
 #include "Answer.h"
 
 #include "TestCache.h"
 
+#include <sstream>
+#include <vector>
+#include <cstdio>
+
 
 using namespace dlvhex::dl;
 using namespace dlvhex::dl::test;
@@ -256,6 +262,617 @@ TestCache::runNonBooleanCache()
 }
 
 
+void
+TestCache::runSubsumptionCache()
+{
+  KBManager kb("DEFAULT");
+
+  Tuple out(1,Term("i1"));
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  Term("q1"),
+					  out
+					  )
+			      );
+
+  // pc(q1,i0), ..., pc(q1,i9)
+  std::vector<AtomPtr> atoms;
+  for (unsigned n = 0; n < 10; ++n)
+    {
+      std::ostringstream oss;
+      oss << "pc(q1,i" << n << ")";
+      atoms.push_back(AtomPtr(new Atom(oss.str())));
+    }
+
+  std::vector<QueryCtx::shared_pointer> positive;
+
+  // positive answers for {i0,...,in}, n = 9, ..., 5
+  for (unsigned n = 9; n >= 5; --n)
+    {
+      AtomSet ints;
+      for (unsigned m = 0; m <= n; ++m)
+	{
+	  ints.insert(atoms[m]);
+	}
+
+      Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+      Answer* a = new Answer(q);
+      a->setAnswer(true);
+      positive.push_back(QueryCtx::shared_pointer(new QueryCtx(q,a)));
+
+      cache->insert(positive.back());
+    }
+
+  // each one subsumes its predecessors, so only {i0,...,i5} is left
+  CPPUNIT_ASSERT(stats->qctxno() == 1);
+  CPPUNIT_ASSERT(stats->dlqno() == 1);
+
+  // {i0,...,i9} is a superset of {i0,...,i5}
+  CPPUNIT_ASSERT(cache->cacheHit(positive.front()) == positive.back());
+
+  // a negative answer for {i6}
+  AtomSet ints;
+  ints.insert(atoms[6]);
+
+  Query* q1 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  Answer* a1 = new Answer(q1);
+  a1->setAnswer(false);
+  QueryCtx::shared_pointer qctx1(new QueryCtx(q1,a1));
+
+  CPPUNIT_ASSERT(cache->cacheHit(qctx1) == QueryCtx::shared_pointer());
+  cache->insert(qctx1);
+  CPPUNIT_ASSERT(stats->qctxno() == 2);
+
+  // the empty interpretation is a subset of {i6}, but {i7} is unknown
+  ints.clear();
+  Query* q2 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  Answer* a2 = new Answer(q2);
+  QueryCtx::shared_pointer qctx2(new QueryCtx(q2,a2));
+
+  CPPUNIT_ASSERT(cache->cacheHit(qctx2) == qctx1);
+
+  ints.insert(AtomPtr(new Atom("pc(q1,i7)")));
+  ints.insert(AtomPtr(new Atom("pc(q1,i42)")));
+  Query* q3 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  Answer* a3 = new Answer(q3);
+  QueryCtx::shared_pointer qctx3(new QueryCtx(q3,a3));
+
+  CPPUNIT_ASSERT(cache->cacheHit(qctx3) == QueryCtx::shared_pointer());
+}
+
+
+
+void
+TestCache::runCanonicalQuery()
+{
+  Ontology::shared_pointer onto = Ontology::createOntology(shop);
+
+  Tuple xy;
+  xy.push_back(Term("X"));
+  xy.push_back(Term("Y"));
+
+  Tuple uv;
+  uv.push_back(Term("U"));
+  uv.push_back(Term("V"));
+
+  // moo(X,Z), foo(Z), moo(Z,Y)
+  AtomSet cq1;
+  cq1.insert(AtomPtr(new Atom("moo(X,Z)")));
+  cq1.insert(AtomPtr(new Atom("foo(Z)")));
+  cq1.insert(AtomPtr(new Atom("moo(Z,Y)")));
+
+  // the same query with renamed variables
+  AtomSet cq2;
+  cq2.insert(AtomPtr(new Atom("foo(W)")));
+  cq2.insert(AtomPtr(new Atom("moo(W,V)")));
+  cq2.insert(AtomPtr(new Atom("moo(U,W)")));
+
+  // the same query with swapped output
+  AtomSet cq3;
+  cq3.insert(AtomPtr(new Atom("moo(Y,Z)")));
+  cq3.insert(AtomPtr(new Atom("foo(Z)")));
+  cq3.insert(AtomPtr(new Atom("moo(Z,X)")));
+
+  DLQuery q1(onto, cq1, xy);
+  DLQuery q2(onto, cq2, uv);
+  DLQuery q3(onto, cq3, xy);
+
+  CPPUNIT_ASSERT(q1 == q2);
+  CPPUNIT_ASSERT(!(q1 < q2) && !(q2 < q1));
+  CPPUNIT_ASSERT(!(q1 == q3));
+
+  // a single atom CQ is the concept retrieval of its concept
+  Tuple x(1, Term("X"));
+  AtomSet cq4;
+  cq4.insert(AtomPtr(new Atom("foo(X)")));
+
+  DLQuery q4(onto, cq4, x);
+  DLQuery q5(onto, Term("foo"), x);
+
+  CPPUNIT_ASSERT(q4 == q5);
+
+  // but a datatype role retrieval is not a role retrieval
+  DLQuery q6(onto, Term("moo"), xy);
+  DLQuery q7(onto, Term("moo"), xy);
+  q7.setDatatype();
+
+  CPPUNIT_ASSERT(!(q6 == q7));
+}
+
+
+
+void
+TestCache::runBoundedCache()
+{
+  KBManager kb("DEFAULT");
+
+  Tuple out(1,Term("X"));
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  Term("q1"),
+					  out
+					  )
+			      );
+
+  AtomPtr ap1(new Atom("pc(q1,i1)"));
+  AtomPtr ap2(new Atom("pc(q1,i2)"));
+  AtomPtr ap3(new Atom("pc(q1,i3)"));
+
+  // {pc(q1,i1)} yields i1
+  AtomSet small;
+  small.insert(ap1);
+
+  Query* q1 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), small);
+  Answer* a1 = new Answer(q1);
+  a1->addTuple(Tuple(1,Term("i1")));
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q1,a1)));
+
+  // {pc(q1,i1),pc(q1,i2),pc(q1,i3)} yields i1, i2, i3, and i4
+  AtomSet large(small);
+  large.insert(ap2);
+  large.insert(ap3);
+
+  Query* q2 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), large);
+  Answer* a2 = new Answer(q2);
+  a2->addTuple(Tuple(1,Term("i1")));
+  a2->addTuple(Tuple(1,Term("i2")));
+  a2->addTuple(Tuple(1,Term("i3")));
+  a2->addTuple(Tuple(1,Term("i4")));
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q2,a2)));
+
+  // {pc(q1,i1),pc(q1,i2)} lies in between, so only i2, i3, and i4
+  // are left to the reasoner
+  AtomSet middle(small);
+  middle.insert(ap2);
+
+  Query* q3 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), middle);
+  QueryCtx::shared_pointer qctx3(new QueryCtx(q3, new Answer(q3)));
+
+  std::set<Tuple> lower, upper;
+
+  CPPUNIT_ASSERT(cache->cacheHit(qctx3) == QueryCtx::shared_pointer());
+  CPPUNIT_ASSERT(cache->bounds(qctx3, lower, upper));
+  CPPUNIT_ASSERT(lower.size() == 1);
+  CPPUNIT_ASSERT(upper.size() == 4);
+
+  // {pc(q1,i1),pc(q1,i2)} turned out to yield i1 only
+  qctx3->getAnswer().addTuple(Tuple(1,Term("i1")));
+  cache->insert(qctx3);
+
+  // and so does {}
+  Query* q4 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), AtomSet());
+  Answer* a4 = new Answer(q4);
+  a4->addTuple(Tuple(1,Term("i1")));
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q4,a4)));
+
+  // {pc(q1,i2)} lies in between, where both bounds coincide
+  AtomSet single;
+  single.insert(ap2);
+
+  Query* q5 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), single);
+  QueryCtx::shared_pointer qctx5(new QueryCtx(q5, new Answer(q5)));
+
+  // contains() only looks
+  CPPUNIT_ASSERT(cache->contains(qctx5));
+  CPPUNIT_ASSERT(qctx5->getAnswer().size() == 0);
+
+  CPPUNIT_ASSERT(cache->cacheHit(qctx5) == qctx5);
+  CPPUNIT_ASSERT(qctx5->getAnswer().size() == 1);
+
+  // but {pc(q1,i3)} is only bounded by {} and the large set
+  AtomSet other;
+  other.insert(ap3);
+
+  Query* q6 = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), other);
+  QueryCtx::shared_pointer qctx6(new QueryCtx(q6, new Answer(q6)));
+
+  lower.clear();
+  upper.clear();
+  CPPUNIT_ASSERT(cache->cacheHit(qctx6) == QueryCtx::shared_pointer());
+  CPPUNIT_ASSERT(cache->bounds(qctx6, lower, upper));
+  CPPUNIT_ASSERT(lower.size() == 1);
+  CPPUNIT_ASSERT(upper.size() == 4);
+}
+
+
+
+void
+TestCache::runBudgetCache()
+{
+  KBManager kb("DEFAULT");
+
+  Tuple out(1,Term("X"));
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  Term("q1"),
+					  out
+					  )
+			      );
+
+  // {pc(q1,in)} yields in, for n = 0, ..., 9
+  std::vector<QueryCtx::shared_pointer> qctxs;
+
+  for (unsigned n = 0; n < 10; ++n)
+    {
+      std::ostringstream oss;
+      oss << "i" << n;
+
+      AtomSet ints;
+      ints.insert(AtomPtr(new Atom("pc(q1," + oss.str() + ")")));
+
+      Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+      Answer* a = new Answer(q);
+      a->addTuple(Tuple(1,Term(oss.str())));
+      qctxs.push_back(QueryCtx::shared_pointer(new QueryCtx(q,a)));
+    }
+
+  cache->setAdmission(false);
+
+  cache->insert(qctxs[0], 1000);
+  unsigned long bytes = stats->bytes();
+  CPPUNIT_ASSERT(bytes > 0);
+
+  // room for three queries
+  cache->setBudget(3 * bytes);
+
+  // the first query is expensive and popular
+  CPPUNIT_ASSERT(cache->cacheHit(qctxs[0]) == qctxs[0]);
+
+  for (unsigned n = 1; n < 10; ++n)
+    {
+      cache->insert(qctxs[n], 1);
+      CPPUNIT_ASSERT(stats->bytes() <= 3 * bytes);
+    }
+
+  CPPUNIT_ASSERT(stats->qctxno() == 3);
+  CPPUNIT_ASSERT(stats->evict() == 7);
+  CPPUNIT_ASSERT(cache->cacheHit(qctxs[0]) == qctxs[0]);
+  CPPUNIT_ASSERT(cache->cacheHit(qctxs[9]) == qctxs[9]);
+
+  // with admission, a query asked once does not replace a popular one
+  cache->setAdmission(true);
+
+  AtomSet ints;
+  ints.insert(AtomPtr(new Atom("pc(q1,i42)")));
+
+  Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  QueryCtx::shared_pointer once(new QueryCtx(q, new Answer(q)));
+
+  for (unsigned n = 0; n < 3; ++n)
+    {
+      for (std::vector<QueryCtx::shared_pointer>::const_iterator it = qctxs.begin();
+	   it != qctxs.end(); ++it)
+	{
+	  cache->cacheHit(*it);
+	}
+    }
+
+  CPPUNIT_ASSERT(cache->cacheHit(once) == QueryCtx::shared_pointer());
+  cache->insert(once, 1);
+
+  CPPUNIT_ASSERT(stats->evict() == 7);
+  CPPUNIT_ASSERT(cache->cacheHit(once) == QueryCtx::shared_pointer());
+}
+
+
+void
+TestCache::runBudgetBookkeeping()
+{
+  KBManager kb("DEFAULT");
+
+  AtomSet ints;
+  ints.insert(AtomPtr(new Atom("pc(q1,a)")));
+
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop), Term("q1"), Tuple(1,Term("a"))));
+  Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  Answer* a = new Answer(q);
+  a->setAnswer(true);
+  QueryCtx::shared_pointer qctx(new QueryCtx(q,a));
+
+  cache->setAdmission(false);
+  cache->insert(qctx, 10);
+
+  // the boolean query and the instance of its retrieval query
+  CPPUNIT_ASSERT(stats->dlqno() == 2);
+
+  unsigned long bytes = stats->bytes();
+
+  // the burst and the consistency count as well
+  CPPUNIT_ASSERT(!cache->promote(qctx));
+  cache->insertConsistency(qctx, true);
+  CPPUNIT_ASSERT(stats->bytes() > bytes);
+
+  bool consistent = false;
+  CPPUNIT_ASSERT(cache->consistency(qctx, consistent));
+
+  // evicting the query drops its instance, and the rest of the
+  // bookkeeping goes once no query is left
+  cache->setBudget(1);
+
+  CPPUNIT_ASSERT(stats->evict() == 1);
+  CPPUNIT_ASSERT(stats->dlqno() == 0);
+  CPPUNIT_ASSERT(stats->bytes() == 0);
+  CPPUNIT_ASSERT(!cache->consistency(qctx, consistent));
+}
+
+
+void
+TestCache::runPersistentCache()
+{
+  KBManager kb("DEFAULT");
+  std::string file = "test-dlcache.tmp";
+  std::remove(file.c_str());
+
+  Tuple out(1,Term("X"));
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  Term("q1"),
+					  out
+					  )
+			      );
+
+  AtomSet ints;
+  ints.insert(AtomPtr(new Atom("pc(q1,i1)")));
+
+  {
+    CacheStore store(file);
+    cache->setStore(&store);
+
+    Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+    Answer* a = new Answer(q);
+    a->addTuple(Tuple(1,Term("i1")));
+    a->addTuple(Tuple(1,Term(42)));
+    cache->insert(QueryCtx::shared_pointer(new QueryCtx(q,a)));
+
+    CPPUNIT_ASSERT(store.size() == 1);
+    cache->setStore(0);
+  }
+
+  // a fresh cache of the next run answers from the file
+  CacheStats s;
+  Cache c(s);
+  CacheStore store(file);
+  c.setStore(&store);
+
+  CPPUNIT_ASSERT(store.size() == 1);
+
+  Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  QueryCtx::shared_pointer qctx(new QueryCtx(q, new Answer(q)));
+
+  CPPUNIT_ASSERT(c.cacheHit(qctx) == qctx);
+  CPPUNIT_ASSERT(s.hits() == 1);
+  CPPUNIT_ASSERT(qctx->getAnswer().size() == 2);
+  CPPUNIT_ASSERT(qctx->getAnswer().find(Tuple(1,Term("i1"))) != qctx->getAnswer().end());
+  CPPUNIT_ASSERT(qctx->getAnswer().find(Tuple(1,Term(42))) != qctx->getAnswer().end());
+
+  // another interpretation is not in the file
+  AtomSet ints2;
+  ints2.insert(AtomPtr(new Atom("pc(q1,i2)")));
+  q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints2);
+  CPPUNIT_ASSERT(!c.cacheHit(QueryCtx::shared_pointer(new QueryCtx(q, new Answer(q)))));
+
+  std::remove(file.c_str());
+}
+
+
+void
+TestCache::runConsistencyCache()
+{
+  KBManager kb("DEFAULT");
+
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  Term(" "),
+					  Tuple()
+					  )
+			      );
+
+  const char* atoms[] = { "pc(q1,a)", "pc(q1,b)", "pc(q1,c)", "pc(q1,d)" };
+  std::vector<QueryCtx::shared_pointer> qctxs;
+
+  // the subsets {a}, {a,b}, {b}, {b,c}, {c}, {b,c,d} of atoms
+  const char* subsets[] = { "a", "ab", "b", "bc", "c", "bcd" };
+
+  for (unsigned n = 0; n < 6; ++n)
+    {
+      AtomSet ints;
+
+      for (const char* c = subsets[n]; *c; ++c)
+	{
+	  ints.insert(AtomPtr(new Atom(atoms[*c - 'a'])));
+	}
+
+      Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+      qctxs.push_back(QueryCtx::shared_pointer(new QueryCtx(q, new Answer(q))));
+    }
+
+  bool consistent;
+
+  CPPUNIT_ASSERT(!cache->consistency(qctxs[0], consistent));
+
+  // {a} is inconsistent, so is {a,b}
+  cache->insertConsistency(qctxs[0], false);
+  CPPUNIT_ASSERT(cache->consistency(qctxs[1], consistent) && !consistent);
+  CPPUNIT_ASSERT(!cache->consistency(qctxs[2], consistent));
+
+  // {b,c} is consistent, so are {b} and {c}
+  cache->insertConsistency(qctxs[3], true);
+  CPPUNIT_ASSERT(cache->consistency(qctxs[2], consistent) && consistent);
+  CPPUNIT_ASSERT(cache->consistency(qctxs[4], consistent) && consistent);
+  CPPUNIT_ASSERT(!cache->consistency(qctxs[5], consistent));
+
+  // {b,c,d} is consistent, too, and replaces {b,c}
+  cache->insertConsistency(qctxs[5], true);
+  CPPUNIT_ASSERT(cache->consistency(qctxs[3], consistent) && consistent);
+  CPPUNIT_ASSERT(cache->consistency(qctxs[0], consistent) && !consistent);
+}
+
+
+void
+TestCache::runCrossModeCache()
+{
+  KBManager kb("DEFAULT");
+  Ontology::shared_pointer onto = Ontology::createOntology(shop);
+  const std::string& ns = onto->getNamespace();
+
+  AtomSet ints;
+  ints.insert(AtomPtr(new Atom("pc(q1,a)")));
+
+  // q1(X) yields a and b
+  DLQuery::shared_pointer rq(new DLQuery(onto, Term("q1"), Tuple(1,Term("X"))));
+  Query* q = new Query(kb, rq, Term("pc"),Term(""),Term(""),Term(""), ints);
+  Answer* a = new Answer(q);
+  a->addTuple(Tuple(1,Term("\"<" + ns + "a>\"")));
+  a->addTuple(Tuple(1,Term("\"<" + ns + "b>\"")));
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q,a)));
+
+  // hence q1(a) holds and q1(c) does not
+  DLQuery::shared_pointer ba(new DLQuery(onto, Term("q1"), Tuple(1,Term("a"))));
+  q = new Query(kb, ba, Term("pc"),Term(""),Term(""),Term(""), ints);
+  QueryCtx::shared_pointer qa(new QueryCtx(q, new Answer(q)));
+
+  CPPUNIT_ASSERT(cache->cacheHit(qa) == qa);
+  CPPUNIT_ASSERT(qa->getAnswer().getAnswer());
+
+  DLQuery::shared_pointer bc(new DLQuery(onto, Term("q1"), Tuple(1,Term("c"))));
+  q = new Query(kb, bc, Term("pc"),Term(""),Term(""),Term(""), ints);
+  QueryCtx::shared_pointer qc(new QueryCtx(q, new Answer(q)));
+
+  CPPUNIT_ASSERT(cache->cacheHit(qc) == qc);
+  CPPUNIT_ASSERT(!qc->getAnswer().getAnswer());
+
+  // q1(c) holds for a larger input, which narrows q1(X) for that input
+  AtomSet ints2(ints);
+  ints2.insert(AtomPtr(new Atom("pc(q1,b)")));
+
+  q = new Query(kb, bc, Term("pc"),Term(""),Term(""),Term(""), ints2);
+  a = new Answer(q);
+  a->setAnswer(true);
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q,a)));
+
+  q = new Query(kb, rq, Term("pc"),Term(""),Term(""),Term(""), ints2);
+  QueryCtx::shared_pointer qr(new QueryCtx(q, new Answer(q)));
+
+  std::set<Tuple> lower, upper;
+  CPPUNIT_ASSERT(!cache->bounds(qr, lower, upper));
+  CPPUNIT_ASSERT(lower.size() == 3);
+}
+
+
+void
+TestCache::runPromotion()
+{
+  KBManager kb("DEFAULT");
+  Ontology::shared_pointer onto = Ontology::createOntology(shop);
+
+  AtomSet ints;
+  ints.insert(AtomPtr(new Atom("pc(q1,a)")));
+
+  const char* individuals[] = { "a", "b", "c", "d" };
+  std::vector<QueryCtx::shared_pointer> qctxs;
+
+  for (unsigned n = 0; n < 4; ++n)
+    {
+      DLQuery::shared_pointer dlq(new DLQuery(onto, Term("q1"), Tuple(1,Term(individuals[n]))));
+      Query* q = new Query(kb, dlq, Term("pc"),Term(""),Term(""),Term(""), ints);
+      qctxs.push_back(QueryCtx::shared_pointer(new QueryCtx(q, new Answer(q))));
+    }
+
+  // as long as we know no costs, the third query of a burst retrieves
+  CPPUNIT_ASSERT(!cache->promote(qctxs[0]));
+  CPPUNIT_ASSERT(!cache->promote(qctxs[1]));
+
+  DLQuery::shared_pointer rf = cache->promote(qctxs[2]);
+
+  CPPUNIT_ASSERT(rf);
+  CPPUNIT_ASSERT(rf->isRetrieval());
+
+  // and the burst starts over
+  CPPUNIT_ASSERT(!cache->promote(qctxs[3]));
+
+  // a retrieval which costs as much as ten boolean queries
+  AtomSet ints2(ints);
+  ints2.insert(AtomPtr(new Atom("pc(q1,b)")));
+
+  Query* q = new Query(kb, qctxs[0]->getQuery().getDLQuery(), Term("pc"),Term(""),Term(""),Term(""), ints2);
+  Answer* a = new Answer(q);
+  a->setAnswer(true);
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q,a)), 100);
+
+  q = new Query(kb, rf, Term("pc"),Term(""),Term(""),Term(""), ints2);
+  cache->insert(QueryCtx::shared_pointer(new QueryCtx(q, new Answer(q))), 1000);
+
+  AtomSet ints3(ints2);
+  ints3.insert(AtomPtr(new Atom("pc(q1,c)")));
+
+  q = new Query(kb, qctxs[1]->getQuery().getDLQuery(), Term("pc"),Term(""),Term(""),Term(""), ints3);
+  QueryCtx::shared_pointer qb(new QueryCtx(q, new Answer(q)));
+
+  for (unsigned n = 1; n < 10; ++n)
+    {
+      CPPUNIT_ASSERT(!cache->promote(qb));
+    }
+
+  CPPUNIT_ASSERT(cache->promote(qb));
+}
+
+
+void
+TestCache::runSymbolTable()
+{
+  ComfortTerm a = ComfortTerm::createConstant("\"<http://www.test.com/test#a>\"");
+  ComfortTerm b = ComfortTerm::createConstant("\"<http://www.test.com/test#runSymbolTable>\"");
+  ComfortTerm one = ComfortTerm::createInteger(1);
+  ComfortTerm quotedOne = ComfortTerm::createConstant("1");
+
+  unsigned id;
+  CPPUNIT_ASSERT(!SymbolTable::find(b, id));
+
+  unsigned ida = SymbolTable::intern(a);
+  unsigned idb = SymbolTable::intern(b);
+
+  CPPUNIT_ASSERT(ida != idb);
+  CPPUNIT_ASSERT(SymbolTable::intern(a) == ida);
+  CPPUNIT_ASSERT(SymbolTable::find(b, id) && id == idb);
+  CPPUNIT_ASSERT(SymbolTable::getTerm(ida) == a);
+
+  // integers and strings never share an ID
+  CPPUNIT_ASSERT(SymbolTable::intern(one) != SymbolTable::intern(quotedOne));
+  CPPUNIT_ASSERT(SymbolTable::getTerm(SymbolTable::intern(one)).isInteger());
+
+  // the keys of an interpretation are the negation flag and the term IDs of its atoms
+  ComfortTerm c = ComfortTerm::createConstant("\"<http://www.test.com/test#runSymbolTableC>\"");
+  ComfortTuple args;
+  args.push_back(a);
+  args.push_back(c);
+
+  ComfortInterpretation ints;
+  ints.insert(ComfortAtom("pr", args));
+
+  std::vector<SymbolTable::AtomKey> keys;
+  SymbolTable::intern(ints, keys);
+
+  CPPUNIT_ASSERT(keys.size() == 1 && keys[0].size() == 4);
+  CPPUNIT_ASSERT(keys[0][0] == 0 && keys[0][2] == ida);
+  CPPUNIT_ASSERT(SymbolTable::find(c, id) && id == keys[0][3]);
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
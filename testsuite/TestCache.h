@@ -62,6 +62,16 @@ namespace test {
     CPPUNIT_TEST_SUITE(TestCache);
     CPPUNIT_TEST(runBooleanCache);
     CPPUNIT_TEST(runNonBooleanCache);
+    CPPUNIT_TEST(runSubsumptionCache);
+    CPPUNIT_TEST(runCanonicalQuery);
+    CPPUNIT_TEST(runBoundedCache);
+    CPPUNIT_TEST(runBudgetCache);
+    CPPUNIT_TEST(runBudgetBookkeeping);
+    CPPUNIT_TEST(runPersistentCache);
+    CPPUNIT_TEST(runConsistencyCache);
+    CPPUNIT_TEST(runCrossModeCache);
+    CPPUNIT_TEST(runPromotion);
+    CPPUNIT_TEST(runSymbolTable);
     CPPUNIT_TEST_SUITE_END();
 
     CacheStats* stats;
@@ -76,6 +86,26 @@ namespace test {
     void runBooleanCache();    
 
     void runNonBooleanCache();    
+
+    void runSubsumptionCache();
+
+    void runCanonicalQuery();
+
+    void runBoundedCache();
+
+    void runBudgetCache();
+
+    void runBudgetBookkeeping();
+
+    void runPersistentCache();
+
+    void runConsistencyCache();
+
+    void runCrossModeCache();
+
+    void runPromotion();
+
+    void runSymbolTable();
   };
 
 } // namespace test
@@ -31,6 +31,8 @@
  */
 
 #include "OWLParser.h"
+#include "OntologySnapshot.h"
+#include "OntologyLoader.h"
 
 #include "TestOWLParser.h"
 
@@ -38,6 +40,7 @@
 #include <string>
 #include <functional>
 #include <iterator>
+#include <cstdio>
 
 using namespace dlvhex::dl::test;
 using dlvhex::dl::OWLParser;
@@ -86,6 +89,156 @@ TestOWLParser::runParserTest()
 }
 
 
+void
+TestOWLParser::runSinglePassTest()
+{
+  OWLParser p(shop);
+
+  std::string ns1;
+  TBox tbox1;
+  ABox abox1;
+  p.parseNamespace(ns1);
+  p.parseTBox(tbox1);
+  p.parseABox(abox1);
+
+  // a single pass yields the same as one pass each
+  std::string ns2;
+  TBox tbox2;
+  ABox abox2;
+  p.parseOntology(ns2, tbox2, abox2);
+
+  CPPUNIT_ASSERT(ns1 == ns2);
+  CPPUNIT_ASSERT(*tbox1.getConcepts() == *tbox2.getConcepts());
+  CPPUNIT_ASSERT(*tbox1.getRoles() == *tbox2.getRoles());
+  CPPUNIT_ASSERT(*abox1.getIndividuals() == *abox2.getIndividuals());
+}
+
+
+void
+TestOWLParser::runSnapshotTest()
+{
+  Ontology::shared_pointer onto = Ontology::createOntology(shop);
+
+  const char* file = "TestOWLParser.snapshot";
+  OntologySnapshot::write(file, *onto, onto->getTBox(), onto->getABox(), onto->getImports());
+
+  OntologySnapshot snap(file);
+  CPPUNIT_ASSERT(snap.isValid());
+  CPPUNIT_ASSERT(snap.getPath() == onto->getURI().getPath());
+  CPPUNIT_ASSERT(snap.getFingerprint() == onto->getFingerprint());
+  CPPUNIT_ASSERT(snap.getContentHash() == onto->getContentHash());
+  CPPUNIT_ASSERT(snap.getNamespace() == onto->getNamespace());
+
+  TBox tbox;
+  ABox abox;
+  std::vector<std::string> imports;
+  snap.getTBox(tbox);
+  snap.getABox(abox);
+  snap.getImports(imports);
+
+  CPPUNIT_ASSERT(*tbox.getConcepts() == *onto->getTBox().getConcepts());
+  CPPUNIT_ASSERT(*tbox.getRoles() == *onto->getTBox().getRoles());
+  CPPUNIT_ASSERT(*tbox.getDatatypeRoles() == *onto->getTBox().getDatatypeRoles());
+  CPPUNIT_ASSERT(*abox.getIndividuals() == *onto->getABox().getIndividuals());
+  CPPUNIT_ASSERT(imports == onto->getImports());
+
+  std::remove(file);
+
+  // a broken snapshot is ignored
+  std::FILE* f = std::fopen(file, "w");
+  std::fputs("garbage", f);
+  std::fclose(f);
+
+  CPPUNIT_ASSERT(!OntologySnapshot(file).isValid());
+
+  std::remove(file);
+}
+
+
+void
+TestOWLParser::runSyntaxTest()
+{
+  const char* files[] = { "TestOWLParser.nt", "TestOWLParser" };
+
+  for (unsigned i = 0; i < sizeof(files) / sizeof(files[0]); ++i)
+    {
+      // N-Triples, selected by the extension first and by sniffing then
+      std::FILE* f = std::fopen(files[i], "w");
+      std::fputs("<http://www.test.com/test#C> "
+		 "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+		 "<http://www.w3.org/2002/07/owl#Class> .\n"
+		 "<http://www.test.com/test#a> "
+		 "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+		 "<http://www.test.com/test#C> .\n"
+		 "<http://www.test.com/test#b> "
+		 "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+		 "<http://www.w3.org/2002/07/owl#Thing> .\n"
+		 "<http://www.test.com/test#a> "
+		 "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+		 "<http://www.test.com/test#C> .\n", f);
+      std::fclose(f);
+
+      OWLParser p(URI(files[i], true));
+      TBox tbox;
+      ABox abox;
+      std::string ns;
+      p.parseOntology(ns, tbox, abox);
+
+      std::remove(files[i]);
+
+      CPPUNIT_ASSERT(tbox.getConcepts()->size() == 1);
+      CPPUNIT_ASSERT(tbox.getConcepts()->begin()->strval == "http://www.test.com/test#C");
+
+      // duplicate triples yield one individual
+      CPPUNIT_ASSERT(abox.getIndividuals()->size() == 2);
+      CPPUNIT_ASSERT(abox.getIndividuals()->count(ComfortTerm::createConstant("\"<http://www.test.com/test#a>\"")) == 1);
+      CPPUNIT_ASSERT(abox.getIndividuals()->count(ComfortTerm::createConstant("\"<http://www.test.com/test#b>\"")) == 1);
+    }
+}
+
+
+void
+TestOWLParser::runImportsTest()
+{
+  const std::string a = URI("TestOWLParserA.nt", true).getString();
+  const std::string b = URI("TestOWLParserB.nt", true).getString();
+
+  // A imports B, and B imports A again
+  std::FILE* f = std::fopen("TestOWLParserA.nt", "w");
+  std::fprintf(f,
+	       "<http://www.test.com/a> <http://www.w3.org/2002/07/owl#imports> <%s> .\n"
+	       "<http://www.test.com/a#x> "
+	       "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+	       "<http://www.w3.org/2002/07/owl#Thing> .\n", b.c_str());
+  std::fclose(f);
+
+  f = std::fopen("TestOWLParserB.nt", "w");
+  std::fprintf(f,
+	       "<http://www.test.com/b> <http://www.w3.org/2002/07/owl#imports> <%s> .\n"
+	       "<http://www.test.com/b#y> "
+	       "<http://www.w3.org/1999/02/22-rdf-syntax-ns#type> "
+	       "<http://www.w3.org/2002/07/owl#Thing> .\n", a.c_str());
+  std::fclose(f);
+
+  OntologyLoader loader;
+  loader.add("TestOWLParserA.nt");
+  const OntologyLoader::Ontologies& ontos = loader.load(2);
+
+  std::remove("TestOWLParserA.nt");
+  std::remove("TestOWLParserB.nt");
+
+  // each document is loaded once
+  CPPUNIT_ASSERT(loader.getErrors().empty());
+  CPPUNIT_ASSERT(ontos.size() == 2);
+
+  for (OntologyLoader::Ontologies::const_iterator it = ontos.begin(); it != ontos.end(); ++it)
+    {
+      CPPUNIT_ASSERT((*it)->getImports().size() == 1);
+      CPPUNIT_ASSERT((*it)->getABox().getIndividuals()->size() == 1);
+    }
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
@@ -55,10 +55,22 @@ namespace test {
   {
     CPPUNIT_TEST_SUITE(TestOWLParser);
     CPPUNIT_TEST(runParserTest);
+    CPPUNIT_TEST(runSinglePassTest);
+    CPPUNIT_TEST(runSnapshotTest);
+    CPPUNIT_TEST(runSyntaxTest);
+    CPPUNIT_TEST(runImportsTest);
     CPPUNIT_TEST_SUITE_END();
 
   public:
     void runParserTest();
+
+    void runSinglePassTest();
+
+    void runSnapshotTest();
+
+    void runSyntaxTest();
+
+    void runImportsTest();
   };
 
 } // namespace test
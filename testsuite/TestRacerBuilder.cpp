@@ -113,6 +113,196 @@ TestRacerBuilder::runRacerPosPairBuilderTest()
   CPPUNIT_ASSERT(s == "(state (add-role-assertion DEFAULT |http://www.kr.tuwien.ac.at/staff/roman/shop#nic| |http://www.kr.tuwien.ac.at/staff/roman/shop#sic| |http://www.kr.tuwien.ac.at/staff/roman/shop#Part|))\n");
 }
 
+void
+TestRacerBuilder::runRacerSessionBuilderTest()
+{
+  std::stringstream sst;
+
+  ComfortInterpretation ints;
+  RacerKBManager kb(sst, "DEFAULT");
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  ComfortTerm::createConstant("Part"),
+					  ComfortTuple()));
+  ComfortTerm empty = ComfortTerm::createConstant("");
+  Query q(kb,dlq,empty,empty,empty,empty,ints);
+
+  RacerFullResetBuilder frb(sst);
+  RacerOpenOWLBuilder oob(sst);
+  RacerImportOntologiesBuilder iob(sst);
+
+  // a fresh session resets RACER exactly once
+  CPPUNIT_ASSERT(frb.buildCommand(q));
+  CPPUNIT_ASSERT(sst.str() == "(full-reset)\n");
+  CPPUNIT_ASSERT(!frb.buildCommand(q));
+
+  // the ontology is read once per session
+  sst.str("");
+  CPPUNIT_ASSERT(oob.buildCommand(q));
+  CPPUNIT_ASSERT(iob.buildCommand(q));
+  CPPUNIT_ASSERT(!sst.str().empty());
+
+  sst.str("");
+  CPPUNIT_ASSERT(!oob.buildCommand(q));
+  CPPUNIT_ASSERT(!iob.buildCommand(q));
+  CPPUNIT_ASSERT(sst.str().empty());
+
+  // after an inconsistency or a failure we start over
+  kb.invalidateSession();
+  CPPUNIT_ASSERT(frb.buildCommand(q));
+  CPPUNIT_ASSERT(oob.buildCommand(q));
+  CPPUNIT_ASSERT(iob.buildCommand(q));
+}
+
+
+namespace {
+
+  /// @return plusC(Part,indv)
+  dlvhex::ComfortAtom
+  partAtom(const std::string& indv)
+  {
+    dlvhex::ComfortTuple args;
+    args.push_back(dlvhex::ComfortTerm::createConstant("Part"));
+    args.push_back(dlvhex::ComfortTerm::createConstant(indv));
+    return dlvhex::ComfortAtom("plusC", args);
+  }
+
+} // anonymous namespace
+
+
+void
+TestRacerBuilder::runRacerABoxDeltaBuilderTest()
+{
+  std::stringstream sst;
+
+  const std::string part = "|http://www.kr.tuwien.ac.at/staff/roman/shop#Part|";
+  const std::string shopns = "|http://www.kr.tuwien.ac.at/staff/roman/shop#";
+
+  RacerKBManager kb(sst, "DEFAULT");
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  ComfortTerm::createConstant("Part"),
+					  ComfortTuple()));
+  ComfortTerm plusC = ComfortTerm::createConstant("plusC");
+  ComfortTerm empty = ComfortTerm::createConstant("");
+
+  ComfortInterpretation ints1;
+  ints1.insert(partAtom("nic"));
+
+  ComfortInterpretation ints2(ints1);
+  ints2.insert(partAtom("sic"));
+
+  ComfortInterpretation ints3(ints1);
+  ints3.insert(partAtom("tic"));
+
+  ComfortInterpretation ints4;
+  ints4.insert(partAtom("foo"));
+
+  Query q1(kb,dlq,plusC,empty,empty,empty,ints1);
+  Query q2(kb,dlq,plusC,empty,empty,empty,ints2);
+  Query q3(kb,dlq,plusC,empty,empty,empty,ints3);
+  Query q4(kb,dlq,plusC,empty,empty,empty,ints4);
+
+  RacerCloneABoxBuilder cab(sst);
+  RacerStateBuilder sb(sst);
+
+  // the first query clones the ABox and sends the whole interpretation
+  CPPUNIT_ASSERT(cab.buildCommand(q1));
+  sst.str("");
+  CPPUNIT_ASSERT(sb.buildCommand(q1));
+  CPPUNIT_ASSERT(sst.str() == "(state (add-concept-assertion DEFAULT " + shopns + "nic| " + part + "))\n");
+
+  // a growing interpretation only sends the new assertions
+  sst.str("");
+  CPPUNIT_ASSERT(!cab.buildCommand(q2));
+  CPPUNIT_ASSERT(sb.buildCommand(q2));
+  CPPUNIT_ASSERT(sst.str() == "(state (add-concept-assertion DEFAULT " + shopns + "sic| " + part + "))\n");
+
+  // nothing changed
+  sst.str("");
+  CPPUNIT_ASSERT(!cab.buildCommand(q2));
+  CPPUNIT_ASSERT(!sb.buildCommand(q2));
+  CPPUNIT_ASSERT(sst.str().empty());
+
+  // retract what is gone, add what is new
+  CPPUNIT_ASSERT(!cab.buildCommand(q3));
+  CPPUNIT_ASSERT(sb.buildCommand(q3));
+  CPPUNIT_ASSERT(sst.str() == "(state (forget-concept-assertion DEFAULT " + shopns + "sic| " + part + ") "
+		 "(add-concept-assertion DEFAULT " + shopns + "tic| " + part + "))\n");
+
+  // the delta is larger than the interpretation -> fresh clone
+  CPPUNIT_ASSERT(cab.buildCommand(q4));
+  sst.str("");
+  CPPUNIT_ASSERT(sb.buildCommand(q4));
+  CPPUNIT_ASSERT(sst.str() == "(state (add-concept-assertion DEFAULT " + shopns + "foo| " + part + "))\n");
+
+  // after an inconsistency or a failure we start over
+  kb.invalidateSession();
+  CPPUNIT_ASSERT(cab.buildCommand(q4));
+}
+
+
+void
+TestRacerBuilder::runRacerABoxPoolBuilderTest()
+{
+  std::stringstream sst;
+
+  RacerKBManager kb(sst, "DEFAULT");
+  kb.setMaxWorkingABoxes(2);
+
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  ComfortTerm::createConstant("Part"),
+					  ComfortTuple()));
+  ComfortTerm plusC = ComfortTerm::createConstant("plusC");
+  ComfortTerm empty = ComfortTerm::createConstant("");
+
+  ComfortInterpretation ints1;
+  ints1.insert(partAtom("nic"));
+
+  ComfortInterpretation ints2(ints1);
+  ints2.insert(partAtom("sic"));
+
+  ComfortInterpretation ints3;
+
+  Query q1(kb,dlq,plusC,empty,empty,empty,ints1);
+  Query q2(kb,dlq,plusC,empty,empty,empty,ints2);
+  Query q3(kb,dlq,plusC,empty,empty,empty,ints3);
+
+  RacerCloneABoxBuilder cab(sst);
+  RacerStateBuilder sb(sst);
+
+  // each interpretation gets its own ABox while the pool is not full
+  CPPUNIT_ASSERT(cab.buildCommand(q1));
+  CPPUNIT_ASSERT(sb.buildCommand(q1));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT");
+
+  sst.str("");
+  CPPUNIT_ASSERT(cab.buildCommand(q3));
+  CPPUNIT_ASSERT(sst.str().find(":new-name DEFAULT-1 ") != std::string::npos);
+  CPPUNIT_ASSERT(sb.buildCommand(q3));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT-1");
+
+  // revisiting an interpretation sends nothing
+  sst.str("");
+  CPPUNIT_ASSERT(!cab.buildCommand(q1));
+  CPPUNIT_ASSERT(!sb.buildCommand(q1));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT");
+
+  CPPUNIT_ASSERT(!cab.buildCommand(q3));
+  CPPUNIT_ASSERT(!sb.buildCommand(q3));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT-1");
+  CPPUNIT_ASSERT(sst.str().empty());
+
+  // a new interpretation recycles the least recently used ABox
+  CPPUNIT_ASSERT(!cab.buildCommand(q2));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT");
+  CPPUNIT_ASSERT(sb.buildCommand(q2));
+  CPPUNIT_ASSERT(sst.str() == "(state (add-concept-assertion DEFAULT |http://www.kr.tuwien.ac.at/staff/roman/shop#sic| |http://www.kr.tuwien.ac.at/staff/roman/shop#Part|))\n");
+
+  // and q1 is gone
+  sst.str("");
+  CPPUNIT_ASSERT(cab.buildCommand(q1));
+  CPPUNIT_ASSERT(kb.getKBName() == "DEFAULT-1");
+}
+
 
 // Local Variables:
 // mode: C++
@@ -58,6 +58,9 @@ namespace test {
     CPPUNIT_TEST(runRacerPosIndBuilderTest);
     CPPUNIT_TEST(runRacerNegIndBuilderTest);
     CPPUNIT_TEST(runRacerPosPairBuilderTest);
+    CPPUNIT_TEST(runRacerSessionBuilderTest);
+    CPPUNIT_TEST(runRacerABoxDeltaBuilderTest);
+    CPPUNIT_TEST(runRacerABoxPoolBuilderTest);
     CPPUNIT_TEST_SUITE_END();
 
   public: 
@@ -66,6 +69,12 @@ namespace test {
     void runRacerNegIndBuilderTest();
     
     void runRacerPosPairBuilderTest();
+
+    void runRacerSessionBuilderTest();
+
+    void runRacerABoxDeltaBuilderTest();
+
+    void runRacerABoxPoolBuilderTest();
   };
 
 } // namespace test
@@ -39,6 +39,8 @@
 #include "Query.h"
 #include "RacerKBManager.h"
 #include "Answer.h"
+#include "Registry.h"
+#include "Cache.h"
 
 #include <iostream>
 #include <string>
@@ -104,6 +106,93 @@ TestRacerDirector::runRacerAllIndividualsTest()
   output(*tv);
 }
 
+void
+TestRacerDirector::runRacerPipelineTest()
+{
+  TCPIOStream rsIO("localhost", 8088);
+  RacerKBManager kb(rsIO, "DEFAULT");
+  DLQuery::shared_pointer dlq(new DLQuery(Ontology::createOntology(shop),
+					  ComfortTerm::createConstant("Part"),
+					  ComfortTuple()));
+  ComfortTerm empty = ComfortTerm::createConstant("");
+
+  QueryCompositeDirector comp(rsIO);
+  comp.add(new QueryDirector<RacerFullResetBuilder,RacerIgnoreAnswer>(rsIO));
+  comp.add(new QueryDirector<RacerOpenOWLBuilder,RacerIgnoreAnswer>(rsIO));
+  comp.add(new QueryDirector<RacerFunAdapterBuilder<RacerAllIndividualsCmd>,RacerAnswerDriver>(rsIO));
+
+  unsigned flags = Registry::getFlags();
+
+  // one round trip per command
+  Registry::setFlags(flags & ~Registry::PIPELINE);
+  QueryCtx::shared_pointer q1(new QueryCtx(new Query(kb,dlq,empty,empty,empty,empty,
+						     ComfortInterpretation()),
+					   new Answer(0))
+			      );
+  CPPUNIT_ASSERT_NO_THROW( q1 = comp.query(q1) );
+
+  // all commands in one round trip
+  kb.invalidateSession();
+  Registry::setFlags(flags | Registry::PIPELINE);
+  QueryCtx::shared_pointer q2(new QueryCtx(new Query(kb,dlq,empty,empty,empty,empty,
+						     ComfortInterpretation()),
+					   new Answer(0))
+			      );
+  CPPUNIT_ASSERT_NO_THROW( q2 = comp.query(q2) );
+
+  Registry::setFlags(flags);
+
+  const std::set<ComfortTuple>& a1 = q1->getAnswer();
+  const std::set<ComfortTuple>& a2 = q2->getAnswer();
+
+  CPPUNIT_ASSERT(a1.size() > 0);
+  CPPUNIT_ASSERT(a1 == a2);
+}
+
+
+void
+TestRacerDirector::runRacerCoalesceTest()
+{
+  TCPIOStream rsIO("localhost", 8088);
+  RacerKBManager kb(rsIO, "DEFAULT");
+  Ontology::shared_pointer shopOnto = Ontology::createOntology(shop);
+  ComfortTuple out(1, ComfortTerm::createVariable("X"));
+  DLQuery::shared_pointer part(new DLQuery(shopOnto, ComfortTerm::createConstant("Part"), out));
+  DLQuery::shared_pointer shopq(new DLQuery(shopOnto, ComfortTerm::createConstant("Shop"), out));
+  ComfortTerm empty = ComfortTerm::createConstant("");
+
+  CacheStats stats;
+  Cache cache(stats);
+
+  QueryCompositeDirector::shared_pointer comp(new QueryCompositeDirector(rsIO));
+  comp->add(new QueryDirector<RacerFullResetBuilder,RacerIgnoreAnswer>(rsIO));
+  comp->add(new QueryDirector<RacerOpenOWLBuilder,RacerIgnoreAnswer>(rsIO));
+  comp->add(new QueryDirector<RacerConceptInstancesBuilder,RacerAnswerDriver>(rsIO));
+
+  Query* q = new Query(kb,part,empty,empty,empty,empty,ComfortInterpretation());
+  QueryCtx::shared_pointer q1(new QueryCtx(q, new Answer(q)));
+
+  Query* s = new Query(shopq, *q);
+  QueryCtx::shared_pointer q2(new QueryCtx(s, new Answer(s)));
+
+  QueryCoalescingDirector coal(cache, comp);
+  coal.add(q2, QueryBaseDirector::shared_pointer
+	   (new QueryDirector<RacerConceptInstancesBuilder,RacerAnswerDriver>(rsIO)));
+
+  CPPUNIT_ASSERT(!cache.contains(q2));
+  CPPUNIT_ASSERT_NO_THROW( q1 = coal.query(q1) );
+
+  // the sibling has been answered and cached along with the query,
+  // and looking it up does not count as a cache miss
+  CPPUNIT_ASSERT(stats.miss() == 1);
+  CPPUNIT_ASSERT(cache.contains(q1));
+  CPPUNIT_ASSERT(cache.contains(q2));
+  CPPUNIT_ASSERT(stats.miss() == 1);
+
+  CPPUNIT_ASSERT(q1->getAnswer().size() > 0);
+  CPPUNIT_ASSERT(q2->getAnswer().size() > 0);
+}
+
 
 // Local Variables:
 // mode: C++
@@ -56,12 +56,18 @@ namespace test {
     CPPUNIT_TEST_SUITE(TestRacerDirector);
     CPPUNIT_TEST(runRacerPlusConceptTest);
     CPPUNIT_TEST(runRacerAllIndividualsTest);
+    CPPUNIT_TEST(runRacerPipelineTest);
+    CPPUNIT_TEST(runRacerCoalesceTest);
     CPPUNIT_TEST_SUITE_END();
 
   public:
     void runRacerPlusConceptTest();
     
     void runRacerAllIndividualsTest();
+
+    void runRacerPipelineTest();
+
+    void runRacerCoalesceTest();
   };
 
 } // namespace test
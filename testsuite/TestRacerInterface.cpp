@@ -31,6 +31,7 @@
  */
 
 #include "RacerInterface.h"
+#include "PreloadConverter.h"
 
 #include "TestRacerInterface.h"
 
@@ -477,6 +478,25 @@ TestRacerInterface::runRacerConjQueryTest()
   
   output(*ans1.getTuples());
 }
+void
+TestRacerInterface::runPreloadScanTest()
+{
+  std::string program =
+    "% &dlC[\"commented.owl\",a,b,c,d,\"C\"](X)\n"
+    "p(\"&dlC[\\\"quoted.owl\\\"]\").\n"
+    "wine(X) :- &dlC[\"wine.rdf\",a,b,c,d,\"Wine\"](X).\n"
+    "r(X,Y) :- &dlR [ \"shop.owl\",a,b,c,d,\"provides\"](X,Y), &dlCQ2[\"wine.rdf\",a,b,c,d,\"q(X,Y)\"](X,Y).\n"
+    "q :- &other[\"other.owl\"].\n";
+
+  std::vector<std::string> uris;
+  PreloadConverter::scan(program, uris);
+
+  CPPUNIT_ASSERT(uris.size() == 2);
+  CPPUNIT_ASSERT(uris[0] == "wine.rdf");
+  CPPUNIT_ASSERT(uris[1] == "shop.owl");
+}
+
+
 #if 0
 void
 TestRacerInterface::runGetUniverseTest()
@@ -62,6 +62,7 @@ namespace test {
     CPPUNIT_TEST(runRacerRoleFillersTest);
     CPPUNIT_TEST(runRacerDatatypeRoleFillersTest);
     CPPUNIT_TEST(runRacerConjQueryTest);
+    CPPUNIT_TEST(runPreloadScanTest);
     CPPUNIT_TEST_SUITE_END();
 
   public: 
@@ -82,6 +83,8 @@ namespace test {
     void runRacerDatatypeRoleFillersTest();
 
     void runRacerConjQueryTest();
+
+    void runPreloadScanTest();
   };
 
 } // namespace test
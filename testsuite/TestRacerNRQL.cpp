@@ -34,6 +34,7 @@
 
 #include "KBManager.h"
 #include "RacerNRQL.h"
+#include "RacerNRQLBuilder.h"
 #include "Query.h"
 
 #include <sstream>
@@ -123,6 +124,76 @@ TestRacerNRQL::runRacerPremiseRetrieveTest()
 }
 
 
+void
+TestRacerNRQL::runRacerPremiseConceptRoleTest()
+{
+  std::stringstream sst;
+
+  const std::string ns = "http://www.test.com/test#";
+
+  ComfortTuple args;
+  args.push_back(ComfortTerm::createConstant("foo"));
+  args.push_back(ComfortTerm::createConstant("a"));
+
+  ComfortInterpretation ints;
+  ints.insert(ComfortAtom("pc", args));
+
+  ComfortTerm pc = ComfortTerm::createConstant("pc");
+  ComfortTerm empty = ComfortTerm::createConstant("");
+
+  URI u(testuri, true); // absolute pathname
+  const std::string premise = "(retrieve-under-premise ((instance |" + ns + "a| |" + ns + "foo|)) ";
+  const std::string abox = " :abox |" + u.getString() + "|)";
+
+  KBManager kb("DEFAULT");
+
+  // concept retrieval
+  ComfortTuple tup1;
+  tup1.push_back(ComfortTerm::createVariable("X"));
+
+  DLQuery::shared_pointer dlq1(new DLQuery(Ontology::createOntology(test),
+					   ComfortTerm::createConstant("-foo"),
+					   tup1));
+  Query q1(kb,dlq1,pc,empty,empty,empty,ints);
+
+  sst << NRQLRetrieveUnderPremise<NRQLConceptRoleBuilder>(q1);
+  CPPUNIT_ASSERT(sst.str() == premise + "($?X) ($?X (not |" + ns + "foo|))" + abox);
+
+  // boolean role query
+  ComfortTuple tup2;
+  tup2.push_back(ComfortTerm::createConstant("a"));
+  tup2.push_back(ComfortTerm::createConstant("b"));
+
+  DLQuery::shared_pointer dlq2(new DLQuery(Ontology::createOntology(test),
+					   ComfortTerm::createConstant("moo"),
+					   tup2));
+  Query q2(kb,dlq2,pc,empty,empty,empty,ints);
+
+  sst.str("");
+  sst << NRQLRetrieveUnderPremise<NRQLConceptRoleBuilder>(q2);
+  CPPUNIT_ASSERT(sst.str() == premise + "() (|" + ns + "a| |" + ns + "b| |" + ns + "moo|)" + abox);
+
+  // mixed role query
+  ComfortTuple tup3;
+  tup3.push_back(ComfortTerm::createConstant("a"));
+  tup3.push_back(ComfortTerm::createVariable("Y"));
+
+  DLQuery::shared_pointer dlq3(new DLQuery(Ontology::createOntology(test),
+					   ComfortTerm::createConstant("moo"),
+					   tup3));
+  Query q3(kb,dlq3,pc,empty,empty,empty,ints);
+
+  sst.str("");
+  sst << NRQLRetrieveUnderPremise<NRQLConceptRoleBuilder>(q3);
+  CPPUNIT_ASSERT(sst.str() == premise + "($?Y) (|" + ns + "a| $?Y |" + ns + "moo|)" + abox);
+
+  // consistency check
+  sst.str("");
+  sst << NRQLRetrieveUnderPremise<NRQLConsistencyBuilder>(q3);
+  CPPUNIT_ASSERT(sst.str() == premise + "() (true-query)" + abox);
+}
+
+
 // Local Variables:
 // mode: C++
 // End:
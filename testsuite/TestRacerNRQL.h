@@ -57,6 +57,7 @@ namespace test {
     CPPUNIT_TEST(runRacerRetrieveTest);
     CPPUNIT_TEST(runRacerTBoxRetrieveTest);
     CPPUNIT_TEST(runRacerPremiseRetrieveTest);
+    CPPUNIT_TEST(runRacerPremiseConceptRoleTest);
     CPPUNIT_TEST_SUITE_END();
 
   public: 
@@ -65,6 +66,8 @@ namespace test {
     void runRacerTBoxRetrieveTest();
 
     void runRacerPremiseRetrieveTest();
+
+    void runRacerPremiseConceptRoleTest();
   };
 
 } // namespace test
@@ -172,6 +172,34 @@ TestRacerParse::runRacerAnswerListTest()
   }
 }
 
+void
+TestRacerParse::runRacerGrammarReuseTest()
+{
+  // the grammar is shared between the parses, make sure every answer
+  // ends up in its own Answer object, even after a failed parse
+  std::istringstream ss1(":answer 1 \"(|file://foobar#myfoo1|)\" \"\"\n");
+  std::istringstream ss2(":error 1 Illegal syntax: help \"foo\"\n");
+  std::istringstream ss3(":answer 1 \"(|file://foobar#myfoo2| |file://foobar#myfoo3|)\" \"\"\n");
+
+  Answer a1(0);
+  Answer a2(0);
+  Answer a3(0);
+
+  RacerAnswerDriver d1(ss1);
+  CPPUNIT_ASSERT_NO_THROW( d1.parse(a1) );
+
+  RacerAnswerDriver d2(ss2);
+  CPPUNIT_ASSERT_THROW( d2.parse(a2), dlvhex::dl::DLParsingError );
+
+  RacerAnswerDriver d3(ss3);
+  CPPUNIT_ASSERT_NO_THROW( d3.parse(a3) );
+
+  CPPUNIT_ASSERT(a1.getTuples()->size() == 1);
+  CPPUNIT_ASSERT(a2.getTuples()->empty());
+  CPPUNIT_ASSERT(a3.getTuples()->size() == 2);
+  CPPUNIT_ASSERT((*a3.getTuples())[0][0].getUnquotedString() == std::string("<file://foobar#myfoo2>"));
+}
+
 
 // Local Variables:
 // mode: C++
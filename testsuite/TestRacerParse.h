@@ -57,6 +57,7 @@ namespace test {
     CPPUNIT_TEST(runRacerErrorTest);
     CPPUNIT_TEST(runRacerSimpleAnswerTest);
     CPPUNIT_TEST(runRacerAnswerListTest);
+    CPPUNIT_TEST(runRacerGrammarReuseTest);
     CPPUNIT_TEST_SUITE_END();
 
   public:
@@ -65,6 +66,8 @@ namespace test {
     void runRacerAnswerListTest();    
 
     void runRacerErrorTest();    
+
+    void runRacerGrammarReuseTest();
   };
 
 } // namespace test
@@ -0,0 +1,123 @@
+/* dlvhex-dlplugin -- Integration of Answer-Set Programming and Description Logics.
+ *
+ * Copyright (C) 2005, 2006, 2007  Thomas Krennwallner
+ * 
+ * This file is part of dlvhex-dlplugin.
+ *
+ * dlvhex-dlplugin is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * dlvhex-dlplugin is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dlvhex-dlplugin; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+
+/**
+ * @file   TestRacerPool.cpp
+ * @author Thomas Krennwallner
+ * @date   Sat Oct 17 11:02:45 2026
+ * 
+ * @brief  TestCases for RacerPool.
+ * 
+ * 
+ */
+
+#include "TestRacerPool.h"
+#include "RacerPool.h"
+#include "KBManager.h"
+#include "Ontology.h"
+#include "URI.h"
+
+#include <string>
+
+
+using namespace dlvhex::dl;
+using namespace dlvhex::dl::racer;
+using namespace dlvhex::dl::test;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION(TestRacerPool);
+
+
+void
+TestRacerPool::runRacerPoolLeaseTest()
+{
+  // backends connect lazily, so we don't need running RACER servers
+  RacerPool pool;
+  pool.addBackend("localhost", 8088);
+  pool.addBackend("localhost", 8089);
+
+  CPPUNIT_ASSERT(pool.size() == 2);
+
+  RacerPool::Backend& b1 = pool.acquire(Ontology::shared_pointer());
+  RacerPool::Backend& b2 = pool.acquire(Ontology::shared_pointer());
+
+  // each backend has its own connection and temporary ABox
+  CPPUNIT_ASSERT(&b1 != &b2);
+  CPPUNIT_ASSERT(b1.stream != b2.stream);
+  CPPUNIT_ASSERT(b1.kbManager->getKBName() != b2.kbManager->getKBName());
+
+  pool.release(b1);
+
+  RacerPool::Backend& b3 = pool.acquire(Ontology::shared_pointer());
+  CPPUNIT_ASSERT(&b1 == &b3);
+
+  pool.release(b3);
+  pool.release(b2);
+
+  RacerPool empty;
+  CPPUNIT_ASSERT_THROW(empty.acquire(Ontology::shared_pointer()), DLError);
+}
+
+
+void
+TestRacerPool::runRacerPoolAffinityTest()
+{
+  RacerPool pool;
+  pool.addBackend("localhost", 8088);
+  pool.addBackend("localhost", 8089);
+
+  Ontology::shared_pointer onto = Ontology::createOntology(shop);
+  std::string kbname = "<" + onto->getRealURI().getString() + ">";
+
+  RacerPool::Backend& b1 = pool.acquire(onto);
+  RacerPool::Backend& b2 = pool.acquire(onto);
+
+  // pretend that the second backend has loaded the ontology
+  b2.kbManager->addOpenKB(kbname, onto->getFingerprint());
+
+  pool.release(b1);
+  pool.release(b2);
+
+  // prefer the backend which holds the ontology
+  {
+    RacerPool::Lease l(pool, onto);
+    CPPUNIT_ASSERT(&l.getKBManager() == b2.kbManager);
+
+    // but use any other backend if it is busy
+    RacerPool::Lease l2(pool, onto);
+    CPPUNIT_ASSERT(&l2.getKBManager() == b1.kbManager);
+  }
+
+  // after an invalidated session, there is no preference anymore
+  b2.kbManager->invalidateSession();
+
+  {
+    RacerPool::Lease l(pool, onto);
+    CPPUNIT_ASSERT(&l.getKBManager() == b1.kbManager);
+  }
+}
+
+
+// Local Variables:
+// mode: C++
+// End:
@@ -35,6 +35,10 @@
 #include "TestRacerStream.h"
 
 #include <iosfwd>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <ios>
 
 using namespace dlvhex::util;
 using namespace dlvhex::dl::test;
@@ -82,6 +86,81 @@ TestRacerStream::runRacerIOStreamTest()
   CPPUNIT_ASSERT(answ.find("answer") != std::string::npos);
 }
 
+void
+TestRacerStream::runRacerCorkedStreamTest()
+{
+  TCPIOStream rsIO("localhost", 8088);
+  rsIO.setTimeout(10000);
+
+  TCPStreamBuf* rsb = dynamic_cast<TCPStreamBuf*>(rsIO.rdbuf());
+
+  // send both commands at once
+  rsb->cork(true);
+  rsIO << "(all-individuals)" << std::endl;
+  rsIO << "(all-individuals)" << std::endl;
+  rsb->cork(false);
+  rsIO.flush();
+
+  CPPUNIT_ASSERT(! rsIO.fail());
+
+  // and receive one answer after the other
+  std::string a1((std::istreambuf_iterator<char>(rsIO)), std::istreambuf_iterator<char>());
+  std::string a2((std::istreambuf_iterator<char>(rsIO)), std::istreambuf_iterator<char>());
+
+  CPPUNIT_ASSERT(a1.find("answer") != std::string::npos);
+  CPPUNIT_ASSERT(a2.find("answer") != std::string::npos);
+
+  // switching connections keeps the old one alive
+  rsIO.setConnection("localhost", 8089);
+  rsIO.setConnection("localhost", 8088);
+
+  CPPUNIT_ASSERT(rsIO.isOpen());
+}
+
+void
+TestRacerStream::runRacerSessionTest()
+{
+  const char* session = "TestRacerStream.session";
+
+  std::string recorded;
+
+  {
+    TCPIOStream rsIO("localhost", 8088);
+    rsIO.setSession(session, TCPIOStream::RECORD);
+
+    rsIO << "(all-individuals)" << std::endl;
+    recorded.assign((std::istreambuf_iterator<char>(rsIO)), std::istreambuf_iterator<char>());
+
+    CPPUNIT_ASSERT(recorded.find("answer") != std::string::npos);
+  }
+
+  // replay without RACER, pretend to talk to a host which is not there
+  TCPIOStream rsIO("localhost", 1);
+  rsIO.setSession(session, TCPIOStream::REPLAY);
+
+  // the command is split differently, but the stream is the same
+  rsIO << "(all-" << std::flush << "individuals)" << std::endl;
+  std::string replayed((std::istreambuf_iterator<char>(rsIO)), std::istreambuf_iterator<char>());
+
+  CPPUNIT_ASSERT(replayed == recorded);
+
+  // an unrecorded command diverges from the session
+  bool diverged = false;
+
+  try
+    {
+      rsIO << "(all-concepts)" << std::endl;
+    }
+  catch (std::ios_base::failure&)
+    {
+      diverged = true;
+    }
+
+  CPPUNIT_ASSERT(diverged);
+
+  std::remove(session);
+}
+
 
 // Local Variables:
 // mode: C++
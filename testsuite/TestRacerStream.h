@@ -57,12 +57,18 @@ namespace test {
     CPPUNIT_TEST_SUITE(TestRacerStream);
     CPPUNIT_TEST(runRacerStreamBufTest);
     CPPUNIT_TEST(runRacerIOStreamTest);
+    CPPUNIT_TEST(runRacerCorkedStreamTest);
+    CPPUNIT_TEST(runRacerSessionTest);
     CPPUNIT_TEST_SUITE_END();
 
   public:
     void runRacerStreamBufTest();   
 
     void runRacerIOStreamTest();   
+
+    void runRacerCorkedStreamTest();
+
+    void runRacerSessionTest();
   };
 
 } // namespace test